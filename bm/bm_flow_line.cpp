@@ -0,0 +1,73 @@
+#include <ryml.hpp>
+#include <ryml_std.hpp>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+namespace bm = benchmark;
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** minified json, ie the whole document is in a single line. The
+ * number of top-level entries is given by the benchmark argument, so
+ * the line length grows with it; a parser whose cost per scalar is
+ * bounded by the scalar length (rather than by the line length) shows
+ * flat throughput across all the sizes. */
+std::string make_minified_json(size_t num_entries)
+{
+    std::string s;
+    s += '{';
+    for(size_t i = 0; i < num_entries; ++i)
+    {
+        if(i)
+            s += ',';
+        std::string n = std::to_string(i);
+        s += "\"key" + n + "\":[" + n + ",\"val" + n + "\",{\"x\":" + n + ",\"y\":true}]";
+    }
+    s += '}';
+    return s;
+}
+
+void ryml_minified_json_ro(bm::State& st)
+{
+    std::string json = make_minified_json(static_cast<size_t>(st.range(0)));
+    c4::csubstr src = c4::to_csubstr(json);
+    size_t sz = 0;
+    for(auto _ : st)
+    {
+        ryml::Tree tree = ryml::parse(src);
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * json.size());
+}
+
+void ryml_minified_json_rw_reuse(bm::State& st)
+{
+    std::string json = make_minified_json(static_cast<size_t>(st.range(0)));
+    std::string in_place = json;
+    ryml::Parser parser;
+    ryml::Tree tree;
+    size_t sz = 0;
+    for(auto _ : st)
+    {
+        st.PauseTiming();
+        in_place.assign(json);
+        tree.clear();
+        tree.clear_arena();
+        st.ResumeTiming();
+        parser.parse({}, c4::to_substr(in_place), &tree);
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * json.size());
+}
+
+BENCHMARK(ryml_minified_json_ro)->RangeMultiplier(4)->Range(1<<6, 1<<16);
+BENCHMARK(ryml_minified_json_rw_reuse)->RangeMultiplier(4)->Range(1<<6, 1<<16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,102 @@
+#include <ryml.hpp>
+#include <ryml_std.hpp>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+namespace bm = benchmark;
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** a stream of many small documents, like a bundle of manifests */
+std::string make_doc_stream(size_t num_docs)
+{
+    std::string s;
+    for(size_t i = 0; i < num_docs; ++i)
+    {
+        std::string n = std::to_string(i);
+        s += "---\nkind: Service\nmetadata:\n  name: svc" + n + "\n  labels: {app: app" + n + ", tier: backend}\n"
+             "spec:\n  ports:\n    - port: 80\n      targetPort: " + n + "\n  selector:\n    app: app" + n + "\n";
+    }
+    return s;
+}
+
+void ryml_stream_serial(bm::State& st)
+{
+    std::string yaml = make_doc_stream(4096);
+    c4::csubstr src = c4::to_csubstr(yaml);
+    size_t sz = 0;
+    for(auto _ : st)
+    {
+        ryml::Tree tree = ryml::parse(src);
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * yaml.size());
+}
+
+void ryml_stream_parallel(bm::State& st)
+{
+    std::string yaml = make_doc_stream(4096);
+    c4::csubstr src = c4::to_csubstr(yaml);
+    size_t sz = 0;
+    for(auto _ : st)
+    {
+        ryml::Tree tree = ryml::parse_parallel(src, static_cast<size_t>(st.range(0)));
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * yaml.size());
+}
+
+/** a single document with a big top-level map */
+std::string make_big_map(size_t num_entries)
+{
+    std::string s;
+    for(size_t i = 0; i < num_entries; ++i)
+    {
+        std::string n = std::to_string(i);
+        s += "svc" + n + ":\n  labels: {app: app" + n + ", tier: backend}\n"
+             "  ports:\n    - port: 80\n      targetPort: " + n + "\n  selector:\n    app: app" + n + "\n";
+    }
+    return s;
+}
+
+void ryml_map_serial(bm::State& st)
+{
+    std::string yaml = make_big_map(4096);
+    c4::csubstr src = c4::to_csubstr(yaml);
+    size_t sz = 0;
+    for(auto _ : st)
+    {
+        ryml::Tree tree = ryml::parse(src);
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * yaml.size());
+}
+
+void ryml_map_parallel_entries(bm::State& st)
+{
+    std::string yaml = make_big_map(4096);
+    c4::csubstr src = c4::to_csubstr(yaml);
+    size_t sz = 0;
+    for(auto _ : st)
+    {
+        ryml::Tree tree = ryml::parse_parallel_entries(src, static_cast<size_t>(st.range(0)));
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * yaml.size());
+}
+
+BENCHMARK(ryml_stream_serial)->UseRealTime();
+BENCHMARK(ryml_stream_parallel)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(ryml_map_serial)->UseRealTime();
+BENCHMARK(ryml_map_parallel_entries)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -339,6 +339,105 @@ void ryml_rw_reuse(bm::State& st)
     st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
 }
 
+void ryml_rw_reuse_lazy(bm::State& st)
+{
+    size_t sz = 0;
+    c4::substr src = c4::to_substr(s_bm_case->in_place);
+    s_bm_case->ryml_parser.set_lazy_filtering(true);
+    for(auto _ : st)
+    {
+        s_bm_case->prepare(st, kResetInPlace|kClearTree|kClearTreeArena);
+        s_bm_case->ryml_parser.parse(s_bm_case->filename, src, &s_bm_case->ryml_tree);
+        sz = s_bm_case->ryml_tree.size();
+    }
+    s_bm_case->ryml_parser.set_lazy_filtering(false);
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
+}
+
+void ryml_json_ro(bm::State& st)
+{
+    size_t sz = 0;
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    for(auto _ : st)
+    {
+        ONLY_FOR_JSON;
+        ryml::Tree tree = ryml::parse_json(s_bm_case->filename, src);
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
+}
+
+void ryml_json_rw(bm::State& st)
+{
+    size_t sz = 0;
+    c4::substr src = c4::to_substr(s_bm_case->in_place);
+    for(auto _ : st)
+    {
+        ONLY_FOR_JSON;
+        s_bm_case->prepare(st, kResetInPlace);
+        ryml::Tree tree = ryml::parse_json(s_bm_case->filename, src);
+        sz = tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
+}
+
+void ryml_json_ro_reuse(bm::State& st)
+{
+    size_t sz = 0;
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    for(auto _ : st)
+    {
+        ONLY_FOR_JSON;
+        s_bm_case->prepare(st, kClearTree|kClearTreeArena);
+        s_bm_case->ryml_parser.parse_json(s_bm_case->filename, src, &s_bm_case->ryml_tree);
+        sz = s_bm_case->ryml_tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
+}
+
+void ryml_json_rw_reuse(bm::State& st)
+{
+    size_t sz = 0;
+    c4::substr src = c4::to_substr(s_bm_case->in_place);
+    for(auto _ : st)
+    {
+        ONLY_FOR_JSON;
+        s_bm_case->prepare(st, kResetInPlace|kClearTree|kClearTreeArena);
+        s_bm_case->ryml_parser.parse_json(s_bm_case->filename, src, &s_bm_case->ryml_tree);
+        sz = s_bm_case->ryml_tree.size();
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
+}
+
+/** counts the scalars, to measure parsing without building a tree */
+struct ScalarCounter : public ryml::EventHandler
+{
+    size_t count = 0;
+    void key(c4::csubstr, bool) override { ++count; }
+    void scalar(c4::csubstr, bool) override { ++count; }
+};
+
+void ryml_json_events(bm::State& st)
+{
+    size_t sz = 0;
+    c4::substr src = c4::to_substr(s_bm_case->in_place);
+    for(auto _ : st)
+    {
+        ONLY_FOR_JSON;
+        s_bm_case->prepare(st, kResetInPlace);
+        ScalarCounter counter;
+        s_bm_case->ryml_parser.parse_json(s_bm_case->filename, src, &counter);
+        sz = counter.count;
+    }
+    st.SetItemsProcessed(st.iterations() * sz);
+    st.SetBytesProcessed(st.iterations() * s_bm_case->src.size());
+}
+
 BENCHMARK(rapidjson_ro);
 BENCHMARK(rapidjson_rw);
 BENCHMARK(sajson_rw);
@@ -352,6 +451,12 @@ BENCHMARK(ryml_ro);
 BENCHMARK(ryml_rw);
 BENCHMARK(ryml_ro_reuse);
 BENCHMARK(ryml_rw_reuse);
+BENCHMARK(ryml_rw_reuse_lazy);
+BENCHMARK(ryml_json_ro);
+BENCHMARK(ryml_json_rw);
+BENCHMARK(ryml_json_ro_reuse);
+BENCHMARK(ryml_json_rw_reuse);
+BENCHMARK(ryml_json_events);
 
 #if defined(_MSC_VER)
 #   pragma warning(pop)
@@ -0,0 +1,61 @@
+#include <ryml.hpp>
+#include <ryml_std.hpp>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+namespace bm = benchmark;
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** a config-like document, with no anchors, tags, complex keys or directives */
+std::string make_config(size_t num_entries)
+{
+    std::string s;
+    for(size_t i = 0; i < num_entries; ++i)
+    {
+        std::string n = std::to_string(i);
+        s += "svc" + n + ":\n  name: 'service " + n + "'\n  labels: {app: app" + n + ", tier: backend}\n"
+             "  ports:\n    - port: 80\n      targetPort: " + n + "\n    - [443, https]\n"
+             "  env:\n    - name: HOME\n      value: \"/home/svc" + n + "\"\n";
+    }
+    return s;
+}
+
+/** the restrictions are checked at runtime, so this measures their
+ * overhead rather than a speedup */
+void ryml_parse(bm::State& st, size_t restrictions)
+{
+    std::string yaml = make_config(4096);
+    c4::csubstr src = c4::to_csubstr(yaml);
+    ryml::Parser parser;
+    parser.set_restrictions(restrictions);
+    ryml::Tree tree;
+    for(auto _ : st)
+    {
+        tree.clear();
+        tree.clear_arena();
+        parser.parse({}, src, &tree);
+    }
+    st.SetItemsProcessed(st.iterations() * tree.size());
+    st.SetBytesProcessed(st.iterations() * yaml.size());
+}
+
+void ryml_parse_unrestricted(bm::State& st)
+{
+    ryml_parse(st, 0);
+}
+
+void ryml_parse_checking_restrictions(bm::State& st)
+{
+    ryml_parse(st, ryml::NO_ANCHORS|ryml::NO_TAGS|ryml::NO_COMPLEX_KEYS|ryml::NO_DIRECTIVES);
+}
+
+BENCHMARK(ryml_parse_unrestricted);
+BENCHMARK(ryml_parse_checking_restrictions);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+#include <ryml_std.hpp>
+#include <ryml.hpp>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+namespace bm = benchmark;
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** a wide map of maps: traversals and lookups visit many siblings */
+std::string make_wide(size_t num_entries)
+{
+    std::string s;
+    for(size_t i = 0; i < num_entries; ++i)
+    {
+        std::string n = std::to_string(i);
+        s += "key" + n + ": {name: entry" + n + ", value: " + n + ", enabled: true}\n";
+    }
+    return s;
+}
+
+struct WideTree
+{
+    std::string yaml;
+    ryml::Tree tree;
+    WideTree(size_t num_entries) : yaml(make_wide(num_entries)), tree(ryml::parse(ryml::to_csubstr(yaml))) {}
+};
+
+WideTree const& wide_tree()
+{
+    static const WideTree w(65536);
+    return w;
+}
+
+
+//-----------------------------------------------------------------------------
+
+void ryml_num_children(bm::State& st)
+{
+    ryml::Tree const& t = wide_tree().tree;
+    size_t count = 0;
+    for(auto _ : st)
+    {
+        count = t.num_children(t.root_id());
+        bm::DoNotOptimize(count);
+    }
+    st.SetItemsProcessed(st.iterations() * count);
+}
+
+void find_child(bm::State& st, ryml::Tree const& t)
+{
+    const size_t num = t.num_children(t.root_id());
+    // look up keys spread through the map
+    std::string keys[8];
+    for(size_t i = 0; i < 8; ++i)
+        keys[i] = "key" + std::to_string((2 * i + 1) * num / 16);
+    for(auto _ : st)
+    {
+        for(std::string const& k : keys)
+        {
+            size_t ch = t.find_child(t.root_id(), ryml::to_csubstr(k));
+            bm::DoNotOptimize(ch);
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * 8);
+}
+
+void ryml_find_child(bm::State& st)
+{
+    find_child(st, wide_tree().tree);
+}
+
+void ryml_find_child_indexed(bm::State& st)
+{
+    ryml::Tree t = wide_tree().tree;
+    t.set_map_index(true);
+    find_child(st, t);
+}
+
+/** build a wide map by key, as with a registry: each insertion
+ * first looks up the key */
+void ryml_build_by_key(bm::State& st)
+{
+    const bool indexed = st.range(0) != 0;
+    const size_t num = 16384;
+    std::string keys;
+    for(size_t i = 0; i < num; ++i)
+        keys += "key" + std::to_string(i) + ' ';
+    for(auto _ : st)
+    {
+        ryml::Tree t;
+        t.set_map_index(indexed);
+        ryml::NodeRef root = t.rootref();
+        root |= ryml::MAP;
+        c4::csubstr ks = ryml::to_csubstr(keys);
+        for(size_t pos = 0; pos < ks.len; )
+        {
+            size_t end = ks.find(' ', pos);
+            root[ks.range(pos, end)] = "x";
+            pos = end + 1;
+        }
+        bm::DoNotOptimize(t.size());
+    }
+    st.SetItemsProcessed(st.iterations() * num);
+}
+
+void ryml_visit(bm::State& st)
+{
+    ryml::Tree const& t = wide_tree().tree;
+    size_t count = 0;
+    for(auto _ : st)
+    {
+        count = 0;
+        t.rootref().visit([&count](ryml::NodeRef const*, size_t) {
+            ++count;
+            return false;
+        });
+        bm::DoNotOptimize(count);
+    }
+    st.SetItemsProcessed(st.iterations() * count);
+}
+
+void ryml_emit(bm::State& st)
+{
+    ryml::Tree const& t = wide_tree().tree;
+    std::string out;
+    for(auto _ : st)
+    {
+        ryml::emitrs(t, &out);
+        bm::DoNotOptimize(out.data());
+    }
+    st.SetItemsProcessed(st.iterations() * t.size());
+    st.SetBytesProcessed(st.iterations() * out.size());
+}
+
+BENCHMARK(ryml_num_children);
+BENCHMARK(ryml_find_child);
+BENCHMARK(ryml_find_child_indexed);
+BENCHMARK(ryml_build_by_key)->Arg(0)->Arg(1);
+BENCHMARK(ryml_visit);
+BENCHMARK(ryml_emit);
+
+BENCHMARK_MAIN();
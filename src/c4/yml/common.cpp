@@ -13,7 +13,7 @@ namespace yml {
 static_assert(std::is_same<std::underlying_type<decltype(npos)>::type, size_t>::value, "invalid type");
 static_assert(std::is_same<std::underlying_type<decltype(NONE)>::type, size_t>::value, "invalid type");
 static_assert(size_t(npos) == ((size_t)-1), "invalid value"); // some debuggers show the wrong value...
-static_assert(size_t(NONE) == ((size_t)-1), "invalid value"); // some debuggers show the wrong value...
+static_assert(size_t(NONE) == ((size_t)id_type(-1)), "invalid value"); // some debuggers show the wrong value...
 
 
 #ifndef RYML_NO_DEFAULT_CALLBACKS
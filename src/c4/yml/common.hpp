@@ -2,6 +2,8 @@
 #define _C4_YML_COMMON_HPP_
 
 #include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <c4/substr.hpp>
 #include <c4/yml/export.hpp>
 
@@ -14,6 +16,25 @@
 #endif
 
 
+/** @def RYML_ID_TYPE the unsigned integral type used to store the
+ * links between the nodes of a tree (parent, children and siblings).
+ * Defaults to size_t. Define it (eg to uint32_t) when building ryml to
+ * make each node smaller, if no tree will need more nodes than the
+ * type can index. */
+#ifndef RYML_ID_TYPE
+#   define RYML_ID_TYPE size_t
+#endif
+
+
+/** @def RYML_MAP_INDEX_MIN_CHILDREN the number of children that
+ * find_child() walks in a map before building a hash index of the
+ * map's children, when the tree's map index is enabled. Smaller maps
+ * are never indexed. @see Tree::set_map_index() */
+#ifndef RYML_MAP_INDEX_MIN_CHILDREN
+#   define RYML_MAP_INDEX_MIN_CHILDREN 32
+#endif
+
+
 #if RYML_USE_ASSERT
 #   define RYML_ASSERT(cond) RYML_CHECK(cond)
 #   define RYML_ASSERT_MSG(cond, msg) RYML_CHECK_MSG(cond, msg)
@@ -50,11 +71,17 @@
 namespace c4 {
 namespace yml {
 
+/** the type used to store node ids. @see RYML_ID_TYPE */
+using id_type = RYML_ID_TYPE;
+static_assert(std::is_unsigned<id_type>::value && sizeof(id_type) <= sizeof(size_t), "RYML_ID_TYPE must be unsigned, and no wider than size_t");
+
 enum : size_t {
     /** a null position */
     npos = size_t(-1),
-    /** an index to none */
-    NONE = size_t(-1)
+    /** an index to none. This is the largest id_type, so that it is
+     * the same when stored in a link; it is npos when id_type is
+     * size_t. */
+    NONE = size_t(id_type(-1))
 };
 
 
@@ -0,0 +1,54 @@
+#ifndef _C4_YML_DETAIL_FILTER_HPP_
+#define _C4_YML_DETAIL_FILTER_HPP_
+
+/** @file filter.hpp The filters turning scanned scalars into their
+ * values: removing quotes and escapes, folding lines and stripping
+ * indentation. They work in place, as the filtered scalar is never
+ * longer than the scanned one, and they do not depend on the parser
+ * state, so they can also be run after parsing, when a raw scalar is
+ * first read (see Parser::set_lazy_filtering()). */
+
+#ifndef _C4_YML_COMMON_HPP_
+#include "../common.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+typedef enum {
+    BLOCK_LITERAL, //!< keep newlines (|)
+    BLOCK_FOLD     //!< replace newline with single space (>)
+} BlockStyle_e;
+
+typedef enum {
+    CHOMP_CLIP,    //!< single newline at end (default)
+    CHOMP_STRIP,   //!< no newline at end     (-)
+    CHOMP_KEEP     //!< all newlines from end (+)
+} BlockChomp_e;
+
+/** read the header of a block scalar, starting with | or >. The
+ * indentation is set to npos when it is not given.
+ * @return false if the indentation could not be read */
+RYML_EXPORT bool read_block_header(csubstr header, BlockStyle_e *style, BlockChomp_e *chomp, size_t *indentation);
+
+/** @p leading_whitespace when true, remove every leading spaces from the
+ * beginning of each line */
+RYML_EXPORT substr filter_whitespace(substr s, size_t indentation=0, bool leading_whitespace=true);
+
+RYML_EXPORT csubstr filter_plain_scalar(substr s, size_t indentation);
+RYML_EXPORT csubstr filter_squot_scalar(substr s);
+RYML_EXPORT csubstr filter_dquot_scalar(substr s);
+RYML_EXPORT csubstr filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e chomp, size_t indentation);
+
+/** filter a raw scalar, as kept by the parser when filtering lazily. A
+ * raw scalar carries what is needed to filter it: quoted scalars start
+ * with their opening quote, and block scalars with their header line;
+ * anything else is a multi-line plain scalar. */
+RYML_EXPORT csubstr filter_raw_scalar(substr raw);
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DETAIL_FILTER_HPP_ */
@@ -0,0 +1,257 @@
+#ifndef _C4_YML_DETAIL_JSON_HPP_
+#define _C4_YML_DETAIL_JSON_HPP_
+
+/** @file json.hpp Helpers shared by the json parsers. */
+
+#ifndef _C4_YML_TREE_HPP_
+#include "../tree.hpp"
+#endif
+
+#include <stdint.h>
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+C4_ALWAYS_INLINE bool is_json_ws(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/** whether the character ends a json literal (true, false, null or a number) */
+C4_ALWAYS_INLINE bool is_json_literal_end(char c)
+{
+    return c == ',' || c == ']' || c == '}' || is_json_ws(c);
+}
+
+inline bool is_json_number(csubstr s)
+{
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    size_t i = 0;
+    if(i < s.len && s.str[i] == '-')
+        ++i;
+    if(i >= s.len)
+        return false;
+    if(s.str[i] == '0')
+        ++i;
+    else if(s.str[i] >= '1' && s.str[i] <= '9')
+        while(i < s.len && s.str[i] >= '0' && s.str[i] <= '9')
+            ++i;
+    else
+        return false;
+    if(i < s.len && s.str[i] == '.')
+    {
+        const size_t d = ++i;
+        while(i < s.len && s.str[i] >= '0' && s.str[i] <= '9')
+            ++i;
+        if(i == d)
+            return false;
+    }
+    if(i < s.len && (s.str[i] == 'e' || s.str[i] == 'E'))
+    {
+        ++i;
+        if(i < s.len && (s.str[i] == '+' || s.str[i] == '-'))
+            ++i;
+        const size_t d = i;
+        while(i < s.len && s.str[i] >= '0' && s.str[i] <= '9')
+            ++i;
+        if(i == d)
+            return false;
+    }
+    return i == s.len;
+}
+
+inline bool is_json_literal(csubstr s)
+{
+    return s == "true" || s == "false" || s == "null" || is_json_number(s);
+}
+
+inline bool read_hex4(csubstr s, uint32_t *cp)
+{
+    if(s.len < 4)
+        return false;
+    uint32_t v = 0;
+    for(size_t i = 0; i < 4; ++i)
+    {
+        const char c = s.str[i];
+        v <<= 4u;
+        if(c >= '0' && c <= '9')
+            v |= static_cast<uint32_t>(c - '0');
+        else if(c >= 'a' && c <= 'f')
+            v |= static_cast<uint32_t>(c - 'a' + 10);
+        else if(c >= 'A' && c <= 'F')
+            v |= static_cast<uint32_t>(c - 'A' + 10);
+        else
+            return false;
+    }
+    *cp = v;
+    return true;
+}
+
+inline size_t encode_utf8(char *dst, uint32_t cp)
+{
+    if(cp < 0x80u)
+    {
+        dst[0] = static_cast<char>(cp);
+        return 1;
+    }
+    else if(cp < 0x800u)
+    {
+        dst[0] = static_cast<char>(0xc0u | (cp >> 6u));
+        dst[1] = static_cast<char>(0x80u | (cp & 0x3fu));
+        return 2;
+    }
+    else if(cp < 0x10000u)
+    {
+        dst[0] = static_cast<char>(0xe0u | (cp >> 12u));
+        dst[1] = static_cast<char>(0x80u | ((cp >> 6u) & 0x3fu));
+        dst[2] = static_cast<char>(0x80u | (cp & 0x3fu));
+        return 3;
+    }
+    dst[0] = static_cast<char>(0xf0u | (cp >> 18u));
+    dst[1] = static_cast<char>(0x80u | ((cp >> 12u) & 0x3fu));
+    dst[2] = static_cast<char>(0x80u | ((cp >> 6u) & 0x3fu));
+    dst[3] = static_cast<char>(0x80u | (cp & 0x3fu));
+    return 4;
+}
+
+/** filter the escapes of the contents of a json string in a single
+ * forward pass. The filtered string is never longer than the original
+ * (the longest expansion is \\uXXXX to 3 bytes, or a surrogate pair
+ * \\uXXXX\\uXXXX to 4 bytes), so this is done in place.
+ * @return the filtered string. On an invalid escape, @p err_pos is set
+ * to the offset of its backslash, and the string filtered so far is
+ * returned. */
+inline csubstr unescape_json_string(substr s, size_t *err_pos)
+{
+    *err_pos = npos;
+    size_t w = 0;
+    for(size_t r = 0; r < s.len; ++r)
+    {
+        char c = s.str[r];
+        if(c != '\\')
+        {
+            s.str[w++] = c;
+            continue;
+        }
+        if(r + 1 >= s.len)
+        {
+            *err_pos = r;
+            return s.first(w);
+        }
+        c = s.str[++r];
+        switch(c)
+        {
+        case '"':
+        case '\\':
+        case '/': s.str[w++] = c; break;
+        case 'b': s.str[w++] = '\b'; break;
+        case 'f': s.str[w++] = '\f'; break;
+        case 'n': s.str[w++] = '\n'; break;
+        case 'r': s.str[w++] = '\r'; break;
+        case 't': s.str[w++] = '\t'; break;
+        case 'u':
+        {
+            uint32_t cp = 0, lo = 0;
+            if( ! read_hex4(s.sub(r + 1), &cp))
+            {
+                *err_pos = r - 1;
+                return s.first(w);
+            }
+            r += 4;
+            // join a surrogate pair into a single code point
+            if(cp >= 0xd800u && cp <= 0xdbffu
+               && r + 2 < s.len && s.str[r + 1] == '\\' && s.str[r + 2] == 'u'
+               && read_hex4(s.sub(r + 3), &lo) && lo >= 0xdc00u && lo <= 0xdfffu)
+            {
+                cp = 0x10000u + ((cp - 0xd800u) << 10u) + (lo - 0xdc00u);
+                r += 6;
+            }
+            w += encode_utf8(s.str + w, cp);
+            break;
+        }
+        default:
+            *err_pos = r - 1;
+            return s.first(w);
+        }
+    }
+    return s.first(w);
+}
+
+
+//-----------------------------------------------------------------------------
+
+/** the json handler which builds the tree. This has the same callbacks
+ * as EventHandler, but they are statically dispatched. Scalars are
+ * stored as given, so they must outlive the tree. */
+struct JsonTreeBuilder
+{
+    Tree   *m_tree;
+    size_t  m_root_id;
+    size_t  m_curr;   ///< the container being filled, or NONE when at the top
+    csubstr m_key;
+
+    JsonTreeBuilder(Tree *t, size_t node_id) : m_tree(t), m_root_id(node_id), m_curr(NONE), m_key() {}
+
+    void begin_doc() {}
+    void end_doc() {}
+    void begin_map() { m_curr = _set_next(MAP); }
+    void end_map() { _close(); }
+    void begin_seq() { m_curr = _set_next(SEQ); }
+    void end_seq() { _close(); }
+    void key(csubstr k, bool /*quoted*/) { m_key = k; }
+    void scalar(csubstr s, bool quoted) { _set_next(VAL, s, quoted ? VALQUO : NOTYPE); }
+
+    void _close()
+    {
+        m_curr = m_curr == m_root_id ? NONE : m_tree->parent(m_curr);
+    }
+
+    /** add the next node (or take the root node if at the top) and set
+     * its type */
+    size_t _set_next(NodeType_e type, csubstr val={}, type_bits more_flags=0)
+    {
+        size_t node;
+        bool keyed = false;
+        csubstr key = m_key;
+        if(m_curr != NONE)
+        {
+            node = m_tree->append_child(m_curr);
+            keyed = m_tree->is_map(m_curr);
+            if(keyed)
+                more_flags |= KEYQUO;
+        }
+        else
+        {
+            // this is the node being parsed into: keep only its key, if any
+            node = m_root_id;
+            m_tree->_rem_flags(node, VAL|VALQUO|MAP|SEQ);
+            if(m_tree->has_key(node))
+            {
+                keyed = true;
+                key = m_tree->key(node);
+                if(m_tree->is_key_quoted(node))
+                    more_flags |= KEYQUO;
+            }
+            else if(m_tree->is_doc(node) || (type == VAL && m_tree->is_root(node)))
+            {
+                more_flags |= DOC; // like the yaml parser does
+            }
+        }
+        if(type == MAP)
+            keyed ? m_tree->to_map(node, key, more_flags) : m_tree->to_map(node, more_flags);
+        else if(type == SEQ)
+            keyed ? m_tree->to_seq(node, key, more_flags) : m_tree->to_seq(node, more_flags);
+        else if(keyed)
+            m_tree->to_keyval(node, key, val, more_flags);
+        else
+            m_tree->to_val(node, val, more_flags);
+        return node;
+    }
+};
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DETAIL_JSON_HPP_ */
@@ -0,0 +1,156 @@
+#ifndef _C4_YML_DETAIL_LINE_INDEX_HPP_
+#define _C4_YML_DETAIL_LINE_INDEX_HPP_
+
+#ifndef _C4_YML_DETAIL_STACK_HPP_
+#include "c4/yml/detail/stack.hpp"
+#endif
+
+#ifndef _C4_YML_DETAIL_SIMD_HPP_
+#include "c4/yml/detail/simd.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+/** A stage-1 index of the newline characters in a buffer. It is built
+ * once per parse with a block-wise (vectorized) scan, and afterwards
+ * answers "where is the next newline?" and "what is the indentation of
+ * the line starting here?" without rescanning the buffer.
+ *
+ * Every '\n' and '\r' is recorded, together with the number of spaces
+ * following it. Lookups keep a cursor into the index, so the common
+ * case of the parser moving forward by one line is O(1); random
+ * lookups are a binary search. */
+class LineIndex
+{
+public:
+
+    struct Entry
+    {
+        size_t offset;      ///< the offset of the newline character
+        size_t indentation; ///< the number of spaces after the newline character, or npos if they reach the end of the buffer
+    };
+
+public:
+
+    LineIndex(Allocator const& a={}) : m_entries(a), m_buf(), m_first_indentation(npos), m_cursor(0) {}
+
+    void build(csubstr buf)
+    {
+        m_buf = buf;
+        m_cursor = 0;
+        m_entries.clear();
+        m_first_indentation = _count_spaces(0);
+        const char *C4_RESTRICT b = buf.str;
+        size_t i = 0;
+        if(buf.len >= simd::block_size)
+        {
+            for(const size_t last = buf.len - simd::block_size; i <= last; i += simd::block_size)
+            {
+                simd::block_type blk = simd::load(b + i);
+                uint32_t m = simd::eq(blk, '\n') | simd::eq(blk, '\r');
+                while(m)
+                {
+                    _add(i + simd::ctz(m));
+                    m = simd::clear_lowest(m);
+                }
+            }
+        }
+        for( ; i < buf.len; ++i)
+        {
+            if(b[i] == '\n' || b[i] == '\r')
+                _add(i);
+        }
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_buf = {};
+        m_first_indentation = npos;
+        m_cursor = 0;
+    }
+
+    size_t size() const { return m_entries.size(); }
+    Entry const& operator[] (size_t i) const { return m_entries[i]; }
+
+    /** get the offset of the first newline character at or after @p pos,
+     * or the buffer size if there is none */
+    size_t next_newline(size_t pos) const
+    {
+        size_t i = lower_bound(pos);
+        if(i == m_entries.size())
+            return m_buf.len;
+        RYML_ASSERT(m_buf.str[m_entries[i].offset] == '\n' || m_buf.str[m_entries[i].offset] == '\r');
+        return m_entries[i].offset;
+    }
+
+    /** get the indentation of the line starting at @p pos, ie the
+     * number of spaces starting there. Returns npos if the spaces reach
+     * the end of the buffer. */
+    size_t indentation(size_t pos) const
+    {
+        if(pos == 0)
+            return m_first_indentation;
+        size_t i = lower_bound(pos - 1);
+        if(i < m_entries.size() && m_entries[i].offset == pos - 1)
+            return m_entries[i].indentation;
+        return _count_spaces(pos); // not at a line beginning
+    }
+
+    /** get the index of the first entry whose offset is not less than @p pos */
+    size_t lower_bound(size_t pos) const
+    {
+        const size_t sz = m_entries.size();
+        size_t i = m_cursor < sz ? m_cursor : sz;
+        // fast path: the parser mostly moves forward one line at a time
+        for(size_t n = 0; n < 4 && i < sz && m_entries[i].offset < pos; ++n)
+            ++i;
+        if((i == sz || m_entries[i].offset >= pos) && (i == 0 || m_entries[i-1].offset < pos))
+        {
+            m_cursor = i;
+            return i;
+        }
+        size_t lo = 0, hi = sz;
+        while(lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if(m_entries[mid].offset < pos)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        m_cursor = lo;
+        return lo;
+    }
+
+private:
+
+    void _add(size_t nlpos)
+    {
+        m_entries.push({nlpos, _count_spaces(nlpos + 1)});
+    }
+
+    size_t _count_spaces(size_t pos) const
+    {
+        size_t i = pos;
+        while(i < m_buf.len && m_buf.str[i] == ' ')
+            ++i;
+        return i < m_buf.len ? i - pos : npos;
+    }
+
+private:
+
+    stack<Entry> m_entries;
+    csubstr      m_buf;
+    size_t       m_first_indentation;
+    mutable size_t m_cursor;
+
+};
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DETAIL_LINE_INDEX_HPP_ */
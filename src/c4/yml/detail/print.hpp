@@ -64,7 +64,7 @@ inline size_t print_node(Tree const& p, size_t node, int level, size_t count, bo
     }
     if(p.has_val_anchor(node))
     {
-        auto &a = p.val_anchor(node);
+        csubstr a = p.val_anchor(node);
         printf(" valanchor='&%.*s'", (int)a.len, a.str);
     }
     printf(" (%zd sibs)", p.num_siblings(node));
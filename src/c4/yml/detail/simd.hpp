@@ -0,0 +1,261 @@
+#ifndef _C4_YML_DETAIL_SIMD_HPP_
+#define _C4_YML_DETAIL_SIMD_HPP_
+
+/** @file simd.hpp
+ * Minimal block-wise byte classification used by the parser's scanning
+ * kernels. A block of @ref c4::yml::detail::simd::block_size bytes is
+ * compared against one or more characters, yielding a bitmask where bit i
+ * is set if byte i matched. The instruction set is selected at compile
+ * time (AVX2, SSE2, aarch64 NEON); when none is available (or when
+ * RYML_NO_SIMD is defined) a portable scalar implementation of the same
+ * interface is used, so that callers have a single code path.
+ *
+ * @note loads are unaligned and always read a full block, so callers
+ * must only call these functions when at least block_size bytes are
+ * available from the given pointer. */
+
+#ifndef _C4_YML_COMMON_HPP_
+#include "../common.hpp"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(RYML_NO_SIMD)
+    // use the scalar implementation
+#elif defined(__AVX2__)
+#   define RYML_SIMD_AVX2
+#   include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define RYML_SIMD_SSE2
+#   include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (defined(__aarch64__) || defined(_M_ARM64))
+#   define RYML_SIMD_NEON
+#   include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#   include <intrin.h>
+#endif
+
+namespace c4 {
+namespace yml {
+namespace detail {
+namespace simd {
+
+#if defined(RYML_SIMD_AVX2)
+enum : size_t { block_size = 32 };
+typedef __m256i block_type;
+C4_ALWAYS_INLINE block_type load(const char *C4_RESTRICT p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+C4_ALWAYS_INLINE uint32_t eq(block_type b, char c) { return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(c))); }
+#elif defined(RYML_SIMD_SSE2)
+enum : size_t { block_size = 16 };
+typedef __m128i block_type;
+C4_ALWAYS_INLINE block_type load(const char *C4_RESTRICT p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+C4_ALWAYS_INLINE uint32_t eq(block_type b, char c) { return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8(c))); }
+#elif defined(RYML_SIMD_NEON)
+enum : size_t { block_size = 16 };
+typedef uint8x16_t block_type;
+C4_ALWAYS_INLINE block_type load(const char *C4_RESTRICT p) { return vld1q_u8(reinterpret_cast<const uint8_t*>(p)); }
+C4_ALWAYS_INLINE uint32_t eq(block_type b, char c)
+{
+    // there is no movemask in NEON: weight each matching lane
+    // with its bit, then add the lanes of each half
+    static const uint8_t bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t m = vandq_u8(vceqq_u8(b, vdupq_n_u8((uint8_t)c)), vld1q_u8(bits));
+    return (uint32_t)vaddv_u8(vget_low_u8(m)) | ((uint32_t)vaddv_u8(vget_high_u8(m)) << 8u);
+}
+#else
+enum : size_t { block_size = 8 };
+typedef const char* block_type;
+C4_ALWAYS_INLINE block_type load(const char *C4_RESTRICT p) { return p; }
+C4_ALWAYS_INLINE uint32_t eq(block_type b, char c)
+{
+    uint32_t m = 0;
+    for(uint32_t i = 0; i < (uint32_t)block_size; ++i)
+        m |= (uint32_t)(b[i] == c) << i;
+    return m;
+}
+#endif
+
+/** the index of the lowest set bit. @p m must not be zero. */
+C4_ALWAYS_INLINE uint32_t ctz(uint32_t m)
+{
+    RYML_ASSERT(m != 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return (uint32_t)i;
+#else
+    return (uint32_t)__builtin_ctz(m);
+#endif
+}
+
+/** clear the lowest set bit */
+C4_ALWAYS_INLINE uint32_t clear_lowest(uint32_t m)
+{
+    return m & (m - 1u);
+}
+
+/** the position of the first character @p c in @p s, starting at
+ * @p pos, or @p len if there is none.
+ * @see first_of(const char*, size_t, size_t, char, char) */
+C4_ALWAYS_INLINE size_t first_of(const char *C4_RESTRICT s, size_t pos, size_t len, char c)
+{
+    if(len >= block_size)
+    {
+        for(const size_t last = len - block_size; pos <= last; pos += block_size)
+        {
+            uint32_t m = eq(load(s + pos), c);
+            if(m)
+                return pos + ctz(m);
+        }
+    }
+    for( ; pos < len; ++pos)
+        if(s[pos] == c)
+            return pos;
+    return len;
+}
+
+/** the position of the first of the characters @p a or @p b in @p s,
+ * starting at @p pos, or @p len if there is none. Full blocks are
+ * compared at once, and the remaining tail one byte at a time. */
+C4_ALWAYS_INLINE size_t first_of(const char *C4_RESTRICT s, size_t pos, size_t len, char a, char b)
+{
+    if(len >= block_size)
+    {
+        for(const size_t last = len - block_size; pos <= last; pos += block_size)
+        {
+            block_type blk = load(s + pos);
+            uint32_t m = eq(blk, a) | eq(blk, b);
+            if(m)
+                return pos + ctz(m);
+        }
+    }
+    for( ; pos < len; ++pos)
+        if(s[pos] == a || s[pos] == b)
+            return pos;
+    return len;
+}
+
+/** the position of the first of the @p num_chars characters in
+ * @p chars found in @p s, starting at @p pos, or @p len if there is
+ * none. Meant for short sets, as each one is compared separately.
+ * @see first_of(const char*, size_t, size_t, char, char) */
+inline size_t first_of(const char *C4_RESTRICT s, size_t pos, size_t len, const char *C4_RESTRICT chars, size_t num_chars)
+{
+    if(len >= block_size)
+    {
+        for(const size_t last = len - block_size; pos <= last; pos += block_size)
+        {
+            block_type blk = load(s + pos);
+            uint32_t m = 0;
+            for(size_t c = 0; c < num_chars; ++c)
+                m |= eq(blk, chars[c]);
+            if(m)
+                return pos + ctz(m);
+        }
+    }
+    for( ; pos < len; ++pos)
+        if(memchr(chars, s[pos], num_chars))
+            return pos;
+    return len;
+}
+
+/** the position of the first occurrence of @p needle in @p s, starting
+ * at @p pos, or @p len if there is none. Each block is compared with
+ * the first and last characters of the needle, and only the positions
+ * matching both are compared in full. */
+inline size_t find(const char *C4_RESTRICT s, size_t pos, size_t len, const char *C4_RESTRICT needle, size_t needle_len)
+{
+    RYML_ASSERT(needle_len > 0);
+    if(needle_len > len)
+        return len;
+    if(needle_len == 1)
+        return first_of(s, pos, len, needle[0]);
+    const char first = needle[0];
+    const char last = needle[needle_len - 1];
+    const size_t last_pos = len - needle_len; // the last position where the needle fits
+    if(last_pos + 1 >= block_size)
+    {
+        for(const size_t last_blk = last_pos + 1 - block_size; pos <= last_blk; pos += block_size)
+        {
+            uint32_t m = eq(load(s + pos), first) & eq(load(s + pos + needle_len - 1), last);
+            while(m)
+            {
+                const size_t i = pos + ctz(m);
+                if(memcmp(s + i + 1, needle + 1, needle_len - 2) == 0)
+                    return i;
+                m = clear_lowest(m);
+            }
+        }
+    }
+    for( ; pos <= last_pos; ++pos)
+        if(s[pos] == first && s[pos + needle_len - 1] == last && memcmp(s + pos + 1, needle + 1, needle_len - 2) == 0)
+            return pos;
+    return len;
+}
+
+/** the position of the first double quote in @p s which is not
+ * escaped by a backslash, starting at @p pos, or @p len if there is
+ * none. Runs of backslashes are resolved a block at a time, as in
+ * simdjson: adding the starts of the odd-positioned runs to the
+ * backslash mask carries through each run, so its parity is read off
+ * the sum without looking at each byte. The carry out of the block
+ * tells whether the first byte of the next block is escaped.
+ * @p has_escapes is set if there is a backslash before the quote. */
+inline size_t first_unescaped_dquote(const char *C4_RESTRICT s, size_t pos, size_t len, bool *C4_RESTRICT has_escapes)
+{
+    uint64_t escaped_next = 0; // whether the first byte of the next block is escaped
+    if(len >= block_size)
+    {
+        const uint64_t all = (UINT64_C(1) << block_size) - 1u;
+        const uint64_t even = UINT64_C(0x5555555555555555) & all;
+        for(const size_t last = len - block_size; pos <= last; pos += block_size)
+        {
+            const block_type blk = load(s + pos);
+            const uint64_t raw_bs = eq(blk, '\\');
+            uint64_t quotes = eq(blk, '"');
+            if(!raw_bs && !escaped_next)
+            {
+                if(quotes)
+                    return pos + ctz((uint32_t)quotes);
+                continue;
+            }
+            const uint64_t bs = raw_bs & ~escaped_next;
+            const uint64_t follows_escape = ((bs << 1u) | escaped_next) & all;
+            const uint64_t odd_starts = bs & ~even & ~follows_escape;
+            const uint64_t sum = odd_starts + bs;
+            escaped_next = sum >> block_size;
+            const uint64_t escaped = (even ^ ((sum << 1u) & all)) & follows_escape;
+            quotes &= ~escaped;
+            if(quotes)
+            {
+                const uint32_t q = ctz((uint32_t)quotes);
+                *has_escapes = *has_escapes || (raw_bs & ((UINT64_C(1) << q) - 1u));
+                return pos + q;
+            }
+            *has_escapes = *has_escapes || raw_bs;
+        }
+    }
+    for( ; pos < len; ++pos)
+    {
+        if(escaped_next)
+            escaped_next = 0;
+        else if(s[pos] == '\\')
+        {
+            *has_escapes = true;
+            escaped_next = 1;
+        }
+        else if(s[pos] == '"')
+            return pos;
+    }
+    return len;
+}
+
+} // namespace simd
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DETAIL_SIMD_HPP_ */
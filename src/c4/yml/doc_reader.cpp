@@ -0,0 +1,119 @@
+#include "c4/yml/doc_reader.hpp"
+
+#include <string.h>
+
+namespace c4 {
+namespace yml {
+
+DocReader::DocReader(Allocator const& a)
+    : m_parser(a)
+    , m_tree(a)
+    , m_file()
+    , m_src()
+    , m_docs(a)
+    , m_index(NONE)
+{
+}
+
+void DocReader::reset(csubstr filename, csubstr src)
+{
+    m_file = filename;
+    m_src = src;
+    m_index = NONE;
+    detail::scan_docs(m_src, &m_docs);
+}
+
+NodeRef DocReader::read(size_t i)
+{
+    RYML_CHECK(i < m_docs.size());
+    // recycle the nodes and the arena of the previous document
+    m_tree.clear();
+    m_tree.clear_arena();
+    m_parser.parse(m_file, m_docs[i], &m_tree);
+    m_index = i;
+    return doc();
+}
+
+bool DocReader::next()
+{
+    const size_t i = m_index == NONE ? 0 : m_index + 1;
+    if(i >= m_docs.size())
+        return false;
+    read(i);
+    return true;
+}
+
+NodeRef DocReader::doc()
+{
+    RYML_ASSERT(m_index != NONE);
+    NodeRef r = m_tree.rootref();
+    return r.is_stream() ? r.first_child() : r;
+}
+
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+inline bool _is_marker(csubstr s, size_t pos, char c)
+{
+    return pos + 3 <= s.len && s.str[pos] == c && s.str[pos+1] == c && s.str[pos+2] == c
+        && (pos + 3 == s.len || s.str[pos+3] == ' ' || s.str[pos+3] == '\t' || s.str[pos+3] == '\n' || s.str[pos+3] == '\r');
+}
+
+} // namespace
+
+namespace detail {
+
+/** Find the documents by looking only at the start of each line. This
+ * is reliable because the document markers cannot appear at the start
+ * of a line inside a document, not even inside block or quoted
+ * scalars. */
+void scan_docs(csubstr src, stack<csubstr> *docs)
+{
+    docs->clear();
+    size_t beg = 0;           // where the current document starts
+    bool has_marker = false;  // whether the current document has a "---"
+    bool has_content = false; // whether the current document has anything other than comments or directives
+    size_t pos = 0;
+    while(pos < src.len)
+    {
+        const void *nl = memchr(src.str + pos, '\n', src.len - pos);
+        const size_t next = nl ? static_cast<size_t>(static_cast<const char*>(nl) - src.str) + 1 : src.len;
+        if(_is_marker(src, pos, '-'))
+        {
+            if(has_marker || has_content)
+            {
+                docs->push(src.range(beg, pos));
+                beg = pos;
+            }
+            // otherwise, the preceding directives and comments are
+            // kept with this document
+            has_marker = true;
+            has_content = false;
+        }
+        else if(_is_marker(src, pos, '.'))
+        {
+            if(has_marker || has_content)
+                docs->push(src.range(beg, next));
+            beg = next;
+            has_marker = false;
+            has_content = false;
+        }
+        else if( ! has_content)
+        {
+            // directives are only allowed before the "---"
+            csubstr line = src.range(pos, next).trim(" \t\r\n");
+            if( ! line.empty() && line.str[0] != '#' && ! (line.str[0] == '%' && line.str == src.str + pos && ! has_marker))
+                has_content = true;
+        }
+        pos = next;
+    }
+    if(has_marker || has_content)
+        docs->push(src.sub(beg));
+}
+
+} // namespace detail
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,117 @@
+#ifndef _C4_YML_DOC_READER_HPP_
+#define _C4_YML_DOC_READER_HPP_
+
+/** @file doc_reader.hpp Reading the documents of a multi-document
+ * stream one at a time, or by index. */
+
+#ifndef _C4_YML_PARSE_HPP_
+#include "c4/yml/parse.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+namespace detail {
+/** find the source of each document in a stream, including its markers */
+RYML_EXPORT void scan_docs(csubstr src, stack<csubstr> *docs);
+} // namespace detail
+
+/** Parses the documents of a stream separately, each into the same
+ * tree, which is cleared (keeping its capacity) before the next
+ * document is parsed.
+ *
+ * On reset(), the source is pre-scanned for the document boundaries
+ * ("---" and "..." markers at the start of a line). This is much
+ * cheaper than parsing, as only the first characters of each line are
+ * looked at, so a document can be parsed directly by its index without
+ * parsing the documents before it:
+ *
+ * @code
+ * DocReader reader("bundle.yml", src);
+ * for(size_t i : wanted)
+ *     process(reader.read(i)); // valid until the next read
+ * // or go through all of them:
+ * for(NodeRef doc : reader)
+ *     process(doc);
+ * @endcode
+ *
+ * Errors found while parsing a document are located relative to the
+ * start of its source, doc_src().
+ *
+ * @note the source buffer is not modified: each document is copied to
+ * the tree's arena before being parsed. */
+class RYML_EXPORT DocReader
+{
+public:
+
+    DocReader(Allocator const& a={});
+    DocReader(csubstr src, Allocator const& a={}) : DocReader(a) { reset({}, src); }
+    DocReader(csubstr filename, csubstr src, Allocator const& a={}) : DocReader(a) { reset(filename, src); }
+
+    /** start reading a new source, and find its documents */
+    void reset(csubstr filename, csubstr src);
+
+    /** the number of documents in the source */
+    size_t num_docs() const { return m_docs.size(); }
+
+    /** the source of the i-th document, including its markers */
+    csubstr doc_src(size_t i) const { RYML_ASSERT(i < m_docs.size()); return m_docs[i]; }
+
+    /** the offset of the i-th document in the source */
+    size_t doc_offset(size_t i) const { return static_cast<size_t>(doc_src(i).str - m_src.str); }
+
+    /** parse the i-th document, and return it */
+    NodeRef read(size_t i);
+
+    /** parse the document after the current one (or the first, if no
+     * document was read yet). Returns false when there are no more
+     * documents. */
+    bool next();
+
+    /** the tree with the current document */
+    Tree      & tree()       { return m_tree; }
+    Tree const& tree() const { return m_tree; }
+
+    /** the current document: either the root of the tree or, if the
+     * document has explicit markers, the single document in the root
+     * stream */
+    NodeRef doc();
+
+    /** the index of the current document, or NONE if none was read */
+    size_t index() const { return m_index; }
+
+public:
+
+    /** an input iterator going through the documents, for use with
+     * range-for loops. It starts from the document after the current
+     * one. */
+    struct iterator
+    {
+        DocReader *m_reader;
+
+        NodeRef operator*  () const { return m_reader->doc(); }
+        iterator& operator++ () { if( ! m_reader->next()) m_reader = nullptr; return *this; }
+        bool operator== (iterator const& that) const { return m_reader == that.m_reader; }
+        bool operator!= (iterator const& that) const { return m_reader != that.m_reader; }
+    };
+
+    iterator begin() { return iterator{next() ? this : nullptr}; }
+    iterator end() { return iterator{nullptr}; }
+
+private:
+
+    Parser  m_parser;
+    Tree    m_tree;
+
+    csubstr m_file;
+    csubstr m_src;
+
+    detail::stack<csubstr> m_docs;
+    size_t  m_index;
+
+};
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DOC_READER_HPP_ */
@@ -5,6 +5,7 @@
 #include "./emit.hpp"
 #endif
 #include "./detail/parser_dbg.hpp"
+#include "./detail/simd.hpp"
 
 namespace c4 {
 namespace yml {
@@ -355,6 +356,7 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
         return;
     }
 
+    static constexpr const char _special[] = "#:-?,\n{}[]'\"";
     const bool needs_quotes = (
         was_quoted
         ||
@@ -374,7 +376,7 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
                 s.ends_with(" \n\r\t")
                 ||
                 // has special chars
-                (s.first_of("#:-?,\n{}[]'\"") != npos)
+                (detail::simd::first_of(s.str, 0, s.len, _special, sizeof(_special)-1) < s.len)
             )
         )
     );
@@ -385,8 +387,8 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
     }
     else
     {
-        const bool has_dquotes = s.first_of( '"') != npos;
-        const bool has_squotes = s.first_of('\'') != npos;
+        const bool has_dquotes = detail::simd::first_of(s.str, 0, s.len,  '"') < s.len;
+        const bool has_squotes = detail::simd::first_of(s.str, 0, s.len, '\'') < s.len;
         if(!has_squotes && has_dquotes)
         {
             this->Writer::_do_write('\'');
@@ -0,0 +1,51 @@
+#ifndef _C4_YML_EVENT_HANDLER_HPP_
+#define _C4_YML_EVENT_HANDLER_HPP_
+
+/** @file event_handler.hpp SAX-style consumption of JSON documents:
+ * instead of building a tree, the JSON parsers call back a handler for
+ * each structural event. */
+
+#ifndef _C4_YML_TREE_HPP_
+#include "c4/yml/tree.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+/** Receives the structure of a JSON document as a sequence of
+ * events, from Parser::parse_json() with a handler or from
+ * JsonPushParser. Override only the callbacks of interest; the default
+ * implementations do nothing.
+ *
+ * The events of a document are bracketed by begin_doc()/end_doc().
+ * Containers are bracketed by begin_map()/end_map() or
+ * begin_seq()/end_seq(). Inside a map, each value (a scalar or a
+ * container) is preceded by key().
+ *
+ * Scalars point into the source buffer, and are valid for as long as
+ * it is. A null value is passed as an empty scalar with a null
+ * pointer, as it is stored in the tree.
+ *
+ * @see Parser::parse_json(csubstr, substr, EventHandler*)
+ * @see JsonPushParser */
+struct RYML_EXPORT EventHandler
+{
+    virtual ~EventHandler() = default;
+
+    virtual void begin_doc() {}
+    virtual void end_doc() {}
+
+    virtual void begin_map() {}
+    virtual void end_map() {}
+
+    virtual void begin_seq() {}
+    virtual void end_seq() {}
+
+    virtual void key(csubstr /*k*/, bool /*quoted*/) {}
+    virtual void scalar(csubstr /*s*/, bool /*quoted*/) {}
+};
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_EVENT_HANDLER_HPP_ */
@@ -122,16 +122,16 @@ public:
     inline const char*  type_str() const { _C4RV(); RYML_ASSERT(valid() && ! is_seed()); return m_tree->type_str(m_id); }
 
     inline csubstr    const& key()        const { _C4RV(); return m_tree->key(m_id); }
-    inline csubstr    const& key_tag()    const { _C4RV(); return m_tree->key_tag(m_id); }
-    inline csubstr    const& key_ref()    const { _C4RV(); return m_tree->key_ref(m_id); }
-    inline csubstr    const& key_anchor() const { _C4RV(); return m_tree->key_anchor(m_id); }
-    inline NodeScalar const& keysc()      const { _C4RV(); return m_tree->keysc(m_id); }
+    inline csubstr           key_tag()    const { _C4RV(); return m_tree->key_tag(m_id); }
+    inline csubstr           key_ref()    const { _C4RV(); return m_tree->key_ref(m_id); }
+    inline csubstr           key_anchor() const { _C4RV(); return m_tree->key_anchor(m_id); }
+    inline NodeScalar        keysc()      const { _C4RV(); return m_tree->keysc(m_id); }
 
     inline csubstr    const& val()        const { _C4RV(); return m_tree->val(m_id); }
-    inline csubstr    const& val_tag()    const { _C4RV(); return m_tree->val_tag(m_id); }
-    inline csubstr    const& val_ref()    const { _C4RV(); return m_tree->val_ref(m_id); }
-    inline csubstr    const& val_anchor() const { _C4RV(); return m_tree->val_anchor(m_id); }
-    inline NodeScalar const& valsc()      const { _C4RV(); return m_tree->valsc(m_id); }
+    inline csubstr           val_tag()    const { _C4RV(); return m_tree->val_tag(m_id); }
+    inline csubstr           val_ref()    const { _C4RV(); return m_tree->val_ref(m_id); }
+    inline csubstr           val_anchor() const { _C4RV(); return m_tree->val_anchor(m_id); }
+    inline NodeScalar        valsc()      const { _C4RV(); return m_tree->valsc(m_id); }
 
     /** @} */
 
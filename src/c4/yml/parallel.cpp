@@ -0,0 +1,468 @@
+#include "c4/yml/parallel.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/doc_reader.hpp"
+
+#include <string.h>
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#   define _RYML_PARALLEL_CATCH 1
+#else
+#   define _RYML_PARALLEL_CATCH 0
+#endif
+
+namespace c4 {
+namespace yml {
+
+namespace {
+
+size_t _num_threads(size_t num_threads, size_t num_jobs)
+{
+    if(num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    if(num_threads == 0)
+        num_threads = 1;
+    if(num_threads > num_jobs)
+        num_threads = num_jobs;
+    return num_threads;
+}
+
+/** call job(&parser, i) for each i in [0,num_jobs), from num_threads
+ * threads (counting the calling one) taking the jobs in order from a
+ * shared counter. Each thread has its own parser. A job fails by
+ * returning false or by throwing; the remaining jobs are then skipped.
+ * @return true if all the jobs succeeded */
+template<class Job>
+bool _run_jobs(Allocator a, size_t num_threads, size_t num_jobs, Job const& job)
+{
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto work = [&]{
+        Parser parser(a);
+        for(size_t i = next++; i < num_jobs; i = next++)
+        {
+            if(failed)
+                return;
+            #if _RYML_PARALLEL_CATCH
+            try
+            {
+                if( ! job(&parser, i))
+                    failed = true;
+            }
+            catch(...)
+            {
+                failed = true;
+            }
+            #else
+            if( ! job(&parser, i))
+                failed = true;
+            #endif
+        }
+    };
+    // the calling thread is one of the workers
+    const size_t num_spawned = num_threads - 1;
+    std::thread *threads = nullptr;
+    if(num_spawned)
+    {
+        threads = static_cast<std::thread*>(a.allocate(num_spawned * sizeof(std::thread), nullptr));
+        for(size_t i = 0; i < num_spawned; ++i)
+            new (threads + i) std::thread(work);
+    }
+    work();
+    for(size_t i = 0; i < num_spawned; ++i)
+    {
+        threads[i].join();
+        threads[i].~thread();
+    }
+    if(num_spawned)
+        a.free(threads, num_spawned * sizeof(std::thread));
+    return ! failed;
+}
+
+/** an array of trees for the jobs to parse into */
+struct Trees
+{
+    Allocator a;
+    Tree *trees;
+    size_t num;
+
+    Trees(Allocator const& a_, size_t num_) : a(a_), trees(), num(num_)
+    {
+        trees = static_cast<Tree*>(a.allocate(num * sizeof(Tree), nullptr));
+        for(size_t i = 0; i < num; ++i)
+            new (trees + i) Tree(a);
+    }
+    ~Trees()
+    {
+        for(size_t i = 0; i < num; ++i)
+            trees[i].~Tree();
+        a.free(trees, num * sizeof(Tree));
+    }
+    Trees(Trees const&) = delete;
+    Trees& operator= (Trees const&) = delete;
+
+    Tree& operator[] (size_t i) { return trees[i]; }
+
+    size_t total_size() const
+    {
+        size_t total = 0;
+        for(size_t i = 0; i < num; ++i)
+            total += trees[i].size();
+        return total;
+    }
+};
+
+void _parse_serial(csubstr filename, csubstr src, Tree *t)
+{
+    Parser np(t->allocator());
+    np.parse(filename, src, t);
+}
+
+/** parse serially after the jobs failed, in situ in the copy of the
+ * source which is already in the arena. The jobs filtered their parts
+ * of the copy in place, so it is first restored from the source. */
+void _parse_serial_in_arena(csubstr filename, csubstr src, substr buf, Tree *t)
+{
+    RYML_ASSERT(buf.len == src.len);
+    memcpy(buf.str, src.str, src.len);
+    Parser np(t->allocator());
+    np.parse(filename, buf, t);
+}
+
+void _parse_docs(csubstr filename, csubstr src, Tree *t, size_t num_threads, detail::stack<csubstr> const& docs)
+{
+    const size_t num_docs = docs.size();
+    num_threads = _num_threads(num_threads, num_docs);
+    Trees trees(t->allocator(), num_docs);
+    substr buf = t->copy_to_arena(src);
+    bool ok = _run_jobs(t->allocator(), num_threads, num_docs, [&](Parser *parser, size_t i){
+        // the documents are parsed in situ in the destination
+        // tree's arena, so the spliced nodes can keep their strings
+        substr doc = buf.sub(static_cast<size_t>(docs[i].str - src.str), docs[i].len);
+        parser->parse(filename, doc, &trees[i]);
+        return true;
+    });
+    if( ! ok)
+    {
+        // parse again serially, to report the error from this thread
+        // and with its location in the whole source
+        _parse_serial_in_arena(filename, src, buf, t);
+        return;
+    }
+    // splice the documents in order under the stream root
+    t->reserve(1 + trees.total_size());
+    const size_t root = t->root_id();
+    t->to_stream(root);
+    for(size_t i = 0; i < num_docs; ++i)
+    {
+        Tree const& dt = trees[i];
+        size_t doc = dt.root_id();
+        if(dt.is_stream(doc))
+        {
+            RYML_ASSERT(dt.num_children(doc) == 1);
+            doc = dt.first_child(doc);
+        }
+        const size_t dst = t->append_child(root);
+        t->duplicate_contents(&dt, doc, dst);
+        t->_add_flags(dst, DOC);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+
+inline bool _is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline size_t _line_end(csubstr s, size_t pos)
+{
+    const void *nl = memchr(s.str + pos, '\n', s.len - pos);
+    return nl ? static_cast<size_t>(static_cast<const char*>(nl) - s.str) + 1 : s.len;
+}
+
+/** "- " starting a block sequence entry */
+inline bool _is_seq_entry(csubstr s, size_t pos)
+{
+    return s.str[pos] == '-' && (pos + 1 == s.len || _is_ws(s.str[pos+1]));
+}
+
+/** a line at column 0 which can only start a block map entry. The
+ * line must have a key: a line with only a tag or an anchor holds the
+ * properties of the next node (eg of the root map) */
+inline bool _is_map_entry(csubstr s, size_t pos)
+{
+    return strchr("-?:,[]{}#|>%@`", s.str[pos]) == nullptr
+        && memchr(s.str + pos, ':', _line_end(s, pos) - pos) != nullptr;
+}
+
+/** whether the block scalar header |, >, |-, >+2, etc ends the line */
+bool _ends_with_block_scalar_header(csubstr line)
+{
+    size_t i = line.len;
+    while(i > 0 && (line.str[i-1] == '-' || line.str[i-1] == '+' || (line.str[i-1] >= '0' && line.str[i-1] <= '9')))
+        --i;
+    if(i == 0 || (line.str[i-1] != '|' && line.str[i-1] != '>'))
+        return false;
+    return i == 1 || line.str[i-2] == ' ' || line.str[i-2] == '\t';
+}
+
+/** A cheap lexical pass over a chunk: check that it does not end inside
+ * a flow container or a quoted scalar, ie that the split after it is at
+ * a real top-level entry. Block scalars are skipped, as their contents
+ * are free text. This errs on the side of rejecting the split: eg, a
+ * quote in the middle of a plain scalar is taken as opening a quoted
+ * scalar. */
+bool _chunk_is_closed(csubstr chunk)
+{
+    size_t depth = 0;
+    char quote = 0;
+    size_t block_indentation = npos; // when skipping a block scalar, the indentation of its parent
+    for(size_t pos = 0; pos < chunk.len; )
+    {
+        const size_t end = _line_end(chunk, pos);
+        csubstr line = chunk.range(pos, end).trimr(" \t\r\n");
+        pos = end;
+        size_t ind = 0;
+        while(ind < line.len && line.str[ind] == ' ')
+            ++ind;
+        if(block_indentation != npos)
+        {
+            if(ind == line.len || ind > block_indentation)
+                continue;
+            block_indentation = npos;
+        }
+        // the indentation of the innermost collection in the line, which
+        // a block scalar's contents must exceed: that of the innermost
+        // sequence if the scalar is its entry, else that of the key
+        size_t node_indentation = ind;
+        size_t seq_indentation = ind;
+        while(node_indentation < line.len && _is_seq_entry(line, node_indentation))
+        {
+            seq_indentation = node_indentation++;
+            while(node_indentation < line.len && line.str[node_indentation] == ' ')
+                ++node_indentation;
+        }
+        if(node_indentation < line.len && (line.str[node_indentation] == '|' || line.str[node_indentation] == '>'))
+            node_indentation = seq_indentation;
+        size_t last = 0; // the end of the line's contents, before any comment
+        for(size_t i = 0; i < line.len; ++i)
+        {
+            const char c = line.str[i];
+            if(quote == '\'')
+            {
+                if(c == '\'')
+                {
+                    if(i + 1 < line.len && line.str[i+1] == '\'')
+                        ++i;
+                    else
+                        quote = 0;
+                }
+            }
+            else if(quote == '"')
+            {
+                if(c == '\\')
+                    ++i;
+                else if(c == '"')
+                    quote = 0;
+            }
+            else if(c == '#' && (i == 0 || line.str[i-1] == ' ' || line.str[i-1] == '\t'))
+            {
+                break;
+            }
+            else if(c == '\'' || c == '"')
+            {
+                if(i == 0 || strchr(" \t[{,:", line.str[i-1]) != nullptr)
+                    quote = c;
+            }
+            else if(c == '[' || c == '{')
+            {
+                ++depth;
+            }
+            else if(c == ']' || c == '}')
+            {
+                if(depth)
+                    --depth;
+            }
+            last = i + 1;
+        }
+        if( ! quote && ! depth && _ends_with_block_scalar_header(line.first(last).trimr(" \t")))
+            block_indentation = node_indentation;
+    }
+    return quote == 0 && depth == 0;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+
+void parse_parallel(csubstr filename, csubstr src, Tree *t, size_t num_threads)
+{
+    RYML_CHECK(t != nullptr);
+    RYML_CHECK( ! t->has_children(t->root_id()));
+    detail::stack<csubstr> docs(t->allocator());
+    detail::scan_docs(src, &docs);
+    if(docs.size() <= 1)
+        _parse_serial(filename, src, t);
+    else
+        _parse_docs(filename, src, t, num_threads, docs);
+}
+
+
+void parse_parallel_entries(csubstr filename, csubstr src, Tree *t, size_t num_threads)
+{
+    RYML_CHECK(t != nullptr);
+    RYML_CHECK( ! t->has_children(t->root_id()));
+    detail::stack<csubstr> docs(t->allocator());
+    detail::scan_docs(src, &docs);
+    if(docs.size() > 1)
+    {
+        _parse_docs(filename, src, t, num_threads, docs);
+        return;
+    }
+    num_threads = _num_threads(num_threads, npos);
+    if(docs.empty() || num_threads == 1)
+    {
+        _parse_serial(filename, src, t);
+        return;
+    }
+
+    // find the top-level entries: the lines starting at column 0,
+    // which must all start an entry of the same collection
+    csubstr doc = docs[0];
+    detail::stack<size_t> entries(t->allocator()); // offsets in the doc
+    bool has_marker = false;
+    NodeType_e type = NOTYPE;
+    for(size_t pos = 0; pos < doc.len; pos = _line_end(doc, pos))
+    {
+        const char c = doc.str[pos];
+        if(_is_ws(c) || c == '#')
+            continue;
+        if(type == NOTYPE)
+        {
+            if(c == '%')
+                continue;
+            if(doc.sub(pos).begins_with("---"))
+            {
+                // a bare marker; anything after it (eg a tag or an
+                // anchor for the collection) is left to the serial parse
+                csubstr rest = doc.range(pos + 3, _line_end(doc, pos)).trim(" \t\r\n");
+                if( ! rest.empty() && rest.str[0] != '#')
+                    break;
+                has_marker = true;
+                continue;
+            }
+            // properties at the start of the first entry may belong
+            // to the root collection, which the merge would drop
+            if(c == '!' || c == '&' || c == '*')
+                break;
+            type = _is_seq_entry(doc, pos) ? SEQ : (_is_map_entry(doc, pos) ? MAP : NOTYPE);
+            if(type == NOTYPE)
+                break;
+            entries.push(pos);
+        }
+        else if(type == SEQ)
+        {
+            if( ! _is_seq_entry(doc, pos))
+            {
+                type = NOTYPE;
+                break;
+            }
+            entries.push(pos);
+        }
+        else
+        {
+            // a map value can be a sequence at the same indentation
+            if(_is_seq_entry(doc, pos))
+                continue;
+            if( ! _is_map_entry(doc, pos) || doc.sub(pos).begins_with("..."))
+            {
+                type = NOTYPE;
+                break;
+            }
+            entries.push(pos);
+        }
+    }
+    if(type == NOTYPE || entries.size() < 2)
+    {
+        _parse_serial(filename, src, t);
+        return;
+    }
+
+    // group the entries in chunks of similar size; there are more
+    // chunks than threads, to balance the load
+    detail::stack<csubstr> chunks(t->allocator());
+    {
+        size_t num_chunks = 4 * num_threads;
+        const size_t first = entries[0];
+        const size_t len = doc.len - first;
+        size_t beg = first;
+        size_t e = 1;
+        for(size_t k = 1; k < num_chunks; ++k)
+        {
+            const size_t target = first + k * (len / num_chunks);
+            while(e < entries.size() && entries[e] < target)
+                ++e;
+            if(e == entries.size())
+                break;
+            if(entries[e] == beg)
+                continue;
+            chunks.push(doc.range(beg, entries[e]));
+            beg = entries[e];
+        }
+        chunks.push(doc.sub(beg));
+    }
+    num_threads = _num_threads(num_threads, chunks.size());
+
+    // first check the splits, before the source is copied to the arena
+    bool ok = chunks.size() > 1 && _run_jobs(t->allocator(), num_threads, chunks.size() - 1, [&](Parser *, size_t i){
+        return _chunk_is_closed(chunks[i]);
+    });
+    if( ! ok)
+    {
+        _parse_serial(filename, src, t);
+        return;
+    }
+
+    Trees trees(t->allocator(), chunks.size());
+    substr buf = t->copy_to_arena(src);
+    ok = _run_jobs(t->allocator(), num_threads, chunks.size(), [&](Parser *parser, size_t i){
+        substr chunk = buf.sub(static_cast<size_t>(chunks[i].str - src.str), chunks[i].len);
+        parser->parse(filename, chunk, &trees[i]);
+        // the chunk must have given entries of the collection
+        // (and not eg a plain scalar)
+        Tree const& ct = trees[i];
+        const size_t r = ct.root_id();
+        return ( ! ct.is_stream(r)) && (type == MAP ? ct.is_map(r) : ct.is_seq(r));
+    });
+    if( ! ok)
+    {
+        // either the split was wrong after all, or there is an error
+        // to report with its location in the whole source
+        _parse_serial_in_arena(filename, src, buf, t);
+        return;
+    }
+
+    // merge the entries in order into the collection
+    t->reserve(2 + trees.total_size());
+    size_t dst = t->root_id();
+    if(has_marker)
+    {
+        t->to_stream(dst);
+        dst = t->append_child(dst);
+    }
+    if(type == MAP)
+        t->to_map(dst, has_marker ? DOC : NOTYPE);
+    else
+        t->to_seq(dst, has_marker ? DOC : NOTYPE);
+    for(size_t i = 0; i < chunks.size(); ++i)
+        t->duplicate_children(&trees[i], trees[i].root_id(), dst, t->last_child(dst));
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,78 @@
+#ifndef _C4_YML_PARALLEL_HPP_
+#define _C4_YML_PARALLEL_HPP_
+
+/** @file parallel.hpp Parsing a source on several threads. */
+
+#ifndef _C4_YML_TREE_HPP_
+#include "c4/yml/tree.hpp"
+#endif
+
+#ifndef _C4_YML_NODE_HPP_
+#include "c4/yml/node.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+/** Parse a multi-document stream, parsing the documents concurrently.
+ *
+ * Documents have no dependencies on each other (anchors are local to
+ * their document), so once the document boundaries are found (with a
+ * cheap scan of the line starts, see DocReader), each document is
+ * parsed into its own tree by a pool of threads. The trees are then
+ * spliced in order under the STREAM root of @p t, giving the same tree
+ * as parse().
+ *
+ * As with parse(), the source is first copied to the tree's arena, and
+ * the root of @p t must have no children. A source with a single
+ * document is parsed serially.
+ *
+ * @param num_threads the number of threads to use, counting the
+ * calling thread. Zero means std::thread::hardware_concurrency().
+ *
+ * @note The memory resource of @p t is used from all the threads, so
+ * it must be thread-safe (the default one is).
+ *
+ * @note When the error callback throws, an error in any document is
+ * reported by parsing the whole source again in the calling thread, so
+ * that the exception is thrown there and with the location in the
+ * whole source. Otherwise the error callback is called from the thread
+ * where the error happened, with the location in the document. */
+RYML_EXPORT void parse_parallel(csubstr filename, csubstr src, Tree *t, size_t num_threads=0);
+
+inline void parse_parallel(csubstr src, Tree *t, size_t num_threads=0) { parse_parallel({}, src, t, num_threads); } //!< parse a multi-document stream, parsing the documents concurrently
+inline Tree parse_parallel(csubstr filename, csubstr src, size_t num_threads=0) { Tree t; parse_parallel(filename, src, &t, num_threads); return t; } //!< parse a multi-document stream, parsing the documents concurrently
+inline Tree parse_parallel(csubstr src, size_t num_threads=0) { Tree t; parse_parallel({}, src, &t, num_threads); return t; } //!< parse a multi-document stream, parsing the documents concurrently
+
+
+/** Parse a single document whose root is a big block map or sequence,
+ * by splitting it at its top-level entries and parsing groups of
+ * entries concurrently. This is opt-in, as unlike parse_parallel() the
+ * split is not always possible: it requires the entries to start at
+ * column 0 (ie, `key:` or `- `), so that they can be found from the
+ * line starts, and the split must not be inside a flow container or a
+ * quoted scalar. Block scalars cannot contain lines at column 0, and
+ * aliases are not resolved while parsing, so an alias can be in a
+ * different group from its anchor.
+ *
+ * The groups are checked with a cheap lexical pass before parsing them,
+ * and the parsed groups must be entries of the expected collection.
+ * When this is not the case, or when the document is not a block
+ * collection at column 0 (eg it is a flow collection, or its root or
+ * its first entry has a tag or an anchor), the source is parsed
+ * serially. Either way, the
+ * resulting tree is the same as from parse(). A multi-document stream
+ * is parsed as with parse_parallel().
+ *
+ * The other requirements and notes for parse_parallel() apply here as
+ * well. */
+RYML_EXPORT void parse_parallel_entries(csubstr filename, csubstr src, Tree *t, size_t num_threads=0);
+
+inline void parse_parallel_entries(csubstr src, Tree *t, size_t num_threads=0) { parse_parallel_entries({}, src, t, num_threads); } //!< parse a big block collection, parsing groups of its entries concurrently
+inline Tree parse_parallel_entries(csubstr filename, csubstr src, size_t num_threads=0) { Tree t; parse_parallel_entries(filename, src, &t, num_threads); return t; } //!< parse a big block collection, parsing groups of its entries concurrently
+inline Tree parse_parallel_entries(csubstr src, size_t num_threads=0) { Tree t; parse_parallel_entries({}, src, &t, num_threads); return t; } //!< parse a big block collection, parsing groups of its entries concurrently
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_PARALLEL_HPP_ */
@@ -4,8 +4,12 @@
 #include <ctype.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "c4/yml/detail/parser_dbg.hpp"
+#include "c4/yml/detail/json.hpp"
+#include "c4/yml/detail/filter.hpp"
+#include "c4/yml/detail/simd.hpp"
 #ifdef RYML_DBG
 #include "c4/yml/detail/print.hpp"
 #endif
@@ -55,6 +59,35 @@ static bool _is_scalar_next__rmap_val(csubstr s)
     return !(s.begins_with("- ") || s.begins_with_any("{[") || s == "-");
 }
 
+/** the scans below run on every scalar, and for long lines they are
+ * the bulk of the parse time. So they go through the block kernels in
+ * detail/simd.hpp instead of the char-by-char csubstr members. */
+static size_t _find(csubstr s, csubstr needle)
+{
+    const size_t pos = detail::simd::find(s.str, 0, s.len, needle.str, needle.len);
+    return pos < s.len ? pos : npos;
+}
+
+static size_t _first_of(csubstr s, csubstr chars)
+{
+    const size_t pos = detail::simd::first_of(s.str, 0, s.len, chars.str, chars.len);
+    return pos < s.len ? pos : npos;
+}
+
+/** in flow context, a plain scalar cannot extend beyond the first of
+ * the flow terminators. So restrict the lookups done on the scalar to
+ * that span, plus enough slack to see any two-character token
+ * straddling the terminator. The scan cost is then bounded by the
+ * token length instead of the line length, which matters for minified
+ * JSON, where the whole document sits in a single line. */
+static csubstr _flow_scalar_span(csubstr s, csubstr terminators)
+{
+    size_t pos = _first_of(s, terminators);
+    if(pos == npos || pos + 3 >= s.len)
+        return s;
+    return s.first(pos + 3);
+}
+
 static bool _is_doc_sep(csubstr s)
 {
     constexpr const csubstr dashes = "---";
@@ -76,6 +109,10 @@ Parser::Parser(Allocator const& a)
     , m_tree()
     , m_stack(a)
     , m_state()
+    , m_pos()
+    , m_line_contents()
+    , m_newlines(a)
+    , m_json_stack(a)
     , m_key_tag_indentation(0)
     , m_key_tag2_indentation(0)
     , m_key_tag()
@@ -87,6 +124,12 @@ Parser::Parser(Allocator const& a)
     , m_key_anchor()
     , m_val_anchor_indentation(0)
     , m_val_anchor()
+    , m_lazy_filtering(false)
+    , m_raw_scalars(a)
+    , m_locations_enabled(false)
+    , m_locations(a)
+    , m_line_starts(a)
+    , m_restrictions(0)
 {
     State st{};
     m_stack.push(st);
@@ -103,7 +146,12 @@ void Parser::_reset()
     m_stack.clear();
     m_stack.push({});
     m_state = &m_stack.top();
-    m_state->reset(m_file.str, m_root_id);
+    m_state->reset(m_root_id);
+    m_pos.name = m_file;
+    m_pos.offset = 0;
+    m_pos.line = 1;
+    m_pos.col = 1;
+    m_line_contents = {};
 
     m_key_tag_indentation = 0;
     m_key_tag2_indentation = 0;
@@ -116,12 +164,16 @@ void Parser::_reset()
     m_key_anchor.clear();
     m_val_anchor_indentation = 0;
     m_val_anchor.clear();
+
+    m_raw_scalars.clear();
+    m_locations.clear();
+    m_line_starts.clear();
 }
 
 //-----------------------------------------------------------------------------
 bool Parser::_finished_file() const
 {
-    bool ret = m_state->pos.offset >= m_buf.len;
+    bool ret = m_pos.offset >= m_buf.len;
     if(ret)
     {
         _c4dbgp("finished file!!!");
@@ -132,7 +184,7 @@ bool Parser::_finished_file() const
 //-----------------------------------------------------------------------------
 bool Parser::_finished_line() const
 {
-    bool ret = m_state->line_contents.rem.empty();
+    bool ret = m_line_contents.rem.empty();
     return ret;
 }
 
@@ -144,7 +196,10 @@ void Parser::parse(csubstr file, substr buf, Tree *t, size_t node_id)
     m_root_id = node_id;
     m_tree = t;
 
+    m_newlines.build(m_buf);
     _reset();
+    if(m_locations_enabled)
+        _record_location(m_root_id);
 
     while( ! _finished_file())
     {
@@ -157,65 +212,304 @@ void Parser::parse(csubstr file, substr buf, Tree *t, size_t node_id)
     }
 
     _handle_finished_file();
+    _finish_raw_scalars();
 }
 
 //-----------------------------------------------------------------------------
-void Parser::_handle_finished_file()
-{
-    _end_stream();
-}
 
-//-----------------------------------------------------------------------------
-void Parser::_handle_line()
+/** The json state machine. The json grammar needs no lookahead beyond
+ * the current token, so the only state is the stack of the containers
+ * currently open, each represented by its closing character. */
+template<class Handler>
+void Parser::_parse_json(Handler *handler)
 {
-    _c4dbgq("\n-----------");
-    _c4dbgt("handling line=%zu, offset=%zuB", m_state->pos.line, m_state->pos.offset);
-
-    RYML_ASSERT( ! m_state->line_contents.rem.empty());
-
-    if(has_any(RSEQ))
+    m_json_stack.clear();
+    csubstr s;
+    size_t pos = _json_skip_ws(0);
+    if(pos == m_buf.len)
+    {
+        _json_locate(pos);
+        _c4err("json: empty document");
+        return;
+    }
+    handler->begin_doc();
+    while(true)
     {
-        if(has_any(EXPL))
+        // read a value
+        if(pos >= m_buf.len)
         {
-            if(_handle_seq_expl())
-                return;
+            _json_locate(m_buf.len);
+            _c4err("json: unexpected end of document, expected a value");
+            return;
+        }
+        const char c = m_buf.str[pos];
+        if(c == '{' || c == '[')
+        {
+            const char closing = c == '{' ? '}' : ']';
+            if(c == '{')
+                handler->begin_map();
+            else
+                handler->begin_seq();
+            m_json_stack.push(closing);
+            pos = _json_skip_ws(pos + 1);
+            if(pos < m_buf.len && m_buf.str[pos] != closing)
+            {
+                if(c == '{')
+                {
+                    pos = _json_scan_key(pos, &s);
+                    handler->key(s, true);
+                }
+                continue;
+            }
+            // empty container: the closing char is handled below
+        }
+        else if(c == '"')
+        {
+            pos = _json_scan_string(pos, &s);
+            handler->scalar(s, true);
         }
         else
         {
-            if(_handle_seq_impl())
+            pos = _json_scan_literal(pos, &s);
+            handler->scalar(s != "null" ? s : csubstr{}, false);
+        }
+        // the value is complete. Now get to the next value,
+        // closing as many containers as needed.
+        while(true)
+        {
+            pos = _json_skip_ws(pos);
+            if(m_json_stack.empty())
+            {
+                if(pos != m_buf.len)
+                {
+                    _json_locate(pos);
+                    _c4err("json: unexpected characters after the document");
+                    return;
+                }
+                handler->end_doc();
+                return;
+            }
+            const char closing = m_json_stack.top();
+            if(pos >= m_buf.len)
+            {
+                _json_locate(m_buf.len);
+                _c4err("json: unexpected end of document, expected '%c'", closing);
                 return;
+            }
+            const char n = m_buf.str[pos];
+            if(n == ',')
+            {
+                pos = _json_skip_ws(pos + 1);
+                if(closing == '}')
+                {
+                    pos = _json_scan_key(pos, &s);
+                    handler->key(s, true);
+                }
+                break;
+            }
+            else if(n == closing)
+            {
+                ++pos;
+                m_json_stack.pop();
+                if(closing == '}')
+                    handler->end_map();
+                else
+                    handler->end_seq();
+            }
+            else
+            {
+                _json_locate(pos);
+                _c4err("json: expected ',' or '%c'", closing);
+                return;
+            }
         }
     }
-    else if(has_any(RMAP))
+}
+
+void Parser::parse_json(csubstr file, substr buf, Tree *t, size_t node_id)
+{
+    m_file = file;
+    m_buf = buf;
+    m_root_id = node_id;
+    m_tree = t;
+
+    m_newlines.clear(); // only needed to locate errors; built on demand
+    _reset();
+
+    RYML_CHECK( ! m_tree->has_children(node_id));
+
+    detail::JsonTreeBuilder builder(t, node_id);
+    _parse_json(&builder);
+}
+
+void Parser::parse_json(csubstr file, substr buf, EventHandler *handler)
+{
+    RYML_CHECK(handler != nullptr);
+
+    m_file = file;
+    m_buf = buf;
+    m_root_id = NONE;
+    m_tree = nullptr;
+
+    m_newlines.clear(); // only needed to locate errors; built on demand
+    _reset();
+
+    _parse_json(handler);
+}
+
+size_t Parser::_json_skip_ws(size_t pos) const
+{
+    while(pos < m_buf.len)
     {
-        if(has_any(EXPL))
+        if( ! detail::is_json_ws(m_buf.str[pos]))
+            break;
+        ++pos;
+    }
+    return pos;
+}
+
+/** scan a map key and the following colon; returns the position of
+ * the value */
+size_t Parser::_json_scan_key(size_t pos, csubstr *key)
+{
+    if(pos >= m_buf.len || m_buf.str[pos] != '"')
+    {
+        _json_locate(pos);
+        _c4err("json: expected a string as the map key");
+        return m_buf.len;
+    }
+    pos = _json_skip_ws(_json_scan_string(pos, key));
+    if(pos >= m_buf.len || m_buf.str[pos] != ':')
+    {
+        _json_locate(pos);
+        _c4err("json: expected ':' after the map key");
+        return m_buf.len;
+    }
+    return _json_skip_ws(pos + 1);
+}
+
+/** scan a string starting at the opening quote in @p pos; returns the
+ * position after the closing quote. Escapes are filtered in place, and
+ * only if there are any. */
+size_t Parser::_json_scan_string(size_t pos, csubstr *s)
+{
+    RYML_ASSERT(m_buf.str[pos] == '"');
+    const size_t beg = pos + 1;
+    bool escaped = false;
+    for(size_t i = beg; i < m_buf.len; ++i)
+    {
+        const char c = m_buf.str[i];
+        if(c == '"')
         {
-            if(_handle_map_expl())
-                return;
+            substr str = m_buf.range(beg, i);
+            *s = escaped ? _filter_json_dquot_scalar(str) : str;
+            return i + 1;
         }
-        else
+        else if(c == '\\')
         {
-            if(_handle_map_impl())
-                return;
+            escaped = true;
+            ++i; // the escaped character cannot close the string
+        }
+        else if(static_cast<unsigned char>(c) < 0x20)
+        {
+            _json_locate(i);
+            _c4err("json: control characters must be escaped in strings");
+            return m_buf.len;
         }
     }
-    else if(has_any(RUNK))
+    _json_locate(pos);
+    _c4err("json: unterminated string");
+    return m_buf.len;
+}
+
+/** scan one of true, false, null or a number */
+size_t Parser::_json_scan_literal(size_t pos, csubstr *s)
+{
+    size_t e = pos;
+    while(e < m_buf.len && ! detail::is_json_literal_end(m_buf.str[e]))
+        ++e;
+    *s = m_buf.range(pos, e);
+    if( ! detail::is_json_literal(*s))
     {
-        if(_handle_unk())
-            return;
+        _json_locate(pos);
+        _c4err("json: invalid value '%.*s'", _c4prsp(*s));
     }
+    return e;
+}
+
+/** set the parser location to the offset @p pos, for use in error
+ * messages. The json parser does not track lines, so this is done only
+ * when needed. */
+void Parser::_json_locate(size_t pos)
+{
+    if(pos > m_buf.len)
+        pos = m_buf.len;
+    if(m_newlines.size() == 0)
+        m_newlines.build(m_buf);
+    csubstr before = m_buf.first(pos);
+    size_t beg = before.last_of('\n');
+    beg = beg != npos ? beg + 1 : 0;
+    m_line_contents.reset_with_next_line(m_newlines, m_buf, beg);
+    m_line_contents.rem = m_line_contents.stripped.sub(pos - beg < m_line_contents.stripped.len ? pos - beg : m_line_contents.stripped.len);
+    m_pos.offset = pos;
+    m_pos.line = 1 + before.count('\n');
+    m_pos.col = 1 + pos - beg;
+}
+
+//-----------------------------------------------------------------------------
+void Parser::_handle_finished_file()
+{
+    _end_stream();
+}
+
+//-----------------------------------------------------------------------------
+void Parser::_handle_line()
+{
+    _c4dbgq("\n-----------");
+    _c4dbgt("handling line=%zu, offset=%zuB", m_pos.line, m_pos.offset);
+
+    RYML_ASSERT( ! m_line_contents.rem.empty());
 
-    if(_handle_top())
+    // dispatch on the state code in a single indirect call, instead of
+    // testing the flags one by one
+    static_assert(RMAP == (RUNK << 1) && RSEQ == (RUNK << 2) && EXPL == (RUNK << 3), "the state code needs these flags to be contiguous");
+    const pfn_line_handler handler = s_line_handlers[(m_state->flags / RUNK) & 0xfu];
+    if(handler && (this->*handler)())
         return;
+
+    _handle_top();
 }
 
+/* The handlers follow the precedence of the flags: RSEQ over RMAP over
+ * RUNK, and EXPL picks the flow handler of a seq or map. */
+const Parser::pfn_line_handler Parser::s_line_handlers[16] = {
+    // block (or top level), indexed by RUNK|RMAP|RSEQ
+    nullptr,                   // -
+    &Parser::_handle_unk,      // RUNK
+    &Parser::_handle_map_impl, // RMAP
+    &Parser::_handle_map_impl, // RMAP|RUNK
+    &Parser::_handle_seq_impl, // RSEQ
+    &Parser::_handle_seq_impl, // RSEQ|RUNK
+    &Parser::_handle_seq_impl, // RSEQ|RMAP
+    &Parser::_handle_seq_impl, // RSEQ|RMAP|RUNK
+    // EXPL, indexed by RUNK|RMAP|RSEQ
+    nullptr,                   // -
+    &Parser::_handle_unk,      // RUNK
+    &Parser::_handle_map_expl, // RMAP
+    &Parser::_handle_map_expl, // RMAP|RUNK
+    &Parser::_handle_seq_expl, // RSEQ
+    &Parser::_handle_seq_expl, // RSEQ|RUNK
+    &Parser::_handle_seq_expl, // RSEQ|RMAP
+    &Parser::_handle_seq_expl, // RSEQ|RMAP|RUNK
+};
+
 
 //-----------------------------------------------------------------------------
 bool Parser::_handle_unk()
 {
     _c4dbgp("handle_unk");
 
-    csubstr rem = m_state->line_contents.rem;
+    csubstr rem = m_line_contents.rem;
     const bool start_as_child = (node(m_state) == nullptr);
 
     if(C4_UNLIKELY(has_any(NDOC)))
@@ -312,6 +606,7 @@ bool Parser::_handle_unk()
     else if(rem.begins_with("? "))
     {
         _c4dbgpf("it's a map (as_child=%d) + this key is complex", start_as_child);
+        _check_restriction(NO_COMPLEX_KEYS, "complex keys");
         _move_key_anchor_to_val_anchor();
         _move_key_tag_to_val_tag();
         _push_level();
@@ -363,7 +658,7 @@ bool Parser::_handle_unk()
         bool is_quoted;
         if(_scan_scalar(&saved_scalar, &is_quoted))
         {
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
             _c4dbgpf("... and there's also a scalar next! '%.*s'", _c4prsp(saved_scalar));
             if(rem.begins_with_any(" \t"))
             {
@@ -463,6 +758,7 @@ bool Parser::_handle_unk()
         else if(rem.begins_with('%'))
         {
             _c4dbgp("caught a directive: ignoring...");
+            _check_restriction(NO_DIRECTIVES, "directives");
             _line_progressed(rem.len);
             return true;
         }
@@ -482,12 +778,12 @@ bool Parser::_handle_unk()
     {
         RYML_ASSERT( ! has_any(SSCL));
         csubstr scalar;
-        size_t indentation = m_state->line_contents.indentation; // save
+        size_t indentation = m_line_contents.indentation; // save
         bool is_quoted;
         if(_scan_scalar(&scalar, &is_quoted))
         {
             _c4dbgpf("got a %s scalar", is_quoted ? "quoted" : "");
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
             _store_scalar(scalar, is_quoted);
             if(rem.begins_with(": "))
             {
@@ -534,7 +830,7 @@ bool Parser::_handle_unk()
 bool Parser::_handle_seq_expl()
 {
     _c4dbgpf("handle_seq_expl: node_id=%zd level=%zd", m_state->node_id, m_state->level);
-    csubstr rem = m_state->line_contents.rem;
+    csubstr rem = m_line_contents.rem;
 
     RYML_ASSERT(has_none(RKEY));
     RYML_ASSERT(has_all(RSEQ|EXPL));
@@ -615,6 +911,7 @@ bool Parser::_handle_seq_expl()
         else if(rem.begins_with("? "))
         {
             _c4dbgpf("found '? ' -- there's an implicit map in the seq node[%zu]", m_state->node_id);
+            _check_restriction(NO_COMPLEX_KEYS, "complex keys");
             _start_seqimap();
             _line_progressed(2);
             RYML_ASSERT(has_any(SSCL) && m_state->scalar == "");
@@ -698,7 +995,7 @@ bool Parser::_handle_seq_expl()
 bool Parser::_handle_seq_impl()
 {
     _c4dbgpf("handle_seq_impl: node_id=%zd level=%zd", m_state->node_id, m_state->level);
-    csubstr rem = m_state->line_contents.rem;
+    csubstr rem = m_line_contents.rem;
 
     RYML_ASSERT(has_all(RSEQ));
     RYML_ASSERT(has_none(RKEY));
@@ -772,7 +1069,7 @@ bool Parser::_handle_seq_impl()
         {
             _c4dbgpf("it's a%s scalar", is_quoted ? " quoted" : "");
 
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
             if(rem.begins_with(' '))
             {
                 _c4dbgp("skipping whitespace...");
@@ -846,6 +1143,7 @@ bool Parser::_handle_seq_impl()
         else if(rem.begins_with("? "))
         {
             _c4dbgp("val is a child map + this key is complex");
+            _check_restriction(NO_COMPLEX_KEYS, "complex keys");
             addrem_flags(RNXT, RVAL); // before _push_level!
             _push_level();
             _start_map();
@@ -911,7 +1209,7 @@ bool Parser::_handle_seq_impl()
 
 bool Parser::_rval_dash_start_or_continue_seq()
 {
-    size_t ind = m_state->line_contents.current_col();
+    size_t ind = m_line_contents.current_col();
     RYML_ASSERT(ind >= m_state->indref);
     size_t delta_ind = ind - m_state->indref;
     if( ! delta_ind)
@@ -934,7 +1232,7 @@ bool Parser::_handle_map_expl()
 {
     // explicit flow, ie, inside {}, separated by commas
     _c4dbgpf("handle_map_expl: node_id=%zd  level=%zd", m_state->node_id, m_state->level);
-    csubstr rem = m_state->line_contents.rem;
+    csubstr rem = m_line_contents.rem;
 
     RYML_ASSERT(has_all(RMAP|EXPL));
 
@@ -1008,7 +1306,7 @@ bool Parser::_handle_map_expl()
         {
             _c4dbgp("it's a scalar");
             _store_scalar(rem, is_quoted);
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
             csubstr trimmed = rem.triml(" \t");
             if(trimmed.len && (trimmed.begins_with(": ") || trimmed.begins_with_any(":,}")))
             {
@@ -1047,6 +1345,7 @@ bool Parser::_handle_map_expl()
         else if(rem.begins_with('?'))
         {
             _c4dbgp("complex key");
+            _check_restriction(NO_COMPLEX_KEYS, "complex keys");
             add_flags(CPLX);
             _line_progressed(1);
             return true;
@@ -1215,7 +1514,7 @@ bool Parser::_handle_map_expl()
 bool Parser::_handle_map_impl()
 {
     _c4dbgpf("handle_map_impl: node_id=%zd  level=%zd", m_state->node_id, m_state->level);
-    csubstr rem = m_state->line_contents.rem;
+    csubstr rem = m_line_contents.rem;
 
     RYML_ASSERT(has_all(RMAP));
     RYML_ASSERT(has_none(EXPL));
@@ -1237,7 +1536,7 @@ bool Parser::_handle_map_impl()
 
     if(_handle_indentation())
     {
-        //rem = m_state->line_contents.rem;
+        //rem = m_line_contents.rem;
         return true;
     }
 
@@ -1259,14 +1558,14 @@ bool Parser::_handle_map_impl()
                 _c4dbgp("it's a complex key, so use null value '~'");
                 _append_key_val_null();
             }
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
 
             if(rem.begins_with(':'))
             {
                 _c4dbgp("wait for val");
                 addrem_flags(RVAL, RKEY|CPLX);
                 _line_progressed(1);
-                rem = m_state->line_contents.rem;
+                rem = m_line_contents.rem;
                 if(rem.begins_with_any(" \t"))
                 {
                     RYML_ASSERT( ! _at_line_begin());
@@ -1288,6 +1587,7 @@ bool Parser::_handle_map_impl()
         else if(rem.begins_with("? "))
         {
             _c4dbgp("it's a complex key");
+            _check_restriction(NO_COMPLEX_KEYS, "complex keys");
             add_flags(CPLX);
             _line_progressed(2);
             if(has_any(SSCL))
@@ -1299,7 +1599,7 @@ bool Parser::_handle_map_impl()
             _c4dbgp("complex key finished");
             addrem_flags(RVAL, RKEY|CPLX);
             _line_progressed(1);
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
             if(rem.begins_with(' '))
             {
                 RYML_ASSERT( ! _at_line_begin());
@@ -1370,7 +1670,7 @@ bool Parser::_handle_map_impl()
         {
             _c4dbgpf("it's a%s scalar", is_quoted ? " quoted" : "");
 
-            rem = m_state->line_contents.rem;
+            rem = m_line_contents.rem;
 
             if(rem.begins_with(": "))
             {
@@ -1491,7 +1791,7 @@ bool Parser::_handle_map_impl()
 bool Parser::_handle_top()
 {
     _c4dbgp("handle_top");
-    csubstr rem = m_state->line_contents.rem;
+    csubstr rem = m_line_contents.rem;
 
     if(rem.begins_with('#'))
     {
@@ -1505,6 +1805,7 @@ bool Parser::_handle_top()
     if(trimmed.begins_with('%'))
     {
         _c4dbgpf("%% directive! ignoring...: '%.*s'", _c4prsp(rem));
+        _check_restriction(NO_DIRECTIVES, "directives");
         _line_progressed(rem.len);
         return true;
     }
@@ -1540,13 +1841,20 @@ bool Parser::_handle_top()
 
 //-----------------------------------------------------------------------------
 
+void Parser::_check_restriction(size_t restriction, const char *feature) const
+{
+    if(C4_UNLIKELY(m_restrictions & restriction))
+        _c4err("%s are disabled in this parser", feature);
+}
+
 bool Parser::_handle_key_anchors_and_refs()
 {
     RYML_ASSERT(!has_any(RVAL));
-    const csubstr rem = m_state->line_contents.rem;
+    const csubstr rem = m_line_contents.rem;
     if(rem.begins_with('&'))
     {
         _c4dbgp("found a key anchor!!!");
+        _check_restriction(NO_ANCHORS, "anchors");
         if(has_all(CPLX|SSCL))
         {
             RYML_ASSERT(has_any(RKEY));
@@ -1561,7 +1869,7 @@ bool Parser::_handle_key_anchors_and_refs()
         _move_key_anchor_to_val_anchor();
         _c4dbgpf("key anchor value: '%.*s'", _c4prsp(anchor));
         m_key_anchor = anchor;
-        m_key_anchor_indentation = m_state->line_contents.current_col(rem);
+        m_key_anchor_indentation = m_line_contents.current_col(rem);
         return true;
     }
     else if(C4_UNLIKELY(rem.begins_with('*')))
@@ -1576,18 +1884,19 @@ bool Parser::_handle_key_anchors_and_refs()
 bool Parser::_handle_val_anchors_and_refs()
 {
     RYML_ASSERT(!has_any(RKEY));
-    const csubstr rem = m_state->line_contents.rem;
+    const csubstr rem = m_line_contents.rem;
     if(rem.begins_with('&'))
     {
+        _check_restriction(NO_ANCHORS, "anchors");
         csubstr anchor = rem.left_of(rem.first_of(' '));
         _line_progressed(anchor.len);
         anchor = anchor.sub(1); // skip the first character
-        _c4dbgpf("val: found an anchor: '%.*s', indentation=%zu!!!", _c4prsp(anchor), m_state->line_contents.current_col(rem));
+        _c4dbgpf("val: found an anchor: '%.*s', indentation=%zu!!!", _c4prsp(anchor), m_line_contents.current_col(rem));
         if(m_val_anchor.empty())
         {
             _c4dbgpf("save val anchor: '%.*s'", _c4prsp(anchor));
             m_val_anchor = anchor;
-            m_val_anchor_indentation = m_state->line_contents.current_col(rem);
+            m_val_anchor_indentation = m_line_contents.current_col(rem);
         }
         else
         {
@@ -1599,7 +1908,7 @@ bool Parser::_handle_val_anchors_and_refs()
                     _c4dbgpf("current node=%zu is a seq, has %zu children", m_state->node_id, m_tree->num_children(m_state->node_id));
                     _c4dbgpf("... so take the new one as a key anchor '%.*s'", _c4prsp(anchor));
                     m_key_anchor = anchor;
-                    m_key_anchor_indentation = m_state->line_contents.current_col(rem);
+                    m_key_anchor_indentation = m_line_contents.current_col(rem);
                 }
                 else
                 {
@@ -1609,14 +1918,14 @@ bool Parser::_handle_val_anchors_and_refs()
                         _c4dbgpf("... node=%zu already has val anchor: '%.*s'", m_state->node_id, _c4prsp(m_tree->val_anchor(m_state->node_id)));
                         _c4dbgpf("... so take the new one as a key anchor '%.*s'", _c4prsp(anchor));
                         m_key_anchor = anchor;
-                        m_key_anchor_indentation = m_state->line_contents.current_col(rem);
+                        m_key_anchor_indentation = m_line_contents.current_col(rem);
                     }
                     else
                     {
                         _c4dbgpf("... so set pending val anchor: '%.*s' on current node %zu", _c4prsp(m_val_anchor), m_state->node_id);
                         m_tree->set_val_anchor(m_state->node_id, m_val_anchor);
                         m_val_anchor = anchor;
-                        m_val_anchor_indentation = m_state->line_contents.current_col(rem);
+                        m_val_anchor_indentation = m_line_contents.current_col(rem);
                     }
                 }
             }
@@ -1700,9 +2009,16 @@ void Parser::_move_key_tag2_to_key_tag()
 
 bool Parser::_handle_types()
 {
-    csubstr rem = m_state->line_contents.rem.triml(' ');
+    csubstr rem = m_line_contents.rem.triml(' ');
     csubstr t;
 
+    if(m_restrictions & NO_TAGS)
+    {
+        if(rem.begins_with('!'))
+            _check_restriction(NO_TAGS, "tags");
+        return false;
+    }
+
     if(rem.begins_with("!!"))
     {
         _c4dbgp("begins with '!!'");
@@ -1745,10 +2061,10 @@ bool Parser::_handle_types()
         rem_flags(CPLX);
     }
 
-    size_t tag_indentation = m_state->line_contents.current_col(t);
+    size_t tag_indentation = m_line_contents.current_col(t);
     _c4dbgpf("there was a tag: '%.*s', indentation=%zu", _c4prsp(t), tag_indentation);
-    RYML_ASSERT(t.end() > m_state->line_contents.rem.begin());
-    _line_progressed(static_cast<size_t>(t.end() - m_state->line_contents.rem.begin()));
+    RYML_ASSERT(t.end() > m_line_contents.rem.begin());
+    _line_progressed(static_cast<size_t>(t.end() - m_line_contents.rem.begin()));
 
     if(has_all(RMAP|RKEY))
     {
@@ -1761,19 +2077,27 @@ bool Parser::_handle_types()
     {
         /* foo: !!str
          * !!str : bar  */
-        rem = m_state->line_contents.rem;
-        rem = rem.left_of(rem.find("#"));
-        rem = rem.trim(" \t");
+        rem = m_line_contents.rem.triml(" \t");
         _c4dbgpf("rem='%.*s'", _c4prsp(rem));
-        if(rem == ':' || rem.begins_with(": "))
+        // look only at the token after the tag: is it a ':' followed
+        // by a space, or by blanks up to a comment or the line end?
+        bool null_key = rem.begins_with(": ");
+        if(!null_key && rem.begins_with(':'))
+        {
+            size_t pos = rem.first_not_of(" \t", 1);
+            null_key = (pos == npos || rem.str[pos] == '#');
+            if(null_key)
+                rem = rem.first(1);
+        }
+        if(null_key)
         {
             _c4dbgp("the last val was null, and this is a tag from a null key");
             _append_key_val_null();
             _store_scalar_null();
             // do not change the flag to key, it is ~
-            RYML_ASSERT(rem.begin() > m_state->line_contents.rem.begin());
+            RYML_ASSERT(rem.begin() > m_line_contents.rem.begin());
             size_t token_len = rem == ':' ? 1 : 2;
-            _line_progressed(static_cast<size_t>(token_len + rem.begin() - m_state->line_contents.rem.begin()));
+            _line_progressed(static_cast<size_t>(token_len + rem.begin() - m_line_contents.rem.begin()));
         }
         _c4dbgpf("saving map val tag '%.*s'", _c4prsp(t));
         RYML_ASSERT(m_val_tag.empty());
@@ -1797,7 +2121,7 @@ bool Parser::_handle_types()
     }
     else if(has_all(RTOP|RUNK) || has_any(RUNK))
     {
-        rem = m_state->line_contents.rem;
+        rem = m_line_contents.rem;
         rem = rem.left_of(rem.find("#"));
         rem = rem.trim(" \t");
         if(rem.empty())
@@ -1842,9 +2166,9 @@ bool Parser::_handle_types()
             _c4dbgpf("tag '%.*s' is a str-type tag", _c4prsp(t));
             if(has_all(RTOP|RUNK|NDOC))
             {
-                _c4dbgpf("docval. slurping the string. pos=%zu", m_state->pos.offset);
+                _c4dbgpf("docval. slurping the string. pos=%zu", m_pos.offset);
                 csubstr scalar = _slurp_doc_scalar();
-                _c4dbgpf("docval. after slurp: %zu, at node %zu: '%.*s'", m_state->pos.offset, m_state->node_id, _c4prsp(scalar));
+                _c4dbgpf("docval. after slurp: %zu, at node %zu: '%.*s'", m_pos.offset, m_state->node_id, _c4prsp(scalar));
                 m_tree->to_val(m_state->node_id, scalar, DOC);
                 m_tree->set_val_tag(m_state->node_id, normalize_tag(m_val_tag));
                 m_val_tag.clear();
@@ -1864,51 +2188,51 @@ bool Parser::_handle_types()
 //-----------------------------------------------------------------------------
 csubstr Parser::_slurp_doc_scalar()
 {
-    csubstr s = m_state->line_contents.rem;
-    size_t pos = m_state->pos.offset;
-    RYML_ASSERT(m_state->line_contents.full.find("---") != csubstr::npos);
-    _c4dbgpf("slurp 0 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_state->pos.offset)));
+    csubstr s = m_line_contents.rem;
+    size_t pos = m_pos.offset;
+    RYML_ASSERT(m_line_contents.full.find("---") != csubstr::npos);
+    _c4dbgpf("slurp 0 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_pos.offset)));
     if(s.len == 0)
     {
         _line_ended();
         _scan_line();
-        s = m_state->line_contents.rem;
-        pos = m_state->pos.offset;
+        s = m_line_contents.rem;
+        pos = m_pos.offset;
     }
 
     size_t skipws = s.first_not_of(" \t");
-    _c4dbgpf("slurp 1 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_state->pos.offset)));
+    _c4dbgpf("slurp 1 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_pos.offset)));
     if(skipws != npos)
     {
         _line_progressed(skipws);
-        s = m_state->line_contents.rem;
-        pos = m_state->pos.offset;
-        _c4dbgpf("slurp 2 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_state->pos.offset)));
+        s = m_line_contents.rem;
+        pos = m_pos.offset;
+        _c4dbgpf("slurp 2 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_pos.offset)));
     }
 
     RYML_ASSERT(m_val_anchor.empty());
     _handle_val_anchors_and_refs();
     if(!m_val_anchor.empty())
     {
-        s = m_state->line_contents.rem;
+        s = m_line_contents.rem;
         skipws = s.first_not_of(" \t");
         if(skipws != npos)
         {
             _line_progressed(skipws);
         }
-        s = m_state->line_contents.rem;
-        pos = m_state->pos.offset;
-        _c4dbgpf("slurp 3 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_state->pos.offset)));
+        s = m_line_contents.rem;
+        pos = m_pos.offset;
+        _c4dbgpf("slurp 3 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_pos.offset)));
     }
 
     if(s.begins_with('\''))
     {
-        m_state->scalar_col = m_state->line_contents.current_col(s);
+        m_state->scalar_col = m_line_contents.current_col(s);
         return _scan_quoted_scalar('\'');
     }
     else if(s.begins_with('"'))
     {
-        m_state->scalar_col = m_state->line_contents.current_col(s);
+        m_state->scalar_col = m_line_contents.current_col(s);
         return _scan_quoted_scalar('"');
     }
     else if(s.begins_with('|') || s.begins_with('>'))
@@ -1916,13 +2240,13 @@ csubstr Parser::_slurp_doc_scalar()
         return _scan_block();
     }
 
-    _c4dbgpf("slurp 4 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_state->pos.offset)));
+    _c4dbgpf("slurp 4 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_pos.offset)));
 
-    m_state->scalar_col = m_state->line_contents.current_col(s);
+    m_state->scalar_col = m_line_contents.current_col(s);
     RYML_ASSERT(s.end() >= m_buf.begin() + pos);
     _line_progressed(static_cast<size_t>(s.end() - (m_buf.begin() + pos)));
 
-    _c4dbgpf("slurp 5 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_state->pos.offset)));
+    _c4dbgpf("slurp 5 '%.*s'. REM='%.*s'", _c4prsp(s), _c4prsp(m_buf.sub(m_pos.offset)));
 
     if(_at_line_end())
     {
@@ -1938,7 +2262,7 @@ csubstr Parser::_slurp_doc_scalar()
 //-----------------------------------------------------------------------------
 bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
 {
-    csubstr s = m_state->line_contents.rem;
+    csubstr s = m_line_contents.rem;
     if(s.len == 0)
         return false;
     s = s.trim(" \t");
@@ -1948,7 +2272,7 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
     if(s.begins_with('\''))
     {
         _c4dbgp("got a ': scanning single-quoted scalar");
-        m_state->scalar_col = m_state->line_contents.current_col(s);
+        m_state->scalar_col = m_line_contents.current_col(s);
         *scalar = _scan_quoted_scalar('\'');
         *quoted = true;
         return true;
@@ -1956,7 +2280,7 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
     else if(s.begins_with('"'))
     {
         _c4dbgp("got a \": scanning double-quoted scalar");
-        m_state->scalar_col = m_state->line_contents.current_col(s);
+        m_state->scalar_col = m_line_contents.current_col(s);
         *scalar = _scan_quoted_scalar('"');
         *quoted = true;
         return true;
@@ -1979,14 +2303,16 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
             _c4dbgp("RSEQ|RVAL");
             if( ! _is_scalar_next__rseq_rval(s))
                 return false;
-            s = s.left_of(s.find(" #")); // is there a comment?
-            s = s.left_of(s.find(": ")); // is there a key-value?
+            if(has_all(EXPL))
+                s = _flow_scalar_span(s, ",]");
+            s = s.left_of(_find(s, " #")); // is there a comment?
+            s = s.left_of(_find(s, ": ")); // is there a key-value?
             if(s.ends_with(':'))
                 s = s.left_of(s.len-1);
             if(has_all(EXPL))
             {
                 _c4dbgp("RSEQ|RVAL|EXPL");
-                s = s.left_of(s.first_of(",]"));
+                s = s.left_of(_first_of(s, ",]"));
             }
             s = s.trimr(' ');
         }
@@ -2005,7 +2331,9 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
     {
         if( ! _is_scalar_next__rmap(s))
             return false;
-        size_t colon_space = s.find(": ");
+        if(has_any(EXPL) && has_none(CPLX))
+            s = _flow_scalar_span(s, has_all(RVAL|RSEQIMAP) ? ",]" : ",}");
+        size_t colon_space = _find(s, ": ");
         if(colon_space == npos)
         {
             colon_space = s.find(":");
@@ -2035,7 +2363,7 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
                 if(has_any(EXPL))
                 {
                     _c4dbgpf("RMAP|RVAL|EXPL: '%.*s'", _c4prsp(s));
-                    s = s.left_of(s.first_of(",}"));
+                    s = s.left_of(_first_of(s, ",}"));
                     if(s.ends_with(':'))
                         s = s.offs(0, 1);
                 }
@@ -2057,15 +2385,15 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
             {
                 return false;
             }
-            s = s.left_of(s.find(" #")); // is there a comment?
-            s = s.left_of(s.find("\t#")); // is there a comment?
+            s = s.left_of(_find(s, " #")); // is there a comment?
+            s = s.left_of(_find(s, "\t#")); // is there a comment?
             if(has_any(EXPL))
             {
                 _c4dbgp("RMAP|RVAL|EXPL");
                 if(has_none(RSEQIMAP))
-                    s = s.left_of(s.first_of(",}"));
+                    s = s.left_of(_first_of(s, ",}"));
                 else
-                    s = s.left_of(s.first_of(",]"));
+                    s = s.left_of(_first_of(s, ",]"));
             }
             s = s.trim(' ');
             if(s.begins_with("---"))
@@ -2086,8 +2414,8 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
             _c4dbgp("RUNK: no scalar next");
             return false;
         }
-        s = s.left_of(s.find(" #"));
-        size_t pos = s.find(": ");
+        s = s.left_of(_find(s, " #"));
+        size_t pos = _find(s, ": ");
         if(pos != npos)
             s = s.left_of(pos);
         else if(s.ends_with(':'))
@@ -2105,9 +2433,9 @@ bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
     if(s.empty())
         return false;
 
-    m_state->scalar_col = m_state->line_contents.current_col(s);
-    RYML_ASSERT(s.str >= m_state->line_contents.rem.str);
-    _line_progressed(static_cast<size_t>(s.str - m_state->line_contents.rem.str) + s.len);
+    m_state->scalar_col = m_line_contents.current_col(s);
+    RYML_ASSERT(s.str >= m_line_contents.rem.str);
+    _line_progressed(static_cast<size_t>(s.str - m_line_contents.rem.str) + s.len);
 
     if(_at_line_end() && s != '~')
     {
@@ -2156,8 +2484,8 @@ csubstr Parser::_extend_scanned_scalar(csubstr s)
             csubstr n = _scan_to_next_nonempty_line(scalar_indentation);
             if(!n.empty())
             {
-                RYML_ASSERT(m_state->line_contents.full.is_super(n));
-                _c4dbgpf("rscalar[IMPL]: state_indref=%zu state_indentation=%zu scalar_indentation=%zu", m_state->indref, m_state->line_contents.indentation, scalar_indentation);
+                RYML_ASSERT(m_line_contents.full.is_super(n));
+                _c4dbgpf("rscalar[IMPL]: state_indref=%zu state_indentation=%zu scalar_indentation=%zu", m_state->indref, m_line_contents.indentation, scalar_indentation);
                 substr full = _scan_plain_scalar_impl(s, n, scalar_indentation);
                 if(full != s)
                 {
@@ -2187,7 +2515,7 @@ csubstr Parser::_extend_scanned_scalar(csubstr s)
 substr Parser::_scan_plain_scalar_expl(csubstr currscalar, csubstr peeked_line)
 {
     static constexpr const csubstr chars = "[]{}?#,";
-    size_t pos = peeked_line.first_of(chars);
+    size_t pos = _first_of(peeked_line, chars);
     bool first = true;
     while(pos != 0)
     {
@@ -2205,8 +2533,8 @@ substr Parser::_scan_plain_scalar_expl(csubstr currscalar, csubstr peeked_line)
         {
             _c4dbgpf("rscalar[EXPL]: found special character '%c' at %zu, stopping: '%.*s'", peeked_line[pos], pos, _c4prsp(peeked_line.left_of(pos).trimr("\r\n")));
             peeked_line = peeked_line.left_of(pos);
-            RYML_ASSERT(peeked_line.end() >= m_state->line_contents.rem.begin());
-            _line_progressed(static_cast<size_t>(peeked_line.end() - m_state->line_contents.rem.begin()));
+            RYML_ASSERT(peeked_line.end() >= m_line_contents.rem.begin());
+            _line_progressed(static_cast<size_t>(peeked_line.end() - m_line_contents.rem.begin()));
             break;
         }
         _c4dbgpf("rscalar[EXPL]: append another line, full: '%.*s'", _c4prsp(peeked_line.trimr("\r\n")));
@@ -2219,10 +2547,10 @@ substr Parser::_scan_plain_scalar_expl(csubstr currscalar, csubstr peeked_line)
         {
             _c4err("expected token or continuation");
         }
-        pos = peeked_line.first_of(chars);
+        pos = _first_of(peeked_line, chars);
         first = false;
     }
-    substr full(m_buf.str + (currscalar.str - m_buf.str), m_buf.begin() + m_state->pos.offset);
+    substr full(m_buf.str + (currscalar.str - m_buf.str), m_buf.begin() + m_pos.offset);
     full = full.trimr("\r\n ");
     return full;
 }
@@ -2234,7 +2562,7 @@ substr Parser::_scan_plain_scalar_impl(csubstr currscalar, csubstr peeked_line,
 {
     RYML_ASSERT(m_buf.is_super(currscalar));
     // NOTE. there's a problem with _scan_to_next_nonempty_line(), as it counts newlines twice
-    // size_t offs = m_state->pos.offset;   // so we workaround by directly counting from the end of the given scalar
+    // size_t offs = m_pos.offset;   // so we workaround by directly counting from the end of the given scalar
     RYML_ASSERT(currscalar.end() >= m_buf.begin());
     size_t offs = static_cast<size_t>(currscalar.end() - m_buf.begin());
     RYML_ASSERT(peeked_line.begins_with(' ', indentation));
@@ -2267,9 +2595,9 @@ substr Parser::_scan_plain_scalar_impl(csubstr currscalar, csubstr peeked_line,
 
         _c4dbgpf("rscalar[IMPL]: line contents: '%.*s'", _c4prsp(peeked_line.right_of(indentation, true).trimr("\r\n")));
         size_t token_pos;
-        if(peeked_line.find(": ") != npos)
+        if(_find(peeked_line, ": ") != npos)
         {
-            _line_progressed(peeked_line.find(": "));
+            _line_progressed(_find(peeked_line, ": "));
             _c4err("': ' is not a valid token in plain flow (unquoted) scalars");
         }
         else if(peeked_line.ends_with(':'))
@@ -2277,7 +2605,7 @@ substr Parser::_scan_plain_scalar_impl(csubstr currscalar, csubstr peeked_line,
             _line_progressed(peeked_line.find(':'));
             _c4err("lines cannot end with ':' in plain flow (unquoted) scalars");
         }
-        else if((token_pos = peeked_line.find(" #")) != npos)
+        else if((token_pos = _find(peeked_line, " #")) != npos)
         {
             _line_progressed(token_pos);
             break;
@@ -2290,11 +2618,11 @@ substr Parser::_scan_plain_scalar_impl(csubstr currscalar, csubstr peeked_line,
             _c4dbgp("rscalar[IMPL]: file finishes after the scalar");
             break;
         }
-        peeked_line = m_state->line_contents.rem;
+        peeked_line = m_line_contents.rem;
     }
-    RYML_ASSERT(m_state->pos.offset >= offs);
+    RYML_ASSERT(m_pos.offset >= offs);
     substr full(m_buf.str + (currscalar.str - m_buf.str),
-                currscalar.len + (m_state->pos.offset - offs));
+                currscalar.len + (m_pos.offset - offs));
     full = full.trimr("\r\n ");
     return full;
 }
@@ -2303,7 +2631,7 @@ substr Parser::_scan_complex_key(csubstr currscalar, csubstr peeked_line)
 {
     RYML_ASSERT(m_buf.is_super(currscalar));
     // NOTE. there's a problem with _scan_to_next_nonempty_line(), as it counts newlines twice
-    // size_t offs = m_state->pos.offset;   // so we workaround by directly counting from the end of the given scalar
+    // size_t offs = m_pos.offset;   // so we workaround by directly counting from the end of the given scalar
     RYML_ASSERT(currscalar.end() >= m_buf.begin());
     size_t offs = static_cast<size_t>(currscalar.end() - m_buf.begin());
     while(true)
@@ -2316,10 +2644,10 @@ substr Parser::_scan_complex_key(csubstr currscalar, csubstr peeked_line)
         }
         else
         {
-            size_t pos = peeked_line.first_of("?:[]{}");
+            size_t pos = _first_of(peeked_line, "?:[]{}");
             if(pos == csubstr::npos)
             {
-                pos = peeked_line.find("- ");
+                pos = _find(peeked_line, "- ");
             }
             if(pos != csubstr::npos)
             {
@@ -2340,10 +2668,10 @@ substr Parser::_scan_complex_key(csubstr currscalar, csubstr peeked_line)
         peeked_line = next_peeked;
 
         _c4dbgpf("rcplxkey: line contents: '%.*s'", _c4prsp(peeked_line.trimr("\r\n")));
-        if(peeked_line.find(": ") != npos)
+        if(_find(peeked_line, ": ") != npos)
         {
             _c4dbgp("rcplxkey: found ': ', stopping.");
-            _line_progressed(peeked_line.find(": "));
+            _line_progressed(_find(peeked_line, ": "));
             break;
         }
         else if(peeked_line.ends_with(':'))
@@ -2359,11 +2687,11 @@ substr Parser::_scan_complex_key(csubstr currscalar, csubstr peeked_line)
             _c4dbgp("rcplxkey: file finishes after the scalar");
             break;
         }
-        peeked_line = m_state->line_contents.rem;
+        peeked_line = m_line_contents.rem;
     }
-    RYML_ASSERT(m_state->pos.offset >= offs);
+    RYML_ASSERT(m_pos.offset >= offs);
     substr full(m_buf.str + (currscalar.str - m_buf.str),
-                currscalar.len + (m_state->pos.offset - offs));
+                currscalar.len + (m_pos.offset - offs));
     return full;
 }
 
@@ -2373,8 +2701,8 @@ csubstr Parser::_scan_to_next_nonempty_line(size_t indentation)
     csubstr next_peeked;
     while(true)
     {
-        _c4dbgpf("rscalar: ... curr offset: %zu indentation=%zu", m_state->pos.offset, indentation);
-        next_peeked = _peek_next_line(m_state->pos.offset);
+        _c4dbgpf("rscalar: ... curr offset: %zu indentation=%zu", m_pos.offset, indentation);
+        next_peeked = _peek_next_line(m_pos.offset);
         csubstr next_peeked_triml = next_peeked.triml(' ');
         _c4dbgpf("rscalar: ... next peeked line='%.*s'", _c4prsp(next_peeked.trimr("\r\n")));
         if(next_peeked_triml.begins_with('#'))
@@ -2414,10 +2742,10 @@ csubstr Parser::_scan_to_next_nonempty_line(size_t indentation)
 // returns false when the file finished
 bool Parser::_advance_to_peeked()
 {
-    _line_progressed(m_state->line_contents.rem.len);
+    _line_progressed(m_line_contents.rem.len);
     _line_ended(); // advances to the peeked-at line, consuming all remaining (probably newline) characters on the current line
-    RYML_ASSERT(m_state->line_contents.rem.first_of("\r\n") == csubstr::npos);
-    _c4dbgpf("advance to peeked: scan more... pos=%zu len=%zu", m_state->pos.offset, m_buf.len);
+    RYML_ASSERT(m_line_contents.rem.first_of("\r\n") == csubstr::npos);
+    _c4dbgpf("advance to peeked: scan more... pos=%zu len=%zu", m_pos.offset, m_buf.len);
     _scan_line();  // puts the peeked-at line in the buffer
     if(_finished_file())
     {
@@ -2434,42 +2762,30 @@ C4_ALWAYS_INLINE size_t _extend_from_combined_newline(char nl, char following)
     return (nl == '\n' && following == '\r') || (nl == '\r' && following == '\n');
 }
 
-//! look for the next newline chars, and jump to the right of those
-csubstr from_next_line(csubstr rem)
-{
-    size_t nlpos = rem.first_of("\r\n");
-    if(nlpos == csubstr::npos)
-        return {};
-    const char nl = rem[nlpos];
-    rem = rem.right_of(nlpos);
-    if(rem.empty())
-        return {};
-    if(_extend_from_combined_newline(nl, rem.front()))
-        rem = rem.sub(1);
-    return rem;
-}
-
 csubstr Parser::_peek_next_line(size_t pos) const
 {
-    csubstr rem{}; // declare here because of the goto
     size_t nlpos{}; // declare here because of the goto
-    pos = pos == npos ? m_state->pos.offset : pos;
+    size_t beg{}; // declare here because of the goto
+    pos = pos == npos ? m_pos.offset : pos;
     if(pos >= m_buf.len)
         goto next_is_empty;
 
     // look for the next newline chars, and jump to the right of those
-    rem = from_next_line(m_buf.sub(pos));
-    if(rem.empty())
+    nlpos = m_newlines.next_newline(pos);
+    if(nlpos + 1 >= m_buf.len)
+        goto next_is_empty;
+    beg = nlpos + 1 + _extend_from_combined_newline(m_buf.str[nlpos], m_buf.str[nlpos + 1]);
+    if(beg >= m_buf.len)
         goto next_is_empty;
 
     // now get everything up to and including the following newline chars
-    nlpos = rem.first_of("\r\n");
-    if((nlpos != csubstr::npos) && (nlpos + 1 < rem.len))
-        nlpos += _extend_from_combined_newline(rem[nlpos], rem[nlpos+1]);
-    rem = rem.left_of(nlpos, /*include_pos*/true);
+    nlpos = m_newlines.next_newline(beg);
+    if(nlpos + 1 < m_buf.len)
+        nlpos += _extend_from_combined_newline(m_buf.str[nlpos], m_buf.str[nlpos + 1]);
+    nlpos = nlpos < m_buf.len ? nlpos + 1 : m_buf.len;
 
-    _c4dbgpf("peek next line @ %zu: (len=%zu)'%.*s'", pos, rem.len, _c4prsp(rem.trimr("\r\n")));
-    return rem;
+    _c4dbgpf("peek next line @ %zu: (len=%zu)'%.*s'", pos, nlpos - beg, _c4prsp(m_buf.range(beg, nlpos).trimr("\r\n")));
+    return m_buf.range(beg, nlpos);
 
 next_is_empty:
     _c4dbgpf("peek next line @ %zu: (len=0)''", pos);
@@ -2478,62 +2794,58 @@ next_is_empty:
 
 
 //-----------------------------------------------------------------------------
-void Parser::LineContents::reset_with_next_line(csubstr buf, size_t offset)
+void Parser::LineContents::reset_with_next_line(detail::LineIndex const& lines, csubstr buf, size_t offset)
 {
     RYML_ASSERT(offset <= buf.len);
-    char const* C4_RESTRICT b = &buf[offset];
-    char const* C4_RESTRICT e = b;
     // get the current line stripped of newline chars
-    while(e < buf.end() && (*e != '\n' && *e != '\r'))
-        ++e;
-    RYML_ASSERT(e >= b);
-    const csubstr stripped_ = buf.sub(offset, static_cast<size_t>(e - b));
+    size_t e = lines.next_newline(offset);
+    RYML_ASSERT(e >= offset && e <= buf.len);
+    const csubstr stripped_ = buf.range(offset, e);
     // advance pos to include the first line ending
-    if(e != buf.end() && *e == '\r')
+    if(e != buf.len && buf.str[e] == '\r')
         ++e;
-    if(e != buf.end() && *e == '\n')
+    if(e != buf.len && buf.str[e] == '\n')
         ++e;
-    RYML_ASSERT(e >= b);
-    const csubstr full_ = buf.sub(offset, static_cast<size_t>(e - b));
-    reset(full_, stripped_);
+    const csubstr full_ = buf.range(offset, e);
+    reset(full_, stripped_, lines.indentation(offset));
 }
 
 void Parser::_scan_line()
 {
-    if(m_state->pos.offset >= m_buf.len)
+    if(m_pos.offset >= m_buf.len)
         return;
-    m_state->line_contents.reset_with_next_line(m_buf, m_state->pos.offset);
+    m_line_contents.reset_with_next_line(m_newlines, m_buf, m_pos.offset);
 }
 
 
 //-----------------------------------------------------------------------------
 void Parser::_line_progressed(size_t ahead)
 {
-    _c4dbgpf("line[%zu] (%zu cols) progressed by %zu:  col %zu-->%zu   offset %zu-->%zu", m_state->pos.line, m_state->line_contents.full.len, ahead, m_state->pos.col, m_state->pos.col+ahead, m_state->pos.offset, m_state->pos.offset+ahead);
-    m_state->pos.offset += ahead;
-    m_state->pos.col += ahead;
-    RYML_ASSERT(m_state->pos.col <= m_state->line_contents.stripped.len+1);
-    m_state->line_contents.rem = m_state->line_contents.rem.sub(ahead);
+    _c4dbgpf("line[%zu] (%zu cols) progressed by %zu:  col %zu-->%zu   offset %zu-->%zu", m_pos.line, m_line_contents.full.len, ahead, m_pos.col, m_pos.col+ahead, m_pos.offset, m_pos.offset+ahead);
+    m_pos.offset += ahead;
+    m_pos.col += ahead;
+    RYML_ASSERT(m_pos.col <= m_line_contents.stripped.len+1);
+    m_line_contents.rem = m_line_contents.rem.sub(ahead);
 }
 
 void Parser::_line_ended()
 {
-    _c4dbgpf("line[%zu] (%zu cols) ended! offset %zu-->%zu", m_state->pos.line, m_state->line_contents.full.len, m_state->pos.offset, m_state->pos.offset+m_state->line_contents.full.len - m_state->line_contents.stripped.len);
-    RYML_ASSERT(m_state->pos.col == m_state->line_contents.stripped.len+1);
-    m_state->pos.offset += m_state->line_contents.full.len - m_state->line_contents.stripped.len;
-    ++m_state->pos.line;
-    m_state->pos.col = 1;
+    _c4dbgpf("line[%zu] (%zu cols) ended! offset %zu-->%zu", m_pos.line, m_line_contents.full.len, m_pos.offset, m_pos.offset+m_line_contents.full.len - m_line_contents.stripped.len);
+    RYML_ASSERT(m_pos.col == m_line_contents.stripped.len+1);
+    m_pos.offset += m_line_contents.full.len - m_line_contents.stripped.len;
+    ++m_pos.line;
+    m_pos.col = 1;
 }
 
 void Parser::_line_ended_undo()
 {
-    RYML_ASSERT(m_state->pos.col == 1u);
-    RYML_ASSERT(m_state->pos.line > 0u);
-    RYML_ASSERT(m_state->pos.offset >= m_state->line_contents.full.len - m_state->line_contents.stripped.len);
-    _c4dbgpf("line[%zu] undo ended! line %zu-->%zu, offset %zu-->%zu", m_state->pos.line, m_state->pos.line, m_state->pos.line - 1, m_state->pos.offset, m_state->pos.offset - (m_state->line_contents.full.len - m_state->line_contents.stripped.len));
-    m_state->pos.offset -= m_state->line_contents.full.len - m_state->line_contents.stripped.len;
-    --m_state->pos.line;
-    m_state->pos.col = m_state->line_contents.stripped.len + 1u;
+    RYML_ASSERT(m_pos.col == 1u);
+    RYML_ASSERT(m_pos.line > 0u);
+    RYML_ASSERT(m_pos.offset >= m_line_contents.full.len - m_line_contents.stripped.len);
+    _c4dbgpf("line[%zu] undo ended! line %zu-->%zu, offset %zu-->%zu", m_pos.line, m_pos.line, m_pos.line - 1, m_pos.offset, m_pos.offset - (m_line_contents.full.len - m_line_contents.stripped.len));
+    m_pos.offset -= m_line_contents.full.len - m_line_contents.stripped.len;
+    --m_pos.line;
+    m_pos.col = m_line_contents.stripped.len + 1u;
 }
 
 //-----------------------------------------------------------------------------
@@ -2545,8 +2857,8 @@ void Parser::_set_indentation(size_t indentation)
 
 void Parser::_save_indentation(size_t behind)
 {
-    RYML_ASSERT(m_state->line_contents.rem.begin() >= m_state->line_contents.full.begin());
-    m_state->indref = static_cast<size_t>(m_state->line_contents.rem.begin() - m_state->line_contents.full.begin());
+    RYML_ASSERT(m_line_contents.rem.begin() >= m_line_contents.full.begin());
+    m_state->indref = static_cast<size_t>(m_line_contents.rem.begin() - m_line_contents.full.begin());
     RYML_ASSERT(behind <= m_state->indref);
     m_state->indref -= behind;
     _c4dbgpf("state[%zd]: saving indentation: %zd", m_state-m_stack.begin(), m_state->indref);
@@ -2574,6 +2886,14 @@ bool Parser::_maybe_set_indentation_from_anchor_or_tag()
 void Parser::_write_key_anchor(size_t node_id)
 {
     RYML_ASSERT(m_tree->has_key(node_id));
+    if(m_restrictions & NO_ANCHORS)
+    {
+        // there are no anchors, so only check for references
+        csubstr r = m_tree->key(node_id);
+        if(!m_tree->is_key_quoted(node_id) && (r.begins_with('*') || r == "<<"))
+            _check_restriction(NO_ANCHORS, "references");
+        return;
+    }
     if( ! m_key_anchor.empty())
     {
         _c4dbgpf("node=%zd: set key anchor to '%.*s'", node_id, _c4prsp(m_key_anchor));
@@ -2615,6 +2935,13 @@ void Parser::_write_key_anchor(size_t node_id)
 //-----------------------------------------------------------------------------
 void Parser::_write_val_anchor(size_t node_id)
 {
+    if(m_restrictions & NO_ANCHORS)
+    {
+        // there are no anchors, so only check for references
+        if(m_tree->has_val(node_id) && !m_tree->is_val_quoted(node_id) && m_tree->val(node_id).begins_with('*'))
+            _check_restriction(NO_ANCHORS, "references");
+        return;
+    }
     if( ! m_val_anchor.empty())
     {
         _c4dbgpf("node=%zd: set val anchor to '%.*s'", node_id, _c4prsp(m_val_anchor));
@@ -2650,7 +2977,7 @@ void Parser::_push_level(bool explicit_flow_chars)
     m_state = &m_stack.top();
     set_flags(st);
     m_state->node_id = (size_t)NONE;
-    m_state->indref = (size_t)NONE;
+    m_state->indref = npos;
     ++m_state->level;
     _c4dbgpf("pushing level: now, currlevel=%zd", m_state->level);
 }
@@ -2678,7 +3005,7 @@ void Parser::_pop_level()
     {
         _toggle_key_val();
     }*/
-    if(m_state->line_contents.indentation == 0)
+    if(m_line_contents.indentation == 0)
     {
         //RYML_ASSERT(has_none(RTOP));
         add_flags(RTOP);
@@ -2713,6 +3040,8 @@ void Parser::_start_doc(bool as_child)
         }
         m_state->node_id = m_tree->append_child(parent_id);
         m_tree->to_doc(m_state->node_id);
+        if(m_locations_enabled)
+            _record_location(m_state->node_id);
     }
     else
     {
@@ -2881,6 +3210,8 @@ void Parser::_start_map(bool as_child)
             _c4dbgpf("start_map: id=%zd", m_state->node_id);
         }
         _write_val_anchor(m_state->node_id);
+        if(m_locations_enabled)
+            _record_location(m_state->node_id);
     }
     else
     {
@@ -3009,6 +3340,8 @@ void Parser::_start_seq(bool as_child)
             _c4dbgpf("start_seq: id=%zd%s", m_state->node_id, as_doc ? " as doc" : "");
         }
         _write_val_anchor(m_state->node_id);
+        if(m_locations_enabled)
+            _record_location(m_state->node_id);
     }
     else
     {
@@ -3093,7 +3426,7 @@ NodeData* Parser::_append_val(csubstr val, bool quoted)
     size_t nid = m_tree->append_child(m_state->node_id);
     m_tree->to_val(nid, val, additional_flags);
 
-    _c4dbgpf("append val: id=%zd val='%.*s'", nid, _c4prsp(m_tree->get(nid)->m_val.scalar));
+    _c4dbgpf("append val: id=%zd val='%.*s'", nid, _c4prsp(m_tree->_val(nid)));
     if( ! m_val_tag.empty())
     {
         _c4dbgpf("append val[%zu]: set val tag='%.*s' -> '%.*s'", nid, _c4prsp(m_val_tag), _c4prsp(normalize_tag(m_val_tag)));
@@ -3101,6 +3434,8 @@ NodeData* Parser::_append_val(csubstr val, bool quoted)
         m_val_tag.clear();
     }
     _write_val_anchor(nid);
+    if(m_locations_enabled)
+        _record_location(nid);
     return m_tree->get(nid);
 }
 
@@ -3132,6 +3467,8 @@ NodeData* Parser::_append_key_val(csubstr val, bool val_quoted)
     }
     _write_key_anchor(nid);
     _write_val_anchor(nid);
+    if(m_locations_enabled)
+        _record_location(nid);
     return m_tree->get(nid);
 }
 
@@ -3177,8 +3514,8 @@ bool Parser::_handle_indentation()
     if( ! _at_line_begin())
         return false;
 
-    size_t ind = m_state->line_contents.indentation;
-    csubstr rem = m_state->line_contents.rem;
+    size_t ind = m_line_contents.indentation;
+    csubstr rem = m_line_contents.rem;
     /** @todo instead of trimming, we should use the indentation index from above */
     csubstr remt = rem.triml(' ');
 
@@ -3344,7 +3681,7 @@ bool Parser::_handle_indentation()
 //-----------------------------------------------------------------------------
 csubstr Parser::_scan_comment()
 {
-    csubstr s = m_state->line_contents.rem;
+    csubstr s = m_line_contents.rem;
     RYML_ASSERT(s.begins_with('#'));
     _line_progressed(s.len);
     // skip the # character
@@ -3366,7 +3703,7 @@ csubstr Parser::_scan_quoted_scalar(const char q)
     bool needs_filter = false;
 
     // a span to the end of the file
-    size_t b = m_state->pos.offset;
+    size_t b = m_pos.offset;
     substr s = m_buf.sub(b);
     if(s.begins_with(' '))
     {
@@ -3375,7 +3712,7 @@ csubstr Parser::_scan_quoted_scalar(const char q)
         RYML_ASSERT(s.begin() >= m_buf.sub(b).begin());
         _line_progressed((size_t)(s.begin() - m_buf.sub(b).begin()));
     }
-    b = m_state->pos.offset; // take this into account
+    b = m_pos.offset; // take this into account
     RYML_ASSERT(s.begins_with(q));
 
     // skip the opening quote
@@ -3386,80 +3723,61 @@ csubstr Parser::_scan_quoted_scalar(const char q)
     size_t pos = npos;
     while( ! _finished_file())
     {
-        const csubstr line = m_state->line_contents.rem;
-        bool line_is_blank = true;
+        const csubstr line = m_line_contents.rem;
+        bool line_is_blank = false;
 
         if(q == '\'') // scalars with single quotes
         {
-            _c4dbgpf("scanning single quoted scalar @ line[%zd]:  line=\"%.*s\"", m_state->pos.line, _c4prsp(line));
-            for(size_t i = 0; i < line.len; ++i)
+            _c4dbgpf("scanning single quoted scalar @ line[%zd]:  line=\"%.*s\"", m_pos.line, _c4prsp(line));
+            // single quotes are escaped with two single quotes, so
+            // the terminator is the last quote of a run of odd length
+            size_t i = 0;
+            while((i = detail::simd::first_of(line.str, i, line.len, '\'')) < line.len)
             {
-                const char curr = line.str[i];
-                if(curr == '\'') // single quotes are escaped with two single quotes
-                {
-                    const char next = i+1 < line.len ? line.str[i+1] : '~';
-                    if(next != '\'') // so just look for the first quote
-                    {                // without another after it
-                        pos = i;
-                        break;
-                    }
-                    else
-                    {
-                        needs_filter = true; // needs filter to remove escaped quotes
-                        ++i; // skip the escaped quote
-                    }
-                }
-                else if(curr != ' ')
+                size_t run = i + 1;
+                while(run < line.len && line.str[run] == '\'')
+                    ++run;
+                if((run - i) & 1u)
                 {
-                    line_is_blank = false;
+                    pos = run - 1;
+                    needs_filter = needs_filter || pos > i;
+                    break;
                 }
+                needs_filter = true; // needs filter to remove escaped quotes
+                i = run;
             }
+            line_is_blank = line.first(pos == npos ? line.len : pos).first_not_of(" '") == npos;
         }
         else // scalars with double quotes
         {
-            _c4dbgpf("scanning double quoted scalar @ line[%zd]:  line='%.*s'", m_state->pos.line, _c4prsp(line));
-            for(size_t i = 0; i < line.len; ++i)
-            {
-                const char curr = line.str[i];
-                if(curr != ' ')
-                {
-                    line_is_blank = false;
-                }
-                // every \ is an escape
-                if(curr == '\\')
-                {
-                    const char next = i+1 < line.len ? line.str[i+1] : '~';
-                    needs_filter = true;
-                    if(next == '"' || next == '\\')
-                    {
-                        ++i;
-                    }
-                }
-                else if(curr == '"')
-                {
-                    pos = i;
-                    break;
-                }
-            }
+            _c4dbgpf("scanning double quoted scalar @ line[%zd]:  line='%.*s'", m_pos.line, _c4prsp(line));
+            // every \ is an escape
+            bool has_escapes = false;
+            const size_t i = detail::simd::first_unescaped_dquote(line.str, 0, line.len, &has_escapes);
+            needs_filter = needs_filter || has_escapes;
+            if(i < line.len)
+                pos = i;
+            else
+                line_is_blank = line.first_not_of(' ') == npos;
         }
 
         // leading whitespace also needs filtering
         needs_filter = needs_filter
             || line_is_blank
             || (_at_line_begin() && line.begins_with(' '))
-            || (m_state->line_contents.full.last_of('\r') != csubstr::npos);
+            || (m_line_contents.full.sub(m_line_contents.stripped.len).first_of('\r') != csubstr::npos);
 
         if(pos == npos)
         {
             _line_progressed(line.len);
-            _c4dbgpf("scanning scalar @ line[%zd]: sofar=\"%.*s\"", m_state->pos.line, _c4prsp(s.sub(0, m_state->pos.offset-b)));
+            _c4dbgpf("scanning scalar @ line[%zd]: sofar=\"%.*s\"", m_pos.line, _c4prsp(s.sub(0, m_pos.offset-b)));
         }
         else
         {
             RYML_ASSERT(pos >= 0 && pos < m_buf.len);
-            RYML_ASSERT(m_buf[m_state->pos.offset + pos] == q);
+            RYML_ASSERT(m_buf[m_pos.offset + pos] == q);
             _line_progressed(pos + 1); // progress beyond the quote
-            pos = m_state->pos.offset - b - 1; // but we stop before it
+            pos = m_pos.offset - b - 1; // but we stop before it
             break;
         }
 
@@ -3485,14 +3803,19 @@ csubstr Parser::_scan_quoted_scalar(const char q)
 
     if(needs_filter)
     {
+        if(m_lazy_filtering)
+        {
+            // keep the opening quote, to know how to filter it
+            return _keep_raw_scalar(csubstr(s.str - 1, s.len + 1));
+        }
         csubstr ret;
         if(q == '\'')
         {
-            ret = _filter_squot_scalar(s);
+            ret = detail::filter_squot_scalar(s);
         }
         else if(q == '"')
         {
-            ret = _filter_dquot_scalar(s);
+            ret = detail::filter_dquot_scalar(s);
         }
         RYML_ASSERT(ret.len <= s.len || s.empty() || s.trim(' ').empty());
         _c4dbgpf("final scalar: \"%.*s\"", _c4prsp(ret));
@@ -3508,7 +3831,7 @@ csubstr Parser::_scan_quoted_scalar(const char q)
 csubstr Parser::_scan_block()
 {
     // nice explanation here: http://yaml-multiline.info/
-    csubstr s = m_state->line_contents.rem;
+    csubstr s = m_line_contents.rem;
     csubstr trimmed = s.triml(" ");
     if(trimmed.str > s.str)
     {
@@ -3522,34 +3845,13 @@ csubstr Parser::_scan_block()
     _c4dbgpf("scanning block: specs=\"%.*s\"", _c4prsp(s));
 
     // parse the spec
-    BlockStyle_e newline = s.begins_with('>') ? BLOCK_FOLD : BLOCK_LITERAL;
-    BlockChomp_e chomp = CHOMP_CLIP; // default to clip unless + or - are used
-    size_t indentation = npos; // have to find out if no spec is given
-    csubstr digits;
-    if(s.len > 1)
+    const char *header = s.str;
+    detail::BlockStyle_e newline;
+    detail::BlockChomp_e chomp;
+    size_t indentation;
+    if( ! detail::read_block_header(s, &newline, &chomp, &indentation))
     {
-        csubstr t = s.sub(1);
-        RYML_ASSERT(t.len >= 1);
-        if(t[0] == '-')
-        {
-            chomp = CHOMP_STRIP;
-            t = t.sub(1);
-        }
-        else if(t[0] == '+')
-        {
-            chomp = CHOMP_KEEP;
-            t = t.sub(1);
-        }
-
-        // from here to the end, only digits are considered
-        digits = t.left_of(t.first_not_of("0123456789"));
-        if( ! digits.empty())
-        {
-            if( ! _read_decimal(digits, &indentation))
-            {
-                _c4err("parse error: could not read decimal");
-            }
-        }
+        _c4err("parse error: could not read decimal");
     }
 
     // finish the current line
@@ -3559,104 +3861,391 @@ csubstr Parser::_scan_block()
 
     // if no explicit indentation was given, pick it from the current line
     if(indentation == npos)
-        indentation = m_state->line_contents.indentation;
+        indentation = m_line_contents.indentation;
 
-    _c4dbgpf("scanning block:  style=%s", newline==BLOCK_FOLD ? "fold" : "literal");
-    _c4dbgpf("scanning block:  chomp=%s", chomp==CHOMP_CLIP ? "clip" : (chomp==CHOMP_STRIP ? "strip" : "keep"));
-    _c4dbgpf("scanning block: indent=%zd (digits='%.*s')", indentation, _c4prsp(digits));
+    _c4dbgpf("scanning block:  style=%s", newline==detail::BLOCK_FOLD ? "fold" : "literal");
+    _c4dbgpf("scanning block:  chomp=%s", chomp==detail::CHOMP_CLIP ? "clip" : (chomp==detail::CHOMP_STRIP ? "strip" : "keep"));
+    _c4dbgpf("scanning block: indent=%zd", indentation);
 
     // start with a zero-length block, already pointing at the right place
-    substr raw_block(m_buf.data() + m_state->pos.offset, size_t(0));// m_state->line_contents.full.sub(0, 0);
-    RYML_ASSERT(raw_block.begin() == m_state->line_contents.full.begin());
-
-    // read every full line into a raw block,
-    // from which newlines are to be stripped as needed
-    size_t num_lines = 0, first = m_state->pos.line;
-    LineContents lc;
-    while(( ! _finished_file()))
-    {
-        // peek next line, but do not advance immediately
-        lc.reset_with_next_line(m_buf, m_state->pos.offset);
+    substr raw_block(m_buf.data() + m_pos.offset, size_t(0));// m_line_contents.full.sub(0, 0);
+    RYML_ASSERT(raw_block.begin() == m_line_contents.full.begin());
+
+    // read every full line into a raw block, from which newlines are
+    // to be stripped as needed. The lines are walked through the
+    // newline index, which already has the indentation of each line,
+    // so the body of the block is not read here: only the lines with
+    // less indentation are looked at, to see whether they are blank.
+    size_t num_lines = 0, last_line_start = npos;
+    size_t line_start = m_pos.offset;
+    size_t entry = m_newlines.lower_bound(line_start);
+    size_t line_indentation = m_newlines.indentation(line_start);
+    while(line_start < m_buf.len)
+    {
+        const size_t line_end = entry < m_newlines.size() ? m_newlines[entry].offset : m_buf.len;
         // stop when the line is deindented and not empty
-        if(lc.indentation < indentation && ( ! lc.rem.trim(" \t\r\n").empty()))
+        if(line_indentation < indentation && m_buf.range(line_start + line_indentation, line_end).first_not_of(" \t") != npos)
             break;
-        // advance now that we know the folded scalar continues
-        m_state->line_contents = lc;
-        _c4dbgpf("scanning block: append '%.*s'", _c4prsp(m_state->line_contents.rem));
-        raw_block.len += m_state->line_contents.full.len;
-        _line_progressed(m_state->line_contents.rem.len);
-        _line_ended();
+        last_line_start = line_start;
         ++num_lines;
+        if(line_end == m_buf.len)
+            break;
+        if(m_buf.str[line_end] == '\r' && line_end + 1 < m_buf.len && m_buf.str[line_end + 1] == '\n')
+            ++entry; // the line ending is \r\n
+        RYML_ASSERT(entry < m_newlines.size());
+        line_start = m_newlines[entry].offset + 1;
+        line_indentation = m_newlines[entry].indentation;
+        ++entry;
     }
-    RYML_ASSERT(m_state->pos.line == (first + num_lines));
-    C4_UNUSED(num_lines);
-    C4_UNUSED(first);
 
+    // now move to the end of the last line of the block
     if(num_lines)
-        _line_ended_undo();
+    {
+        m_pos.offset = last_line_start;
+        m_pos.line += num_lines - 1;
+        m_pos.col = 1;
+        m_line_contents.reset_with_next_line(m_newlines, m_buf, last_line_start);
+        _line_progressed(m_line_contents.rem.len);
+        raw_block.len = static_cast<size_t>(m_line_contents.full.end() - raw_block.begin());
+    }
 
     _c4dbgpf("scanning block: raw='%.*s'", _c4prsp(raw_block));
 
+    if(m_lazy_filtering)
+    {
+        // keep the header with the block, as it is needed to filter it
+        return _keep_raw_scalar(csubstr(header, static_cast<size_t>(raw_block.end() - header)));
+    }
+
     // ok! now we strip the newlines and spaces according to the specs
-    s = _filter_block_scalar(raw_block, newline, chomp, indentation);
+    s = detail::filter_block_scalar(raw_block, newline, chomp, indentation);
 
     _c4dbgpf("scanning block: final='%.*s'", _c4prsp(s));
 
     return s;
 }
 
+//-----------------------------------------------------------------------------
+csubstr Parser::_filter_json_dquot_scalar(substr s)
+{
+    _c4dbgpf("filtering json string: before='%.*s'", _c4prsp(s));
+    size_t err_pos;
+    csubstr r = detail::unescape_json_string(s, &err_pos);
+    if(err_pos != npos)
+    {
+        _json_locate(static_cast<size_t>(s.str + err_pos - m_buf.str));
+        _c4err("json: invalid escape");
+    }
+    _c4dbgpf("filtering json string: after='%.*s'", _c4prsp(r));
+    return r;
+}
+
 //-----------------------------------------------------------------------------
 csubstr Parser::_filter_plain_scalar(substr s, size_t indentation)
 {
-    _c4dbgpf("filtering plain scalar: indentation=%zu before='%.*s'", indentation, _c4prsp(s));
+    if(m_lazy_filtering)
+        return _keep_raw_scalar(s); // the filter does not need the indentation
+    return detail::filter_plain_scalar(s, indentation);
+}
 
-    // do a first sweep to clean leading whitespace from the indentation
-    substr r = _filter_whitespace(s, indentation);
+//-----------------------------------------------------------------------------
+csubstr Parser::_keep_raw_scalar(csubstr raw)
+{
+    _c4dbgpf("keeping raw scalar: '%.*s'", _c4prsp(raw));
+    RYML_ASSERT(m_buf.is_super(raw));
+    m_raw_scalars.push({raw, {}, 0, false});
+    return raw;
+}
 
-    // now another sweep for newlines
-    for(size_t i = 0; i < r.len; ++i)
+//-----------------------------------------------------------------------------
+void Parser::_record_location(size_t node)
+{
+    RYML_ASSERT(m_locations_enabled);
+    if(node >= m_locations.size())
+    {
+        // grow along with the tree, so that this is seldom done
+        size_t sz = m_locations.size();
+        m_locations.resize(node < m_tree->capacity() ? m_tree->capacity() : node + 1);
+        for( ; sz < m_locations.size(); ++sz)
+            m_locations[sz] = {npos, npos};
+    }
+    NodeData const* n = m_tree->get(node);
+    m_locations[node].key = n->m_type.has_key() ? _offset_of(m_tree->_key(node)) : npos;
+    m_locations[node].val = n->m_type.has_val() ? _offset_of(m_tree->_val(node)) : m_pos.offset;
+}
+
+size_t Parser::_offset_of(csubstr s) const
+{
+    // scalars which are empty or were not taken from the source
+    // do not point into it: use the current position instead
+    if(s.str != nullptr && s.str >= m_buf.str && s.str <= m_buf.str + m_buf.len)
+        return static_cast<size_t>(s.str - m_buf.str);
+    return m_pos.offset;
+}
+
+Location Parser::key_location(size_t node)
+{
+    return _location_of(node < m_locations.size() ? m_locations[node].key : npos);
+}
+
+Location Parser::val_location(size_t node)
+{
+    return _location_of(node < m_locations.size() ? m_locations[node].val : npos);
+}
+
+Location Parser::_location_of(size_t offset)
+{
+    if(offset == npos)
+        return {};
+    RYML_ASSERT(offset <= m_buf.len);
+    if(m_line_starts.empty())
     {
-        const char curr = r[i];
-        const char next = i+1 < r.len ? r[i+1] : '\0';
-        RYML_ASSERT(curr != '\r' && next != '\r');
-        if(curr == '\n')
+        if(m_newlines.size() == 0)
+            m_newlines.build(m_buf);
+        m_line_starts.push(0);
+        for(size_t i = 0; i < m_newlines.size(); ++i)
         {
-            _c4dbgpf("filtering plain scalar: i=%zu: looked at: '%.*s'", i, _c4prsp(r.first(i)));
-            if(next != '\n')
+            const size_t nl = m_newlines[i].offset;
+            if(m_buf.str[nl] == '\r' && nl + 1 < m_buf.len && m_buf.str[nl + 1] == '\n')
+                continue; // \r\n ends a single line
+            m_line_starts.push(nl + 1);
+        }
+    }
+    // find the last line starting at or before the offset
+    size_t lo = 0, hi = m_line_starts.size();
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(m_line_starts[mid] <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    RYML_ASSERT(lo > 0);
+    return Location(m_file, offset, lo, 1 + offset - m_line_starts[lo - 1]);
+}
+
+//-----------------------------------------------------------------------------
+/** the node following @p n in a depth-first walk of the subtree of
+ * @p root, or NONE when the walk is finished */
+static size_t _next_in_subtree(Tree const* t, size_t root, size_t n)
+{
+    size_t next = t->first_child(n);
+    while(next == NONE && n != root)
+    {
+        next = t->next_sibling(n);
+        if(next == NONE)
+            n = t->parent(n);
+    }
+    return next;
+}
+
+template<class RawScalar>
+static RawScalar* _find_raw_scalar(RawScalar *b, RawScalar *e, csubstr s)
+{
+    if(s.empty())
+        return nullptr;
+    RawScalar *lo = b, *hi = e;
+    while(lo < hi)
+    {
+        RawScalar *mid = lo + (hi - lo) / 2;
+        if(mid->raw.str < s.str)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo != e && lo->raw.str == s.str && lo->raw.len == s.len) ? lo : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+/** called at the end of parse(): the raw scalars which went into keys
+ * or into more than one node are filtered now, and the remaining vals
+ * are marked as VALRAW, to be filtered by the tree when first read. */
+void Parser::_finish_raw_scalars()
+{
+    if(m_raw_scalars.empty())
+        return;
+    // the scalars are kept in source order, so they can be searched
+    // for by their position in the buffer
+    RawScalar *C4_RESTRICT rb = m_raw_scalars.begin();
+    RawScalar *C4_RESTRICT re = rb + m_raw_scalars.size();
+    #if RYML_USE_ASSERT
+    for(RawScalar const* C4_RESTRICT r = rb + 1; r < re; ++r)
+        RYML_ASSERT(r[-1].raw.str < r->raw.str);
+    #endif
+    // first pass: count the references to each raw scalar
+    for(size_t n = m_root_id; n != NONE; n = _next_in_subtree(m_tree, m_root_id, n))
+    {
+        NodeData *C4_RESTRICT d = m_tree->_p(n);
+        if(d->m_type.type & KEY)
+        {
+            RawScalar *C4_RESTRICT r = _find_raw_scalar(rb, re, m_tree->_key(n));
+            if(r)
             {
-                _c4dbgpf("filtering plain scalar: filter single newline at %zu", i);
-                if(i + 1 < r.len)
-                {
-                    r[i] = ' '; // a single unix newline: turn it into a space
-                }
-                else
-                {
-                    --r.len;
-                }
+                ++r->num_refs;
+                r->eager = true; // keys are needed for lookup
             }
-            else
+        }
+        if(d->m_type.type & VAL)
+        {
+            RawScalar *C4_RESTRICT r = _find_raw_scalar(rb, re, m_tree->_val(n));
+            if(r)
+                ++r->num_refs;
+        }
+    }
+    // filter now the scalars which cannot be filtered lazily. As the
+    // filtering is done in place, a scalar shared by several nodes
+    // must be filtered once, with the result given to all of them.
+    for(RawScalar *C4_RESTRICT r = rb; r < re; ++r)
+    {
+        if(r->num_refs > 1)
+            r->eager = true;
+        if(r->eager)
+            r->filtered = detail::filter_raw_scalar(m_buf.sub(static_cast<size_t>(r->raw.str - m_buf.str), r->raw.len));
+    }
+    // second pass: assign the filtered scalars, and mark the others
+    for(size_t n = m_root_id; n != NONE; n = _next_in_subtree(m_tree, m_root_id, n))
+    {
+        NodeData *C4_RESTRICT d = m_tree->_p(n);
+        if(d->m_type.type & KEY)
+        {
+            RawScalar const* C4_RESTRICT r = _find_raw_scalar(rb, re, m_tree->_key(n));
+            if(r)
             {
-                 // multiple new lines
-                RYML_ASSERT(next == '\n');
-                r = r.erase(i, 1);  // erase one
-                RYML_ASSERT(r[i] == '\n');
-                size_t nl = r.sub(i).first_not_of('\n');
-                if(nl == csubstr::npos)
-                {
-                    _c4dbgpf("filtering plain scalar: newlines starting at %zu go up to the end at %zu", i, r.len);
-                    break;
-                }
-                _c4dbgpf("filtering plain scalar: erasing one of %zu newlines found at %zu", nl, i);
-                RYML_ASSERT(nl > 0);
-                i += nl; // and skip the rest
+                m_tree->_key(n) = r->filtered;
+                m_tree->_key_changed(n);
             }
         }
-        else if(curr == '\r')
+        if(d->m_type.type & VAL)
+        {
+            RawScalar const* C4_RESTRICT r = _find_raw_scalar(rb, re, m_tree->_val(n));
+            if(r)
+            {
+                if(r->eager)
+                    m_tree->_val(n) = r->filtered;
+                else
+                    m_tree->_add_flags(n, VALRAW);
+            }
+        }
+    }
+    m_raw_scalars.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+//-----------------------------------------------------------------------------
+bool read_block_header(csubstr s, BlockStyle_e *style, BlockChomp_e *chomp, size_t *indentation)
+{
+    RYML_ASSERT(s.begins_with('|') || s.begins_with('>'));
+    *style = s.begins_with('>') ? BLOCK_FOLD : BLOCK_LITERAL;
+    *chomp = CHOMP_CLIP; // default to clip unless + or - are used
+    *indentation = npos; // have to find out if no spec is given
+    if(s.len > 1)
+    {
+        csubstr t = s.sub(1);
+        RYML_ASSERT(t.len >= 1);
+        if(t[0] == '-')
+        {
+            *chomp = CHOMP_STRIP;
+            t = t.sub(1);
+        }
+        else if(t[0] == '+')
+        {
+            *chomp = CHOMP_KEEP;
+            t = t.sub(1);
+        }
+
+        // from here to the end, only digits are considered
+        csubstr digits = t.left_of(t.first_not_of("0123456789"));
+        if( ! digits.empty())
+            return c4::atou(digits, indentation);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+csubstr filter_raw_scalar(substr raw)
+{
+    RYML_ASSERT( ! raw.empty());
+    const char c = raw.str[0];
+    if(c == '\'')
+    {
+        return filter_squot_scalar(raw.sub(1));
+    }
+    else if(c == '"')
+    {
+        return filter_dquot_scalar(raw.sub(1));
+    }
+    else if(c == '|' || c == '>')
+    {
+        // the header is on the first line, and the block starts on the next
+        BlockStyle_e style;
+        BlockChomp_e chomp;
+        size_t indentation;
+        size_t nl = raw.find('\n');
+        nl = nl == npos ? raw.len : nl + 1;
+        bool ok = read_block_header(raw.first(nl), &style, &chomp, &indentation);
+        RYML_ASSERT(ok); // it was read when parsing
+        C4_UNUSED(ok);
+        substr block = raw.sub(nl);
+        if(indentation == npos)
+        {
+            // as when parsing, pick it from the first line of the block
+            size_t first_nl = block.find('\n');
+            indentation = block.first(first_nl == npos ? block.len : first_nl + 1).first_not_of(' ');
+        }
+        return filter_block_scalar(block, style, chomp, indentation);
+    }
+    return filter_plain_scalar(raw, /*indentation*/0);
+}
+
+
+//-----------------------------------------------------------------------------
+csubstr filter_plain_scalar(substr s, size_t indentation)
+{
+    _c4dbgpf("filtering plain scalar: indentation=%zu before='%.*s'", indentation, _c4prsp(s));
+
+    // do a first sweep to clean leading whitespace from the indentation
+    substr r = filter_whitespace(s, indentation);
+
+    // now another sweep for newlines, reading at i and writing at w
+    // (which is never ahead of i). The stretches between newlines are
+    // found a block at a time, and moved at once.
+    char *C4_RESTRICT str = r.str;
+    const size_t len = r.len;
+    size_t i = 0, w = 0;
+    while(true)
+    {
+        const size_t pos = simd::first_of(str, i, len, '\n');
+        if(w != i)
+            memmove(str + w, str + i, pos - i);
+        w += pos - i;
+        if(pos == len)
+            break;
+        RYML_ASSERT(str[pos] == '\n');
+        i = pos + 1;
+        while(i < len && str[i] == '\n')
+            ++i;
+        const size_t num_newlines = i - pos;
+        if(num_newlines == 1)
+        {
+            _c4dbgpf("filtering plain scalar: filter single newline at %zu", pos);
+            if(i < len)
+                str[w++] = ' '; // a single unix newline: turn it into a space
+        }
+        else
         {
-            _c4dbgpf("filtering plain scalar: i=%zu: removing carriage return \\r", i);
-            r = r.erase(i, 1);
+            _c4dbgpf("filtering plain scalar: erasing one of %zu newlines found at %zu", num_newlines, pos);
+            for(size_t j = 1; j < num_newlines; ++j)
+                str[w++] = '\n';
         }
     }
+    r.len = w;
 
     RYML_ASSERT(s.len >= r.len);
     _c4dbgpf("filtering plain scalar: num filtered chars=%zd", s.len - r.len);
@@ -3673,12 +4262,12 @@ csubstr Parser::_filter_plain_scalar(substr s, size_t indentation)
 }
 
 //-----------------------------------------------------------------------------
-csubstr Parser::_filter_squot_scalar(substr s)
+csubstr filter_squot_scalar(substr s)
 {
     _c4dbgpf("filtering single-quoted scalar: before=\"%.*s\"", _c4prsp(s));
 
     // do a first sweep to clean leading whitespace
-    substr r = _filter_whitespace(s);
+    substr r = filter_whitespace(s);
 
     // now another sweep for quotes and newlines
     for(size_t i = 0; i < r.len; ++i)
@@ -3718,47 +4307,61 @@ csubstr Parser::_filter_squot_scalar(substr s)
 }
 
 //-----------------------------------------------------------------------------
-csubstr Parser::_filter_dquot_scalar(substr s)
+csubstr filter_dquot_scalar(substr s)
 {
     _c4dbgpf("filtering double-quoted scalar: before='%.*s'", _c4prsp(s));
 
     // do a first sweep to clean leading whitespace
-    substr r = _filter_whitespace(s);
-
-    for(size_t i = 0; i < r.len; ++i)
+    substr r = filter_whitespace(s);
+
+    // now a single sweep, reading at i and writing at w (which is never
+    // ahead of i). The stretches up to the next backslash or newline
+    // are found a block at a time, and moved at once.
+    char *C4_RESTRICT str = r.str;
+    const size_t len = r.len;
+    size_t i = 0, w = 0;
+    while(true)
     {
-        const char curr = r[i];
-        char next = i+1 < r.len ? r[i+1] : '\0';
-        if(curr == '\\')
+        const size_t pos = simd::first_of(str, i, len, '\\', '\n');
+        if(w != i)
+            memmove(str + w, str + i, pos - i);
+        w += pos - i;
+        if(pos == len)
+            break;
+        i = pos;
+        const char next = i+1 < len ? str[i+1] : '\0';
+        if(str[i] == '\\')
         {
-            if(next == curr)
+            switch(next)
             {
-                r = r.erase(i+1, 1); // turn two consecutive backslashes into one
-            }
-            else if(next == '\n')
-            {
-                r = r.erase(i, 2);  // newlines are escaped with \ -- delete both
-            }
-            else if(next == '"')
-            {
-                r = r.erase(i, 1);  // fix escaped double quotes
-            }
-            else if(next == 'n')
-            {
-                r = r.erase(i+1, 1);
-                r[i] = '\n';
-            }
-            else if(next == 't')
-            {
-                r = r.erase(i+1, 1);
-                r[i] = '\t';
-            }
-            else if(next == '/')
-            {
-                r = r.erase(i, 1);  // fix escaped /
+            case '\\': // two consecutive backslashes become one
+            case '"':  // fix escaped double quotes
+            case '/':  // fix escaped /
+                str[w++] = next;
+                i += 2;
+                break;
+            case 'n':
+                str[w++] = '\n';
+                i += 2;
+                break;
+            case 't':
+                str[w++] = '\t';
+                i += 2;
+                break;
+            case '\n':
+                // newlines are escaped with \ -- delete both. The
+                // character after them is kept as is.
+                i += 2;
+                if(i < len)
+                    str[w++] = str[i++];
+                break;
+            default:
+                str[w++] = '\\';
+                ++i;
+                break;
             }
         }
-        else if(curr == '\n')
+        else
         {
             // from the YAML spec for double-quoted scalars:
             // https://yaml.org/spec/1.2/spec.html#id2787109
@@ -3771,46 +4374,24 @@ csubstr Parser::_filter_dquot_scalar(substr s)
             //
             // ... so - erase trailing whitespace (ie whitespace before
             // the newline):
-            if(i > 0)
-            {
-                size_t numws = 0;
-                char prev = r[i-1]; // safe because we know that i>0
-                while(prev == ' ' || prev == '\t')
-                {
-                    ++numws;
-                    if(i < 1+numws) // ie, i-1-numws < 0
-                        break;
-                    prev = r[i-1-numws];
-                }
-                if(numws)
-                {
-                    r = r.erase(i-numws, numws);
-                    i -= numws;
-                }
-            }
+            while(w > 0 && (str[w-1] == ' ' || str[w-1] == '\t'))
+                --w;
             if(next == '\n')
             {
-                r = r.erase(i+1, 1); // keep only one of consecutive newlines
+                str[w++] = '\n'; // keep only one of consecutive newlines
+                i += 2;
             }
             else
             {
-                r[i] = ' '; // a single unix newline: turn it into a space
+                str[w++] = ' '; // a single unix newline: turn it into a space
+                ++i;
             }
             // erase leading whitespace (ie whitespace after the newline)
-            if(i < r.len)
-            {
-                size_t numws = 0;
-                for(char c : r.sub(i + 1))
-                {
-                    if(c != ' ' && c != '\t')
-                        break;
-                    ++numws;
-                }
-                if(numws)
-                    r = r.erase(i + 1, numws);
-            }
+            while(i < len && (str[i] == ' ' || str[i] == '\t'))
+                ++i;
         }
     }
+    r.len = w;
 
     RYML_ASSERT(s.len >= r.len);
     _c4dbgpf("filtering double-quoted scalar: num filtered chars=%zd", s.len - r.len);
@@ -3827,45 +4408,41 @@ csubstr Parser::_filter_dquot_scalar(substr s)
 }
 
 //-----------------------------------------------------------------------------
-/** @p leading_whitespace when true, remove every leading spaces from the
- * beginning of each line */
-substr Parser::_filter_whitespace(substr r, size_t indentation, bool leading_whitespace)
+substr filter_whitespace(substr r, size_t indentation, bool leading_whitespace)
 {
     _c4dbgpf("filtering whitespace: indentation=%zu leading=%d before=~~~%.*s~~~", indentation, leading_whitespace, _c4prsp(r));
 
-    for(size_t i = 0; i < r.len; ++i)
+    // a single sweep, reading at i and writing at w (which is never
+    // ahead of i). The stretches up to the next newline or carriage
+    // return are found a block at a time, and moved at once.
+    char *C4_RESTRICT str = r.str;
+    const size_t len = r.len;
+    size_t i = 0, w = 0;
+    while(true)
     {
-        const char curr = r[i];
-        const char prev = i > 0 ? r[i-1] : '\0';
-        if(curr == ' ' && prev == '\n')
-        {
-            _c4dbgpf("filtering whitespace: removing indentation i=%zu len=%zu. curr=~~~%.*s~~~", i, r.len, _c4prsp(r.first(i)));
-            csubstr ss = r.sub(i);
-            ss = ss.left_of(ss.first_not_of(' '));
-            RYML_ASSERT(ss.len >= 1);
-            size_t num = ss.len;
-            // RYML_ASSERT(num >= indentation); // empty lines are allowed
-            _c4dbgpf("                    : line has %zu spaces", num);
-            if(leading_whitespace)
-            {
-                num = ss.len;
-            }
-            else if(indentation != csubstr::npos)
-            {
-                num = num < indentation ? num : indentation;
-            }
-            _c4dbgpf("                    : removing %zu spaces", num);
-            r = r.erase(i, num);
-            if(i < r.len && r[i] != ' ') --i; // i is incremented on the next iteration
-        }
+        const size_t pos = simd::first_of(str, i, len, '\n', '\r');
+        if(w != i)
+            memmove(str + w, str + i, pos - i);
+        w += pos - i;
+        if(pos == len)
+            break;
+        i = pos + 1;
         // erase \r --- https://stackoverflow.com/questions/1885900
-        else if(curr == '\r')
-        {
-            _c4dbgpf("filtering whitespace: remove \\r: i=%zu len=%zu. curr=~~~%.*s~~~", i, r.len, _c4prsp(r.first(i)));
-            r = r.erase(i, 1);
-            --i; // i is incremented on the next iteration
+        if(str[pos] == '\n')
+            str[w++] = '\n';
+        // remove the indentation
+        if(w > 0 && str[w-1] == '\n' && i < len && str[i] == ' ')
+        {
+            size_t num = 1;
+            while(i + num < len && str[i + num] == ' ')
+                ++num;
+            _c4dbgpf("filtering whitespace: line at %zu has %zu spaces", i, num);
+            if( ! leading_whitespace && indentation != csubstr::npos)
+                num = num < indentation ? num : indentation;
+            i += num; // the remaining spaces are moved with the next stretch
         }
     }
+    r.len = w;
 
     _c4dbgpf("filtering whitespace: after=\"%.*s\"", _c4prsp(r));
 
@@ -3873,13 +4450,13 @@ substr Parser::_filter_whitespace(substr r, size_t indentation, bool leading_whi
 }
 
 //-----------------------------------------------------------------------------
-csubstr Parser::_filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e chomp, size_t indentation)
+csubstr filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e chomp, size_t indentation)
 {
     _c4dbgpf("filtering block: ~~~%.*s~~~", _c4prsp(s));
 
     substr r = s;
 
-    r = _filter_whitespace(s, indentation, /*leading whitespace*/false);
+    r = filter_whitespace(s, indentation, /*leading whitespace*/false);
     if(r.begins_with(' ', indentation))
     {
         r = r.erase(0, indentation);
@@ -3914,7 +4491,7 @@ csubstr Parser::_filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e
         break;
     }
     default:
-        _c4err("unknown chomp style");
+        error("unknown chomp style");
     }
 
     _c4dbgpf("filtering block: after chomp=~~~%.*s~~~", _c4prsp(r));
@@ -3930,54 +4507,64 @@ csubstr Parser::_filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e
             {
                 bool is_indented = false;
                 ++pos; // point pos at the first newline char
-                substr t = r.sub(0, pos);
-                for(size_t i = 1; i < t.len; ++i)
+                // read at i and write at w (which is never ahead of
+                // i), moving the stretches between newlines at once
+                char *C4_RESTRICT str = r.str;
+                size_t i = 1, w = 1;
+                while(true)
                 {
-                    const char curr = t[i];
-                    if(curr != '\n')
-                        continue;
-                    size_t nextl = t.first_not_of('\n', i+1);
+                    const size_t nlpos = simd::first_of(str, i, pos, '\n');
+                    if(w != i)
+                        memmove(str + w, str + i, nlpos - i);
+                    w += nlpos - i;
+                    if(nlpos == pos)
+                        break;
+                    // the block does not end with a newline here, so
+                    // the run of newlines is followed by a character
+                    size_t nextl = nlpos + 1;
+                    while(str[nextl] == '\n')
+                        ++nextl;
+                    RYML_ASSERT(nextl < pos);
+                    const size_t num_newlines = nextl - nlpos;
+                    const bool next_is_indented = (str[nextl] == ' ' || str[nextl] == '\t');
                     if(!is_indented)
                     {
-                        if(nextl == i+1)
+                        if(num_newlines == 1)
                         {
-                            if((t[nextl] != ' ') && (t[nextl] != '\t'))
+                            if( ! next_is_indented)
                             {
-                                _c4dbgpf("filtering block[fold]: i=%zu nextl=%zu: single newline, replace with space. curr=~~~%.*s~~~", i, nextl, _c4prsp(r.first(i)));
-                                t[i] = ' ';
+                                _c4dbgpf("filtering block[fold]: nlpos=%zu: single newline, replace with space", nlpos);
+                                str[w++] = ' ';
                             }
                             else
                             {
-                                _c4dbgpf("filtering block[fold]: i=%zu nextl=%zu entering indented mode. curr=~~~%.*s~~~", i, nextl, _c4prsp(r.first(i)));
+                                _c4dbgpf("filtering block[fold]: nlpos=%zu: entering indented mode", nlpos);
+                                str[w++] = '\n';
                                 is_indented = true;
                             }
                         }
-                        else if(nextl != csubstr::npos)
-                        {
-                            _c4dbgpf("filtering block[fold]: i=%zu nextl=%zu: %zu newlines, remove first. curr=~~~%.*s~~~", i, nextl, nextl-1, _c4prsp(r.first(i)));
-                            RYML_ASSERT(nextl >= 1);
-                            t = t.erase(i, 1);
-                            i = nextl-1;
-                            if(i)
-                                --i;
-                        }
                         else
                         {
-                            _c4err("internal error");
-                            break;
+                            _c4dbgpf("filtering block[fold]: nlpos=%zu: %zu newlines, remove first", nlpos, num_newlines);
+                            for(size_t j = 1; j < num_newlines; ++j)
+                                str[w++] = '\n';
                         }
+                        i = nextl;
                     }
                     else
                     {
-                        RYML_ASSERT(is_indented);
-                        if(t[nextl] != ' ' && t[nextl] != '\t')
+                        for(size_t j = 0; j < num_newlines; ++j)
+                            str[w++] = '\n';
+                        i = nextl;
+                        if( ! next_is_indented)
                         {
-                            _c4dbgpf("filtering block[fold]: i=%zu nextl=%zu leaving indented mode. curr=~~~%.*s~~~", i, nextl, _c4prsp(r.first(i)));
+                            _c4dbgpf("filtering block[fold]: nlpos=%zu: leaving indented mode", nlpos);
                             is_indented = false;
-                            i = nextl;
+                            str[w++] = str[i++];
                         }
                     }
                 }
+                substr t = r.first(w);
                 // copy over the trailing newlines
                 substr nl = r.sub(pos);
                 RYML_ASSERT(t.len + nl.len <= r.len);
@@ -3991,7 +4578,7 @@ csubstr Parser::_filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e
         }
         break;
     default:
-        _c4err("unknown block style");
+        error("unknown block style");
     }
 
     _c4dbgpf("filtering block: final='%.*s'", _c4prsp(r));
@@ -4004,6 +4591,8 @@ csubstr Parser::_filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e
     return r;
 }
 
+} // namespace detail
+
 //-----------------------------------------------------------------------------
 bool Parser::_read_decimal(csubstr const& str, size_t *decimal)
 {
@@ -4080,7 +4669,7 @@ void Parser::_err(const char *fmt, ...) const
     va_start(args, fmt);
     len = _fmt_msg(errmsg, len, fmt, args);
     va_end(args);
-    c4::yml::error(errmsg, static_cast<size_t>(len), m_state->pos);
+    c4::yml::error(errmsg, static_cast<size_t>(len), m_pos);
 }
 
 //-----------------------------------------------------------------------------
@@ -4105,7 +4694,7 @@ int Parser::_fmt_msg(char *buf, int buflen, const char *fmt, va_list args) const
 {
     int len = buflen;
     int pos = 0;
-    auto const& lc = m_state->line_contents;
+    auto const& lc = m_line_contents;
 
     // first line: print the message
     int del = vsnprintf(buf + pos, static_cast<size_t>(len), fmt, args);
@@ -4116,11 +4705,11 @@ int Parser::_fmt_msg(char *buf, int buflen, const char *fmt, va_list args) const
     // next line: print the yaml src line
     if( ! m_file.empty())
     {
-        del = snprintf(buf + pos, static_cast<size_t>(len), "%.*s:%zd: '", (int)m_file.len, m_file.str, m_state->pos.line);
+        del = snprintf(buf + pos, static_cast<size_t>(len), "%.*s:%zd: '", (int)m_file.len, m_file.str, m_pos.line);
     }
     else
     {
-        del = snprintf(buf + pos, static_cast<size_t>(len), "line %zd: '", m_state->pos.line);
+        del = snprintf(buf + pos, static_cast<size_t>(len), "line %zd: '", m_pos.line);
     }
     int offs = del;
     _wrapbuf();
@@ -9,10 +9,22 @@
 #include "c4/yml/node.hpp"
 #endif
 
+#ifndef _C4_YML_EVENT_HANDLER_HPP_
+#include "c4/yml/event_handler.hpp"
+#endif
+
 #ifndef _C4_YML_DETAIL_STACK_HPP_
 #include "c4/yml/detail/stack.hpp"
 #endif
 
+#ifndef _C4_YML_DETAIL_LINE_INDEX_HPP_
+#include "c4/yml/detail/line_index.hpp"
+#endif
+
+#ifndef _C4_YML_DETAIL_FILTER_HPP_
+#include "c4/yml/detail/filter.hpp"
+#endif
+
 #include <stdarg.h>
 
 #if defined(_MSC_VER)
@@ -24,6 +36,20 @@ namespace c4 {
 namespace yml {
 
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** YAML features which a parser can be told to reject, for sources
+ * known not to use them. @see Parser::set_restrictions() */
+typedef enum : size_t {
+    NO_ANCHORS      = 1u << 0, //!< no anchors (&), references (*) or merge keys (<<)
+    NO_TAGS         = 1u << 1, //!< no tags (!, !!), and therefore no sets (!!set)
+    NO_COMPLEX_KEYS = 1u << 2, //!< no complex keys (?)
+    NO_DIRECTIVES   = 1u << 3, //!< no directives (%YAML, %TAG)
+} ParserRestriction_e;
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -75,6 +101,41 @@ public:
     void parse(csubstr filename, csubstr src, NodeRef node) { parse(filename, node.tree()->copy_to_arena(src), node.tree(), node.id()); }
 
 
+public:
+
+    //! create a new tree and parse strict JSON into its root.
+    //! This uses a dedicated JSON-only state machine, skipping all the
+    //! YAML machinery (indentation, tags, anchors, plain scalars, line
+    //! folding). Anything which is not valid JSON is an error.
+    Tree parse_json(csubstr filename, csubstr src) { Tree t; t.reserve(_estimate_capacity(src)); parse_json(filename, t.copy_to_arena(src), &t, t.root_id()); return t; }
+    //! create a new tree and parse strict JSON into its root.
+    //! @see parse_json(csubstr, csubstr)
+    Tree parse_json(csubstr filename,  substr src) { Tree t; t.reserve(_estimate_capacity(src)); parse_json(filename, src, &t, t.root_id()); return t; }
+
+    //! parse strict JSON with reuse of a tree
+    void parse_json(csubstr filename,  substr src, Tree *t) { parse_json(filename, src, t, t->root_id()); }
+    //! parse strict JSON with reuse of a tree
+    void parse_json(csubstr filename, csubstr src, Tree *t) { parse_json(filename, t->copy_to_arena(src), t, t->root_id()); }
+
+    //! parse strict JSON directly into a node, which must not have
+    //! children. If the node has a key, the key is kept.
+    void parse_json(csubstr filename,  substr src, Tree *t, size_t node_id); // this is the workhorse overload
+    //! parse strict JSON directly into a node
+    void parse_json(csubstr filename, csubstr src, Tree *t, size_t node_id) { parse_json(filename, t->copy_to_arena(src), t, node_id); }
+
+    //! parse strict JSON directly into a node ref
+    void parse_json(csubstr filename,  substr src, NodeRef node) { parse_json(filename, src, node.tree(), node.id()); }
+    //! parse strict JSON directly into a node ref
+    void parse_json(csubstr filename, csubstr src, NodeRef node) { parse_json(filename, node.tree()->copy_to_arena(src), node.tree(), node.id()); }
+
+    //! parse strict JSON without building a tree, calling back @p handler
+    //! for each event instead. Strings containing escapes are filtered
+    //! in place, so the source buffer is modified.
+    //! @see EventHandler
+    void parse_json(csubstr filename, substr src, EventHandler *handler);
+
+public:
+
     //! reserve a certain capacity for the parsing stack.
     //! This should be at least the expected depth of the parsed YAML tree.
     //! The parsing stack is the only (potential) heap memory used by the parser.
@@ -89,18 +150,46 @@ public:
         m_stack.reserve(capacity);
     }
 
-private:
-
-    typedef enum {
-        BLOCK_LITERAL, //!< keep newlines (|)
-        BLOCK_FOLD     //!< replace newline with single space (>)
-    } BlockStyle_e;
-
-    typedef enum {
-        CHOMP_CLIP,    //!< single newline at end (default)
-        CHOMP_STRIP,   //!< no newline at end     (-)
-        CHOMP_KEEP     //!< all newlines from end (+)
-    } BlockChomp_e;
+    //! enable or disable lazy filtering of scalars. When enabled, vals
+    //! which need filtering (quoted scalars with escapes or newlines,
+    //! multi-line plain scalars and block scalars) are not filtered
+    //! while parsing; instead the tree keeps their raw source, marked
+    //! as VALRAW, and filters it in place when the val is first read.
+    //! Keys, and vals referred to from more than one node, are always
+    //! filtered while parsing. Disabled by default.
+    //! @warning reading a raw val modifies the tree, so a lazy tree
+    //! must not be read from several threads until Tree::filter_raw()
+    //! is called.
+    void set_lazy_filtering(bool yes) { m_lazy_filtering = yes; }
+    bool lazy_filtering() const { return m_lazy_filtering; }
+
+    //! enable or disable recording the source offsets of the key and
+    //! val of each node created by parse(), so that the node can later
+    //! be mapped back to its line and column with key_location() and
+    //! val_location(), eg to report a validation error, without
+    //! parsing again. The lines and columns are computed only when
+    //! asked for. Disabled by default, when nothing is recorded.
+    void set_locations(bool yes) { m_locations_enabled = yes; }
+    bool locations() const { return m_locations_enabled; }
+
+    //! set the YAML features which the parser rejects, as a mask of
+    //! ParserRestriction_e flags, eg NO_ANCHORS|NO_TAGS. This is a
+    //! validation option, checked at runtime: a restricted feature
+    //! found in the source is a parse error naming the feature. It
+    //! does not make parsing faster. Nothing is restricted by default.
+    void set_restrictions(size_t mask) { m_restrictions = mask; }
+    size_t restrictions() const { return m_restrictions; }
+
+    //! get the location of the key of a node created by the last call
+    //! to parse(), whose source buffer must still be alive. Returns an
+    //! empty location (line 0) if the node has no key, or if its
+    //! location was not recorded.
+    Location key_location(size_t node);
+    //! get the location of the val of a node created by the last call
+    //! to parse(): the beginning of the scalar, or for a container, the
+    //! place where the parser started it. Returns an empty location
+    //! (line 0) if the location was not recorded.
+    Location val_location(size_t node);
 
 private:
 
@@ -133,11 +222,13 @@ private:
     csubstr _scan_to_next_nonempty_line(size_t indentation);
     csubstr _extend_scanned_scalar(csubstr currscalar);
 
-    csubstr _filter_squot_scalar(substr s);
-    csubstr _filter_dquot_scalar(substr s);
     csubstr _filter_plain_scalar(substr s, size_t indentation);
-    csubstr _filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e chomp, size_t indentation);
-    substr  _filter_whitespace(substr s, size_t indentation=0, bool leading_whitespace=true);
+    csubstr _keep_raw_scalar(csubstr raw);
+    void    _finish_raw_scalars();
+
+    void     _record_location(size_t node);
+    size_t   _offset_of(csubstr s) const;
+    Location _location_of(size_t offset);
 
     void  _handle_finished_file();
     void  _handle_line();
@@ -150,6 +241,15 @@ private:
     bool  _handle_seq_expl();
     bool  _handle_seq_impl();
     bool  _handle_top();
+
+    /** the handler of a line in each state, indexed by the state code
+     * made of the flags RUNK, RMAP, RSEQ and EXPL. A null handler, or
+     * one which returns false, leaves the line to _handle_top().
+     * @see _handle_line() */
+    using pfn_line_handler = bool (Parser::*)();
+    static const pfn_line_handler s_line_handlers[16];
+
+    void  _check_restriction(size_t restriction, const char *feature) const;
     bool  _handle_types();
     bool  _handle_key_anchors_and_refs();
     bool  _handle_val_anchors_and_refs();
@@ -197,6 +297,17 @@ private:
     void  _write_key_anchor(size_t node_id);
     void  _write_val_anchor(size_t node_id);
 
+private:
+
+    template<class Handler>
+    void    _parse_json(Handler *handler);
+    size_t  _json_skip_ws(size_t pos) const;
+    size_t  _json_scan_key(size_t pos, csubstr *key);
+    size_t  _json_scan_string(size_t pos, csubstr *s);
+    size_t  _json_scan_literal(size_t pos, csubstr *s);
+    csubstr _filter_json_dquot_scalar(substr s);
+    void    _json_locate(size_t pos);
+
 private:
 
     static bool   _read_decimal(csubstr const& str, size_t *decimal);
@@ -233,7 +344,7 @@ private:
 
         LineContents() : full(), stripped(), rem(), indentation() {}
 
-        void reset_with_next_line(csubstr buf, size_t pos);
+        void reset_with_next_line(detail::LineIndex const& lines, csubstr buf, size_t pos);
 
         void reset(csubstr full_, csubstr stripped_)
         {
@@ -244,6 +355,15 @@ private:
             indentation = full.first_not_of(' ');
         }
 
+        void reset(csubstr full_, csubstr stripped_, size_t indentation_)
+        {
+            RYML_ASSERT(indentation_ == full_.first_not_of(' '));
+            full = full_;
+            stripped = stripped_;
+            rem = stripped_;
+            indentation = indentation_;
+        }
+
         size_t current_col() const
         {
             return current_col(rem);
@@ -258,6 +378,10 @@ private:
         }
     };
 
+    /** the state of each level of the stack. It is pushed and popped
+     * for every nested container, so it holds only what is particular to
+     * the level: the position in the source and the current line are
+     * the same for every level, and live in the parser. */
     struct State
     {
         size_t       flags;
@@ -265,21 +389,14 @@ private:
         size_t       node_id; // don't hold a pointer to the node as it will be relocated during tree resizes
         csubstr      scalar;
         size_t       scalar_col; // the column where the scalar (or its quotes) begin
-
-        Location     pos;
-        LineContents line_contents;
         size_t       indref;
 
-        State() : flags(), level(), node_id(), scalar(), scalar_col(), pos(), line_contents(), indref() {}
+        State() : flags(), level(), node_id(), scalar(), scalar_col(), indref() {}
 
-        void reset(const char *file, size_t node_id_)
+        void reset(size_t node_id_)
         {
             flags = RUNK|RTOP;
             level = 0;
-            pos.name = to_csubstr(file);
-            pos.offset = 0;
-            pos.line = 1;
-            pos.col = 1;
             node_id = node_id_;
             scalar_col = 0;
             scalar.clear();
@@ -296,23 +413,21 @@ private:
         RYML_ASSERT(m_stack.size() > 1);
         State const& curr = m_stack.top();
         State      & next = m_stack.top(1);
-        next.pos = curr.pos;
-        next.line_contents = curr.line_contents;
         next.scalar = curr.scalar;
     }
 
     inline bool _at_line_begin() const
     {
-        return m_state->line_contents.rem.begin() == m_state->line_contents.full.begin();
+        return m_line_contents.rem.begin() == m_line_contents.full.begin();
     }
     inline bool _at_line_end() const
     {
-        csubstr r = m_state->line_contents.rem;
+        csubstr r = m_line_contents.rem;
         return r.empty() || r.begins_with(' ', r.len);
     }
     inline bool _token_is_from_this_line(csubstr token) const
     {
-        return token.is_sub(m_state->line_contents.full);
+        return token.is_sub(m_line_contents.full);
     }
 
     inline NodeData * node(State const* s) const { return m_tree->get(s->node_id); }
@@ -357,6 +472,12 @@ private:
     detail::stack<State> m_stack;
     State * m_state;
 
+    Location     m_pos;
+    LineContents m_line_contents;
+
+    detail::LineIndex m_newlines;
+    detail::stack<char> m_json_stack;
+
     size_t  m_key_tag_indentation;
     size_t  m_key_tag2_indentation;
     csubstr m_key_tag;
@@ -370,6 +491,29 @@ private:
     size_t  m_val_anchor_indentation;
     csubstr m_val_anchor;
 
+    struct RawScalar
+    {
+        csubstr raw;      //!< the raw span, as returned by the scan
+        csubstr filtered; //!< the filtered span, once filtered
+        size_t  num_refs; //!< the number of node scalars pointing at raw
+        bool    eager;    //!< whether it must be filtered in parse()
+    };
+
+    bool    m_lazy_filtering;
+    detail::stack<RawScalar> m_raw_scalars;
+
+    struct NodeLocation
+    {
+        size_t key; //!< the source offset of the key, or npos
+        size_t val; //!< the source offset of the val, or npos
+    };
+
+    bool    m_locations_enabled;
+    detail::stack<NodeLocation> m_locations; //!< indexed by node id
+    detail::stack<size_t> m_line_starts;     //!< built on the first location query
+
+    size_t  m_restrictions; //!< see set_restrictions()
+
 };
 
 
@@ -397,6 +541,25 @@ inline void parse(csubstr filename,  substr buf, NodeRef node) { Parser np; np.p
 inline void parse(                  csubstr buf, NodeRef node) { Parser np; np.parse({}      , buf, node); } //!< reusing the YAML tree, parse a read-only YAML source buffer, copying it first to the tree's source arena.
 inline void parse(csubstr filename, csubstr buf, NodeRef node) { Parser np; np.parse(filename, buf, node); } //!< reusing the YAML tree, parse a read-only YAML source buffer, copying it first to the tree's source arena, providing a filename for error messages.
 
+
+inline Tree parse_json(                   substr buf) { Parser np; return np.parse_json({}      , buf); } //!< parse in-situ a modifiable strict JSON source buffer.
+inline Tree parse_json(csubstr filename,  substr buf) { Parser np; return np.parse_json(filename, buf); } //!< parse in-situ a modifiable strict JSON source buffer, providing a filename for error messages.
+inline Tree parse_json(                  csubstr buf) { Parser np; return np.parse_json({}      , buf); } //!< parse a read-only strict JSON source buffer, copying it first to the tree's source arena.
+inline Tree parse_json(csubstr filename, csubstr buf) { Parser np; return np.parse_json(filename, buf); } //!< parse a read-only strict JSON source buffer, copying it first to the tree's source arena, providing a filename for error messages.
+
+inline void parse_json(                   substr buf, Tree *t) { Parser np; np.parse_json({}      , buf, t); } //!< reusing the tree, parse in-situ a modifiable strict JSON source buffer
+inline void parse_json(csubstr filename,  substr buf, Tree *t) { Parser np; np.parse_json(filename, buf, t); } //!< reusing the tree, parse in-situ a modifiable strict JSON source buffer, providing a filename for error messages.
+inline void parse_json(                  csubstr buf, Tree *t) { Parser np; np.parse_json({}      , buf, t); } //!< reusing the tree, parse a read-only strict JSON source buffer, copying it first to the tree's source arena.
+inline void parse_json(csubstr filename, csubstr buf, Tree *t) { Parser np; np.parse_json(filename, buf, t); } //!< reusing the tree, parse a read-only strict JSON source buffer, copying it first to the tree's source arena, providing a filename for error messages.
+
+inline void parse_json(                   substr buf, NodeRef node) { Parser np; np.parse_json({}      , buf, node); } //!< reusing the tree, parse in-situ a modifiable strict JSON source buffer
+inline void parse_json(csubstr filename,  substr buf, NodeRef node) { Parser np; np.parse_json(filename, buf, node); } //!< reusing the tree, parse in-situ a modifiable strict JSON source buffer, providing a filename for error messages.
+inline void parse_json(                  csubstr buf, NodeRef node) { Parser np; np.parse_json({}      , buf, node); } //!< reusing the tree, parse a read-only strict JSON source buffer, copying it first to the tree's source arena.
+inline void parse_json(csubstr filename, csubstr buf, NodeRef node) { Parser np; np.parse_json(filename, buf, node); } //!< reusing the tree, parse a read-only strict JSON source buffer, copying it first to the tree's source arena, providing a filename for error messages.
+
+inline void parse_json(                   substr buf, EventHandler *handler) { Parser np; np.parse_json({}      , buf, handler); } //!< parse in-situ a modifiable strict JSON source buffer, calling back the handler instead of building a tree
+inline void parse_json(csubstr filename,  substr buf, EventHandler *handler) { Parser np; np.parse_json(filename, buf, handler); } //!< parse in-situ a modifiable strict JSON source buffer, calling back the handler instead of building a tree, providing a filename for error messages.
+
 } // namespace yml
 } // namespace c4
 
@@ -0,0 +1,398 @@
+#include "c4/yml/push_parser.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace c4 {
+namespace yml {
+
+JsonPushParser::JsonPushParser(Allocator const& a)
+    : m_handler(nullptr)
+    , m_sink(a)
+    , m_stack(a)
+    , m_carry(a)
+    , m_state(kValue)
+    , m_started(false)
+    , m_carrying(false)
+    , m_string_is_key(false)
+    , m_string_escaped(false)
+    , m_pending_backslash(false)
+    , m_offset(0)
+    , m_token_pos(0)
+    , m_line(1)
+    , m_line_pos(0)
+{
+}
+
+void JsonPushParser::begin(EventHandler *handler)
+{
+    RYML_CHECK(handler != nullptr);
+    m_handler = handler;
+    m_stack.clear();
+    m_carry.clear();
+    m_state = kValue;
+    m_started = false;
+    m_carrying = false;
+    m_string_is_key = false;
+    m_string_escaped = false;
+    m_pending_backslash = false;
+    m_offset = 0;
+    m_token_pos = 0;
+    m_line = 1;
+    m_line_pos = 0;
+}
+
+void JsonPushParser::begin(Tree *t, size_t node_id)
+{
+    RYML_CHECK(t != nullptr);
+    RYML_CHECK( ! t->has_children(node_id));
+    m_sink.m_builder = detail::JsonTreeBuilder(t, node_id);
+    m_sink.m_key.clear();
+    begin(&m_sink);
+}
+
+
+//-----------------------------------------------------------------------------
+
+void JsonPushParser::feed(csubstr chunk)
+{
+    RYML_CHECK(m_handler != nullptr && "begin() was not called");
+    size_t i = 0;
+    while(i < chunk.len)
+    {
+        if(m_state == kString)
+        {
+            i = _scan_string(chunk, i);
+        }
+        else if(m_state == kLiteral)
+        {
+            i = _scan_literal(chunk, i);
+        }
+        else if(detail::is_json_ws(chunk.str[i]))
+        {
+            // strings and literals cannot have newlines, so this is the
+            // only place where lines need to be counted
+            if(chunk.str[i] == '\n')
+            {
+                ++m_line;
+                m_line_pos = m_offset + i + 1;
+            }
+            ++i;
+        }
+        else if(m_state == kDone)
+        {
+            _err(m_offset + i, "unexpected characters after the document");
+            return;
+        }
+        else
+        {
+            i = _handle_structure(chunk, i);
+        }
+    }
+    m_offset += chunk.len;
+}
+
+void JsonPushParser::finish()
+{
+    RYML_CHECK(m_handler != nullptr && "begin() was not called");
+    // a literal is terminated only by the character after it,
+    // so a top-level literal is complete only now
+    if(m_state == kLiteral)
+        _end_literal(csubstr(m_carry.m_stack, m_carry.size()));
+    if(m_state == kString)
+        _err(m_token_pos, "unterminated string");
+    else if( ! m_started)
+        _err(m_offset, "empty document");
+    else if(m_state != kDone)
+        _err(m_offset, "unexpected end of document, expected '%c'", m_stack.top());
+}
+
+
+//-----------------------------------------------------------------------------
+
+size_t JsonPushParser::_handle_structure(csubstr chunk, size_t i)
+{
+    const char c = chunk.str[i];
+    const size_t pos = m_offset + i;
+    // an empty container
+    if((m_state == kValueOrClose && c == ']') || (m_state == kKeyOrClose && c == '}'))
+    {
+        _close();
+        return i + 1;
+    }
+    switch(m_state)
+    {
+    case kValue:
+    case kValueOrClose:
+        if( ! m_started)
+        {
+            m_started = true;
+            m_handler->begin_doc();
+        }
+        if(c == '{')
+        {
+            m_handler->begin_map();
+            m_stack.push('}');
+            m_state = kKeyOrClose;
+        }
+        else if(c == '[')
+        {
+            m_handler->begin_seq();
+            m_stack.push(']');
+            m_state = kValueOrClose;
+        }
+        else if(c == '"')
+        {
+            m_string_is_key = false;
+            _begin_token(kString, pos);
+        }
+        else if(c == ']' || c == '}' || c == ',' || c == ':')
+        {
+            _err(pos, "expected a value");
+        }
+        else
+        {
+            _begin_token(kLiteral, pos);
+            return i; // the literal starts at this character
+        }
+        return i + 1;
+    case kKey:
+    case kKeyOrClose:
+        if(c != '"')
+            _err(pos, "expected a double-quoted key");
+        m_string_is_key = true;
+        _begin_token(kString, pos);
+        return i + 1;
+    case kColon:
+        if(c != ':')
+            _err(pos, "expected ':'");
+        m_state = kValue;
+        return i + 1;
+    case kNext:
+        if(c == ',')
+            m_state = m_stack.top() == '}' ? kKey : kValue;
+        else if(c == m_stack.top())
+            _close();
+        else
+            _err(pos, "expected ',' or '%c'", m_stack.top());
+        return i + 1;
+    default:
+        C4_NEVER_REACH();
+    }
+    return i + 1;
+}
+
+size_t JsonPushParser::_scan_string(csubstr chunk, size_t i)
+{
+    size_t j = i;
+    if(m_pending_backslash)
+    {
+        // the previous chunk ended with a backslash, so this
+        // character is escaped and cannot close the string
+        m_pending_backslash = false;
+        ++j;
+    }
+    for( ; j < chunk.len; ++j)
+    {
+        const char c = chunk.str[j];
+        if(c == '"')
+        {
+            if( ! m_carrying && ! m_string_escaped)
+            {
+                _end_string(chunk.range(i, j));
+            }
+            else
+            {
+                _carry(chunk.range(i, j));
+                _end_string(csubstr(m_carry.m_stack, m_carry.size()));
+            }
+            return j + 1;
+        }
+        else if(c == '\\')
+        {
+            m_string_escaped = true;
+            if(j + 1 == chunk.len)
+            {
+                m_pending_backslash = true;
+                break;
+            }
+            ++j; // the escaped character cannot close the string
+        }
+        else if(static_cast<unsigned char>(c) < 0x20)
+        {
+            _err(m_offset + j, "control characters must be escaped in strings");
+        }
+    }
+    _carry(chunk.sub(i));
+    return chunk.len;
+}
+
+size_t JsonPushParser::_scan_literal(csubstr chunk, size_t i)
+{
+    size_t j = i;
+    while(j < chunk.len && ! detail::is_json_literal_end(chunk.str[j]))
+        ++j;
+    if(j == chunk.len)
+    {
+        _carry(chunk.sub(i));
+        return j;
+    }
+    if( ! m_carrying)
+    {
+        _end_literal(chunk.range(i, j));
+    }
+    else
+    {
+        _carry(chunk.range(i, j));
+        _end_literal(csubstr(m_carry.m_stack, m_carry.size()));
+    }
+    return j; // the terminating character is handled next
+}
+
+
+//-----------------------------------------------------------------------------
+
+void JsonPushParser::_begin_token(State_e st, size_t pos)
+{
+    m_state = st;
+    m_token_pos = pos;
+    m_carrying = false;
+    m_string_escaped = false;
+    m_carry.clear();
+}
+
+void JsonPushParser::_carry(csubstr s)
+{
+    const size_t sz = m_carry.size();
+    m_carry.resize(sz + s.len);
+    if(s.len)
+        memcpy(m_carry.m_stack + sz, s.str, s.len);
+    m_carrying = true;
+}
+
+void JsonPushParser::_end_string(csubstr s)
+{
+    if(m_string_escaped)
+    {
+        // only the carry buffer is modifiable
+        if( ! m_carrying)
+            _carry(s);
+        size_t err_pos;
+        s = detail::unescape_json_string(substr(m_carry.m_stack, m_carry.size()), &err_pos);
+        if(err_pos != npos)
+            _err(m_token_pos + 1 + err_pos, "invalid escape");
+    }
+    if(m_string_is_key)
+    {
+        m_handler->key(s, true);
+        m_state = kColon;
+    }
+    else
+    {
+        m_handler->scalar(s, true);
+        _value_done();
+    }
+}
+
+void JsonPushParser::_end_literal(csubstr s)
+{
+    if( ! detail::is_json_literal(s))
+        _err(m_token_pos, "invalid value '%.*s'", static_cast<int>(s.len), s.str);
+    m_handler->scalar(s != "null" ? s : csubstr{}, false);
+    _value_done();
+}
+
+void JsonPushParser::_value_done()
+{
+    m_carrying = false;
+    if(m_stack.empty())
+    {
+        m_state = kDone;
+        m_handler->end_doc();
+    }
+    else
+    {
+        m_state = kNext;
+    }
+}
+
+void JsonPushParser::_close()
+{
+    const char closing = m_stack.pop();
+    if(closing == '}')
+        m_handler->end_map();
+    else
+        m_handler->end_seq();
+    _value_done();
+}
+
+void JsonPushParser::_err(size_t pos, const char *fmt, ...) const
+{
+#ifndef RYML_ERRMSG_SIZE
+    #define RYML_ERRMSG_SIZE 1024
+#endif
+    char errmsg[RYML_ERRMSG_SIZE];
+    int len = snprintf(errmsg, sizeof(errmsg), "ERROR parsing json: ");
+    va_list args;
+    va_start(args, fmt);
+    len += vsnprintf(errmsg + len, sizeof(errmsg) - static_cast<size_t>(len), fmt, args);
+    va_end(args);
+    if(len >= static_cast<int>(sizeof(errmsg)))
+        len = static_cast<int>(sizeof(errmsg)) - 1;
+    // the position is always in the current line: only whitespace
+    // can have newlines
+    const size_t col = pos >= m_line_pos ? 1 + pos - m_line_pos : 1;
+    c4::yml::error(errmsg, static_cast<size_t>(len), Location(csubstr{}, pos, m_line, col));
+}
+
+
+//-----------------------------------------------------------------------------
+
+void JsonPushParser::TreeSink::key(csubstr k, bool /*quoted*/)
+{
+    // keep the key until its value arrives, so that both can be
+    // copied to the arena at once: copying only the key now could
+    // have it invalidated by a relocation of the arena. The value
+    // clears it, as the elements of a seq that follows have no key.
+    m_key.resize(k.len);
+    if(k.len)
+        memcpy(m_key.m_stack, k.str, k.len);
+}
+
+void JsonPushParser::TreeSink::begin_map()
+{
+    if(m_key.size())
+        m_builder.m_key = m_builder.m_tree->copy_to_arena(csubstr(m_key.m_stack, m_key.size()));
+    else
+        m_builder.m_key = "";
+    m_key.clear();
+    m_builder.begin_map();
+}
+
+void JsonPushParser::TreeSink::begin_seq()
+{
+    if(m_key.size())
+        m_builder.m_key = m_builder.m_tree->copy_to_arena(csubstr(m_key.m_stack, m_key.size()));
+    else
+        m_builder.m_key = "";
+    m_key.clear();
+    m_builder.begin_seq();
+}
+
+void JsonPushParser::TreeSink::scalar(csubstr s, bool quoted)
+{
+    const size_t klen = m_key.size();
+    substr mem = klen + s.len ? m_builder.m_tree->alloc_arena(klen + s.len) : substr{};
+    if(klen)
+        memcpy(mem.str, m_key.m_stack, klen);
+    if(s.len)
+        memcpy(mem.str + klen, s.str, s.len);
+    m_builder.m_key = klen ? csubstr(mem.first(klen)) : csubstr("");
+    m_key.clear();
+    csubstr val = s.len ? csubstr(mem.sub(klen)) : s.str != nullptr ? csubstr("") : csubstr{};
+    m_builder.scalar(val, quoted);
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,166 @@
+#ifndef _C4_YML_PUSH_PARSER_HPP_
+#define _C4_YML_PUSH_PARSER_HPP_
+
+/** @file push_parser.hpp Incremental parsing of JSON received in
+ * chunks, eg from a socket or from a file read in blocks. */
+
+#ifndef _C4_YML_NODE_HPP_
+#include "c4/yml/node.hpp"
+#endif
+
+#ifndef _C4_YML_EVENT_HANDLER_HPP_
+#include "c4/yml/event_handler.hpp"
+#endif
+
+#ifndef _C4_YML_DETAIL_STACK_HPP_
+#include "c4/yml/detail/stack.hpp"
+#endif
+
+#ifndef _C4_YML_DETAIL_JSON_HPP_
+#include "c4/yml/detail/json.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+/** A resumable JSON parser which is given the input chunk by chunk, so
+ * that the whole source never needs to be in memory at once. The chunks
+ * can be split anywhere, even in the middle of a token.
+ *
+ * Events are sent as soon as they are complete: a container is opened
+ * when its opening bracket arrives, and a scalar is sent once its
+ * closing quote (or, for literals, the character after it) arrives.
+ * Only the token which straddles a chunk boundary is kept by the
+ * parser, so the memory needed is bounded by the longest scalar and by
+ * the nesting depth, and not by the size of the document.
+ *
+ * Usage:
+ * @code
+ * JsonPushParser pp;
+ * pp.begin(&tree);
+ * while(read_chunk(&chunk))
+ *     pp.feed(chunk);
+ * pp.finish();
+ * @endcode
+ *
+ * When parsing into an EventHandler, the scalars it receives may point
+ * into the chunk or into the parser's own buffer, and are valid only
+ * until the callback returns. When parsing into a tree, the scalars are
+ * copied to the tree's arena.
+ *
+ * Errors are reported through the error callback with the location in
+ * the whole input, not in the chunk.
+ *
+ * @note there is no push parser for YAML, and Parser::parse() still
+ * needs the whole source in one buffer. The YAML parser looks ahead
+ * across lines (eg to find the indentation of a block scalar, or the
+ * end of a multi-line plain scalar), keeps pointers into the source in
+ * its state, and moves nodes of the tree as it learns more about them,
+ * so it cannot be suspended at an arbitrary point of the input. YAML
+ * received in chunks must first be gathered into one buffer.
+ *
+ * @see Parser::parse_json() for parsing JSON which is already in memory */
+class RYML_EXPORT JsonPushParser
+{
+public:
+
+    JsonPushParser(Allocator const& a={});
+
+public:
+
+    /** start parsing a new document, sending its events to @p handler */
+    void begin(EventHandler *handler);
+    /** start parsing a new document into the given node, which must have
+     * no children. */
+    void begin(Tree *t, size_t node_id);
+    /** start parsing a new document into the root of the given tree */
+    void begin(Tree *t) { begin(t, t->root_id()); }
+    /** start parsing a new document into the given node */
+    void begin(NodeRef node) { begin(node.tree(), node.id()); }
+
+    /** parse the next chunk of input. */
+    void feed(csubstr chunk);
+
+    /** signal the end of the input. This is an error if the document is
+     * incomplete. */
+    void finish();
+
+    /** whether the document is complete. Only whitespace is accepted
+     * after this. */
+    bool done() const { return m_state == kDone; }
+
+    /** the number of bytes fed so far */
+    size_t offset() const { return m_offset; }
+
+private:
+
+    typedef enum {
+        kValue,         ///< expecting a value
+        kValueOrClose,  ///< expecting a value or ']', right after '['
+        kKey,           ///< expecting a key
+        kKeyOrClose,    ///< expecting a key or '}', right after '{'
+        kColon,         ///< expecting ':' after a key
+        kNext,          ///< expecting ',' or the closing char, after a value
+        kString,        ///< inside a string
+        kLiteral,       ///< inside a literal: true, false, null or a number
+        kDone,          ///< the document is complete
+    } State_e;
+
+    /** copies the scalars to the tree's arena, as the chunks are
+     * transient */
+    struct TreeSink : public EventHandler
+    {
+        detail::JsonTreeBuilder m_builder;
+        detail::stack<char> m_key;
+
+        TreeSink(Allocator const& a) : m_builder(nullptr, NONE), m_key(a) {}
+
+        void begin_map() override;
+        void end_map() override { m_builder.end_map(); }
+        void begin_seq() override;
+        void end_seq() override { m_builder.end_seq(); }
+        void key(csubstr k, bool quoted) override;
+        void scalar(csubstr s, bool quoted) override;
+    };
+
+private:
+
+    size_t _handle_structure(csubstr chunk, size_t i);
+    size_t _scan_string(csubstr chunk, size_t i);
+    size_t _scan_literal(csubstr chunk, size_t i);
+
+    void _begin_token(State_e st, size_t pos);
+    void _carry(csubstr s);
+    void _end_string(csubstr s);
+    void _end_literal(csubstr s);
+    void _value_done();
+    void _close();
+
+    void _err(size_t pos, const char *fmt, ...) const;
+
+private:
+
+    EventHandler *m_handler;
+    TreeSink      m_sink;
+
+    detail::stack<char> m_stack;  ///< the closing chars of the open containers
+    detail::stack<char> m_carry;  ///< the part of the current token received in previous chunks
+
+    State_e m_state;
+    bool    m_started;            ///< whether begin_doc() was sent
+    bool    m_carrying;           ///< whether the current token started in a previous chunk
+    bool    m_string_is_key;
+    bool    m_string_escaped;     ///< whether the current string has escapes
+    bool    m_pending_backslash;  ///< the previous chunk ended with a backslash in a string
+
+    size_t  m_offset;             ///< the offset of the current chunk in the whole input
+    size_t  m_token_pos;          ///< the offset of the current token
+    size_t  m_line;               ///< the current line, starting at 1
+    size_t  m_line_pos;           ///< the offset of the current line
+
+};
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_PUSH_PARSER_HPP_ */
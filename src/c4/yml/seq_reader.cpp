@@ -0,0 +1,346 @@
+#include "c4/yml/seq_reader.hpp"
+
+#include <string.h>
+
+namespace c4 {
+namespace yml {
+
+namespace {
+
+struct Line
+{
+    csubstr rest;        ///< the contents after the indentation, without trailing whitespace
+    size_t  indentation;
+    size_t  next;        ///< the offset of the next line
+};
+
+Line _get_line(csubstr src, size_t pos)
+{
+    Line l;
+    const void *nl = memchr(src.str + pos, '\n', src.len - pos);
+    const size_t eol = nl ? static_cast<size_t>(static_cast<const char*>(nl) - src.str) : src.len;
+    l.next = nl ? eol + 1 : src.len;
+    size_t i = pos;
+    while(i < eol && src.str[i] == ' ')
+        ++i;
+    l.indentation = i - pos;
+    l.rest = src.range(i, eol).trimr(" \t\r");
+    return l;
+}
+
+inline bool _is_blank_or_comment(Line const& l)
+{
+    return l.rest.empty() || l.rest.str[0] == '#';
+}
+
+inline bool _is_seq_entry(csubstr rest)
+{
+    return rest.begins_with('-') && (rest.len == 1 || rest.str[1] == ' ' || rest.str[1] == '\t');
+}
+
+inline bool _is_doc_marker(csubstr rest)
+{
+    return (rest.begins_with("---") || rest.begins_with("..."))
+        && (rest.len == 3 || rest.str[3] == ' ' || rest.str[3] == '\t');
+}
+
+inline bool _is_flow_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+
+SeqReader::SeqReader(Allocator const& a)
+    : m_parser(a)
+    , m_tree(a)
+    , m_file()
+    , m_src()
+    , m_pos(0)
+    , m_indentation(0)
+    , m_mode(kEnd)
+    , m_index(NONE)
+    , m_elem_src()
+{
+}
+
+void SeqReader::reset(csubstr filename, csubstr src)
+{
+    m_file = filename;
+    m_src = src;
+    m_pos = 0;
+    m_indentation = 0;
+    m_mode = kStart;
+    m_index = NONE;
+    m_elem_src = {};
+}
+
+bool SeqReader::next()
+{
+    if(m_mode == kStart)
+        _read_start();
+    csubstr elem;
+    if(m_mode == kBlock)
+    {
+        if( ! _next_block(&elem))
+            m_mode = kEnd;
+    }
+    else if(m_mode == kFlow)
+    {
+        if( ! _next_flow(&elem))
+            m_mode = kEnd;
+    }
+    if(m_mode == kEnd)
+    {
+        m_elem_src = {};
+        return false;
+    }
+    // recycle the nodes and the arena of the previous element
+    m_tree.clear();
+    m_tree.clear_arena();
+    if(m_mode == kBlock)
+    {
+        // the element keeps its indentation, so it parses as a
+        // sequence with a single element
+        m_parser.parse(m_file, elem, &m_tree);
+    }
+    else
+    {
+        substr buf = m_tree.alloc_arena(elem.len + 2);
+        buf.str[0] = '[';
+        memcpy(buf.str + 1, elem.str, elem.len);
+        buf.str[buf.len - 1] = ']';
+        m_parser.parse(m_file, buf, &m_tree);
+    }
+    RYML_ASSERT(m_tree.rootref().is_seq() && m_tree.rootref().num_children() == 1);
+    m_elem_src = elem;
+    m_index = m_index == NONE ? 0 : m_index + 1;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+void SeqReader::_read_start()
+{
+    size_t pos = 0;
+    while(pos < m_src.len)
+    {
+        Line l = _get_line(m_src, pos);
+        const size_t beg = pos + l.indentation;
+        csubstr rest = l.rest;
+        if(_is_blank_or_comment(l) || (l.indentation == 0 && rest.begins_with('%')))
+        {
+            pos = l.next;
+            continue;
+        }
+        if(l.indentation == 0 && _is_doc_marker(rest) && rest.begins_with("---"))
+        {
+            // the document may start in the same line
+            rest = rest.sub(3).triml(" \t");
+            if(rest.empty() || rest.begins_with('#'))
+            {
+                pos = l.next;
+                continue;
+            }
+            if( ! rest.begins_with('['))
+                _err(static_cast<size_t>(rest.str - m_src.str), "ERROR parsing yml: the document is not a sequence");
+            m_mode = kFlow;
+            m_pos = static_cast<size_t>(rest.str - m_src.str) + 1;
+            return;
+        }
+        if(rest.begins_with('['))
+        {
+            m_mode = kFlow;
+            m_pos = beg + 1;
+        }
+        else if(_is_seq_entry(rest))
+        {
+            m_mode = kBlock;
+            m_pos = pos;
+            m_indentation = l.indentation;
+        }
+        else
+        {
+            _err(beg, "ERROR parsing yml: the document is not a sequence");
+        }
+        return;
+    }
+    m_mode = kEnd; // an empty document
+}
+
+bool SeqReader::_next_block(csubstr *elem)
+{
+    // find the first line of the element
+    size_t pos = m_pos;
+    Line l;
+    while(pos < m_src.len)
+    {
+        l = _get_line(m_src, pos);
+        if(_is_blank_or_comment(l))
+        {
+            pos = l.next;
+            continue;
+        }
+        if(l.indentation != m_indentation || ! _is_seq_entry(l.rest))
+        {
+            _check_end(pos);
+            return false;
+        }
+        break;
+    }
+    if(pos >= m_src.len)
+        return false;
+    // the element lasts until the next line which is not more indented
+    const size_t start = pos;
+    pos = l.next;
+    while(pos < m_src.len)
+    {
+        l = _get_line(m_src, pos);
+        if( ! _is_blank_or_comment(l) && l.indentation <= m_indentation)
+            break;
+        pos = l.next;
+    }
+    *elem = m_src.range(start, pos);
+    m_pos = pos;
+    return true;
+}
+
+bool SeqReader::_next_flow(csubstr *elem)
+{
+    size_t pos = _skip_flow_ws(m_pos);
+    if(pos >= m_src.len)
+        _err(pos, "ERROR parsing yml: unterminated flow sequence");
+    if(m_src.str[pos] == ']')
+    {
+        _check_end(pos + 1);
+        return false;
+    }
+    const size_t start = pos;
+    size_t end = pos; // past the last character which is not whitespace or comment
+    size_t depth = 0;
+    while(true)
+    {
+        if(pos >= m_src.len)
+            _err(start, "ERROR parsing yml: unterminated flow sequence");
+        const char c = m_src.str[pos];
+        if(c == '[' || c == '{')
+        {
+            ++depth;
+        }
+        else if(c == ']' || c == '}')
+        {
+            if(depth == 0)
+            {
+                if(c != ']')
+                    _err(pos, "ERROR parsing yml: unexpected '}'");
+                break;
+            }
+            --depth;
+        }
+        else if(c == ',')
+        {
+            if(depth == 0)
+                break;
+        }
+        else if((c == '"' || c == '\'') && (pos == start || _is_flow_ws(m_src.str[pos-1]) || csubstr("[{,:").first_of(m_src.str[pos-1]) != npos))
+        {
+            pos = end = _skip_flow_scalar(pos);
+            continue;
+        }
+        else if(c == '#' && _is_flow_ws(m_src.str[pos-1]))
+        {
+            const void *nl = memchr(m_src.str + pos, '\n', m_src.len - pos);
+            pos = nl ? static_cast<size_t>(static_cast<const char*>(nl) - m_src.str) : m_src.len;
+            continue;
+        }
+        if( ! _is_flow_ws(c))
+            end = pos + 1;
+        ++pos;
+    }
+    // a trailing comment would swallow the bracket closing the element
+    *elem = m_src.range(start, end);
+    if(elem->empty())
+        _err(start, "ERROR parsing yml: empty element in flow sequence");
+    // leave the closing bracket to be found by the next call
+    m_pos = m_src.str[pos] == ',' ? pos + 1 : pos;
+    return true;
+}
+
+/** after the sequence, only comments are allowed until the end of the
+ * document */
+void SeqReader::_check_end(size_t pos)
+{
+    // pos may be in the middle of a line, after a closing bracket
+    bool line_start = pos == 0 || m_src.str[pos - 1] == '\n';
+    while(pos < m_src.len)
+    {
+        Line l = _get_line(m_src, pos);
+        if(line_start && l.indentation == 0 && _is_doc_marker(l.rest))
+            return;
+        if( ! _is_blank_or_comment(l))
+            _err(pos + l.indentation, "ERROR parsing yml: unexpected contents after the sequence");
+        pos = l.next;
+        line_start = true;
+    }
+}
+
+size_t SeqReader::_skip_flow_ws(size_t pos) const
+{
+    while(pos < m_src.len)
+    {
+        const char c = m_src.str[pos];
+        if(_is_flow_ws(c))
+        {
+            ++pos;
+        }
+        else if(c == '#')
+        {
+            const void *nl = memchr(m_src.str + pos, '\n', m_src.len - pos);
+            pos = nl ? static_cast<size_t>(static_cast<const char*>(nl) - m_src.str) : m_src.len;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+/** skip a quoted scalar, returning the position after its closing quote */
+size_t SeqReader::_skip_flow_scalar(size_t pos) const
+{
+    const char q = m_src.str[pos];
+    for(size_t i = pos + 1; i < m_src.len; ++i)
+    {
+        const char c = m_src.str[i];
+        if(q == '"' && c == '\\')
+        {
+            ++i; // the escaped character cannot close the scalar
+        }
+        else if(c == q)
+        {
+            if(q == '\'' && i + 1 < m_src.len && m_src.str[i + 1] == '\'')
+                ++i; // an escaped single quote
+            else
+                return i + 1;
+        }
+    }
+    _err(pos, "ERROR parsing yml: unterminated quoted scalar");
+    return m_src.len;
+}
+
+void SeqReader::_err(size_t pos, const char *msg) const
+{
+    csubstr before = m_src.first(pos);
+    const size_t nl = before.last_of('\n');
+    const size_t line = 1 + before.count('\n');
+    const size_t col = 1 + pos - (nl != npos ? nl + 1 : 0);
+    c4::yml::error(msg, strlen(msg), Location(m_file, pos, line, col));
+}
+
+} // namespace yml
+} // namespace c4
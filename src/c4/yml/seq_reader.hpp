@@ -0,0 +1,126 @@
+#ifndef _C4_YML_SEQ_READER_HPP_
+#define _C4_YML_SEQ_READER_HPP_
+
+/** @file seq_reader.hpp Reading a top-level sequence one element at a
+ * time, with memory bounded by the largest element. */
+
+#ifndef _C4_YML_PARSE_HPP_
+#include "c4/yml/parse.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+/** Parses the elements of a top-level sequence one at a time, each
+ * into the same tree, which is cleared (keeping its capacity) before
+ * the next element is parsed. So the memory needed is bounded by the
+ * largest element rather than by the whole document, which is what
+ * matters for eg logs or exports made of millions of records.
+ *
+ * The sequence can be a block sequence (each element starting with "- "
+ * at the sequence's indentation) or a flow sequence (including JSON
+ * arrays). It may be preceded by comments, directives and a "---"
+ * document start; anything after the sequence other than comments or
+ * a document marker ("---" or "...") is an error.
+ *
+ * Usage:
+ * @code
+ * SeqReader reader("records.yml", src);
+ * while(reader.next())
+ *     process(reader.elem()); // valid until the next call to next()
+ * // or, equivalently
+ * for(NodeRef elem : SeqReader("records.yml", src))
+ *     process(elem);
+ * @endcode
+ *
+ * Each element is parsed separately, so aliases cannot refer to
+ * anchors in other elements (they are kept as references, but
+ * Tree::resolve() will not find those anchors). Errors found while
+ * parsing an element are located relative to the start of elem_src().
+ *
+ * @note the source buffer is not modified: each element is copied to
+ * the tree's arena before being parsed. */
+class RYML_EXPORT SeqReader
+{
+public:
+
+    SeqReader(Allocator const& a={});
+    SeqReader(csubstr src, Allocator const& a={}) : SeqReader(a) { reset({}, src); }
+    SeqReader(csubstr filename, csubstr src, Allocator const& a={}) : SeqReader(a) { reset(filename, src); }
+
+    /** start reading a new source */
+    void reset(csubstr filename, csubstr src);
+
+    /** parse the next element. Returns false when there are no more
+     * elements. */
+    bool next();
+
+    /** the tree with the current element, whose root is a sequence with
+     * the element as its only child */
+    Tree      & tree()       { return m_tree; }
+    Tree const& tree() const { return m_tree; }
+
+    /** the current element */
+    NodeRef elem() { RYML_ASSERT(m_index != NONE); return m_tree[0]; }
+
+    /** the position of the current element in the sequence */
+    size_t index() const { return m_index; }
+
+    /** the source of the current element */
+    csubstr elem_src() const { return m_elem_src; }
+
+public:
+
+    /** an input iterator going through the elements, for use with
+     * range-for loops */
+    struct iterator
+    {
+        SeqReader *m_reader;
+
+        NodeRef operator*  () const { return m_reader->elem(); }
+        iterator& operator++ () { if( ! m_reader->next()) m_reader = nullptr; return *this; }
+        bool operator== (iterator const& that) const { return m_reader == that.m_reader; }
+        bool operator!= (iterator const& that) const { return m_reader != that.m_reader; }
+    };
+
+    iterator begin() { return iterator{next() ? this : nullptr}; }
+    iterator end() { return iterator{nullptr}; }
+
+private:
+
+    typedef enum {
+        kStart,  ///< the start of the sequence was not read yet
+        kBlock,  ///< reading a block sequence
+        kFlow,   ///< reading a flow sequence
+        kEnd,    ///< the sequence is finished
+    } Mode_e;
+
+    void   _read_start();
+    bool   _next_block(csubstr *elem);
+    bool   _next_flow(csubstr *elem);
+    void   _check_end(size_t pos);
+    size_t _skip_flow_ws(size_t pos) const;
+    size_t _skip_flow_scalar(size_t pos) const;
+
+    void _err(size_t pos, const char *msg) const;
+
+private:
+
+    Parser  m_parser;
+    Tree    m_tree;
+
+    csubstr m_file;
+    csubstr m_src;
+    size_t  m_pos;          ///< the offset where the next element is looked for
+    size_t  m_indentation;  ///< the indentation of a block sequence
+    Mode_e  m_mode;
+
+    size_t  m_index;
+    csubstr m_elem_src;
+
+};
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_SEQ_READER_HPP_ */
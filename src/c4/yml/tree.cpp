@@ -2,6 +2,7 @@
 #include "c4/yml/detail/parser_dbg.hpp"
 #include "c4/yml/node.hpp"
 #include "c4/yml/detail/stack.hpp"
+#include "c4/yml/detail/filter.hpp"
 
 
 C4_SUPPRESS_WARNING_GCC_WITH_PUSH("-Wtype-limits")
@@ -229,15 +230,34 @@ NodeRef const Tree::operator[] (size_t i) const
 
 
 //-----------------------------------------------------------------------------
+namespace {
+/** the size of the node allocation: the NodeData array is followed
+ * by the parallel arrays of keys and vals */
+C4_ALWAYS_INLINE size_t _nodes_bytes(size_t cap) noexcept
+{
+    return cap * (sizeof(NodeData) + 2 * sizeof(csubstr));
+}
+} // namespace
+
 Tree::Tree(Allocator const& cb)
 :
     m_buf(nullptr),
+    m_keys(nullptr),
+    m_vals(nullptr),
     m_cap(0),
     m_size(0),
+    m_peak_size(0),
     m_free_head(NONE),
     m_free_tail(NONE),
     m_arena(),
     m_arena_pos(0),
+    m_props(nullptr),
+    m_props_size(0),
+    m_props_cap(0),
+    m_map_index(nullptr),
+    m_map_index_size(0),
+    m_map_index_cap(0),
+    m_map_index_enabled(false),
     m_alloc(cb)
 {
 }
@@ -283,13 +303,23 @@ void Tree::_free()
     if(m_buf)
     {
         RYML_ASSERT(m_cap > 0);
-        m_alloc.free(m_buf, m_cap * sizeof(NodeData));
+        m_alloc.free(m_buf, _nodes_bytes(m_cap));
     }
     if(m_arena.str)
     {
         RYML_ASSERT(m_arena.len > 0);
         m_alloc.free(m_arena.str, m_arena.len);
     }
+    if(m_props)
+    {
+        RYML_ASSERT(m_props_cap > 0);
+        m_alloc.free(m_props, m_props_cap * sizeof(NodeProperties));
+    }
+    if(m_map_index)
+    {
+        _map_index_free();
+        m_alloc.free(m_map_index, m_map_index_cap * sizeof(MapIndex));
+    }
     _clear();
 }
 
@@ -302,12 +332,22 @@ C4_SUPPRESS_WARNING_GCC_PUSH
 void Tree::_clear()
 {
     m_buf = nullptr;
+    m_keys = nullptr;
+    m_vals = nullptr;
     m_cap = 0;
     m_size = 0;
+    m_peak_size = 0;
     m_free_head = 0;
     m_free_tail = 0;
     m_arena = {};
     m_arena_pos = 0;
+    m_props = nullptr;
+    m_props_size = 0;
+    m_props_cap = 0;
+    m_map_index = nullptr;
+    m_map_index_size = 0;
+    m_map_index_cap = 0;
+    m_map_index_enabled = false;
 }
 
 void Tree::_copy(Tree const& that)
@@ -315,12 +355,31 @@ void Tree::_copy(Tree const& that)
     RYML_ASSERT(m_buf == nullptr);
     RYML_ASSERT(m_arena.str == nullptr);
     RYML_ASSERT(m_arena.len == 0);
-    m_buf = (NodeData*) m_alloc.allocate(that.m_cap * sizeof(NodeData), that.m_buf);
-    memcpy(m_buf, that.m_buf, that.m_cap * sizeof(NodeData));
+    // raw vals outside of the arena would be shared by both trees
+    for(size_t i = 0; i < that.m_cap; ++i)
+        if(that.m_buf[i].m_type.is_val_raw() && ! that.in_arena(that.m_vals[i]))
+            that._filter_if_raw(i);
+    if(that.m_buf)
+    {
+        m_buf = (NodeData*) m_alloc.allocate(_nodes_bytes(that.m_cap), that.m_buf);
+        memcpy(m_buf, that.m_buf, _nodes_bytes(that.m_cap));
+        m_keys = (csubstr*)(m_buf + that.m_cap);
+        m_vals = m_keys + that.m_cap;
+    }
     m_cap = that.m_cap;
     m_size = that.m_size;
+    m_peak_size = that.m_peak_size;
     m_free_head = that.m_free_head;
     m_free_tail = that.m_free_tail;
+    if(that.m_props_size)
+    {
+        m_props = (NodeProperties*) m_alloc.allocate(that.m_props_size * sizeof(NodeProperties), that.m_props);
+        memcpy(m_props, that.m_props, that.m_props_size * sizeof(NodeProperties));
+        m_props_size = that.m_props_size;
+        m_props_cap = that.m_props_size;
+    }
+    // the map indices are not copied, but built again as needed
+    m_map_index_enabled = that.m_map_index_enabled;
     m_arena_pos = that.m_arena_pos;
     m_arena = that.m_arena;
     if(that.m_arena.str)
@@ -340,35 +399,447 @@ void Tree::_move(Tree & that)
     RYML_ASSERT(m_arena.str == nullptr);
     RYML_ASSERT(m_arena.len == 0);
     m_buf = that.m_buf;
+    m_keys = that.m_keys;
+    m_vals = that.m_vals;
     m_cap = that.m_cap;
     m_size = that.m_size;
+    m_peak_size = that.m_peak_size;
     m_free_head = that.m_free_head;
     m_free_tail = that.m_free_tail;
     m_arena = that.m_arena;
     m_arena_pos = that.m_arena_pos;
+    m_props = that.m_props;
+    m_props_size = that.m_props_size;
+    m_props_cap = that.m_props_cap;
+    m_map_index = that.m_map_index;
+    m_map_index_size = that.m_map_index_size;
+    m_map_index_cap = that.m_map_index_cap;
+    m_map_index_enabled = that.m_map_index_enabled;
     that._clear();
 }
 
+namespace {
+/** move s to the same position in the next arena, if it is in the
+ * used part of the previous arena. Strings outside of the arena (eg
+ * in a source buffer parsed in situ) are left untouched. */
+C4_ALWAYS_INLINE void _relocate_str(csubstr *C4_RESTRICT s, uintptr_t prev, size_t used, char *next) noexcept
+{
+    // strings before the arena (or null) wrap around to a large
+    // position. Only an empty string can start at the end of the used
+    // range: a non-empty one starting there belongs to another buffer
+    const size_t pos = (size_t)((uintptr_t)s->str - prev);
+    if(pos < used || (pos == used && s->len == 0))
+        s->str = next + pos;
+}
+} // namespace
+
 void Tree::_relocate(substr next_arena)
 {
     RYML_ASSERT(next_arena.not_empty());
     RYML_ASSERT(next_arena.len >= m_arena.len);
     memcpy(next_arena.str, m_arena.str, m_arena_pos);
-    for(NodeData *C4_RESTRICT n = m_buf, *e = m_buf + m_cap; n != e; ++n)
+    // all the strings in the arena move by the same amount, so each
+    // of them only needs its position checked against the used range
+    const uintptr_t prev = (uintptr_t)m_arena.str;
+    const size_t used = m_arena_pos;
+    char *next = next_arena.str;
+    for(csubstr *C4_RESTRICT s = m_keys, *e = m_keys + m_cap; s != e; ++s)
+        _relocate_str(s, prev, used, next);
+    for(csubstr *C4_RESTRICT s = m_vals, *e = m_vals + m_cap; s != e; ++s)
+        _relocate_str(s, prev, used, next);
+    for(NodeProperties *C4_RESTRICT p = m_props, *e = m_props + m_props_size; p != e; ++p)
+    {
+        _relocate_str(&p->m_key_tag   , prev, used, next);
+        _relocate_str(&p->m_key_anchor, prev, used, next);
+        _relocate_str(&p->m_val_tag   , prev, used, next);
+        _relocate_str(&p->m_val_anchor, prev, used, next);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+NodeScalar Tree::keysc(size_t node) const
+{
+    RYML_ASSERT(has_key(node));
+    NodeData const* C4_RESTRICT n = _p(node);
+    NodeScalar sc(m_keys[node]);
+    if(n->m_type & _KEYPROPS)
     {
-        if(in_arena(n->m_key.scalar))
-            n->m_key.scalar = _relocated(n->m_key.scalar, next_arena);
-        if(in_arena(n->m_key.tag   ))
-            n->m_key.tag    = _relocated(n->m_key.tag   , next_arena);
-        if(in_arena(n->m_key.anchor))
-            n->m_key.anchor = _relocated(n->m_key.anchor, next_arena);
-        if(in_arena(n->m_val.scalar))
-            n->m_val.scalar = _relocated(n->m_val.scalar, next_arena);
-        if(in_arena(n->m_val.tag   ))
-            n->m_val.tag    = _relocated(n->m_val.tag   , next_arena);
-        if(in_arena(n->m_val.anchor))
-            n->m_val.anchor = _relocated(n->m_val.anchor, next_arena);
+        NodeProperties const* C4_RESTRICT p = _props(node);
+        if(n->m_type & KEYTAG)
+            sc.tag = p->m_key_tag;
+        if(n->m_type & (KEYANCH|KEYREF))
+            sc.anchor = p->m_key_anchor;
     }
+    return sc;
+}
+
+NodeScalar Tree::valsc(size_t node) const
+{
+    RYML_ASSERT(has_val(node));
+    _filter_if_raw(node);
+    NodeData const* C4_RESTRICT n = _p(node);
+    NodeScalar sc(m_vals[node]);
+    if(n->m_type & _VALPROPS)
+    {
+        NodeProperties const* C4_RESTRICT p = _props(node);
+        if(n->m_type & VALTAG)
+            sc.tag = p->m_val_tag;
+        if(n->m_type & (VALANCH|VALREF))
+            sc.anchor = p->m_val_anchor;
+    }
+    return sc;
+}
+
+bool Tree::empty(size_t node) const
+{
+    _filter_if_raw(node);
+    NodeData const* C4_RESTRICT n = _p(node);
+    if(has_children(node) || ! m_keys[node].empty())
+        return false;
+    // the key's tag and anchor make it non-empty. So do the val's,
+    // but only if there is a val.
+    if(n->m_type & _KEYPROPS)
+    {
+        NodeProperties const* C4_RESTRICT p = _props(node);
+        if(((n->m_type & KEYTAG) && ! p->m_key_tag.empty()) || ((n->m_type & (KEYANCH|KEYREF)) && ! p->m_key_anchor.empty()))
+            return false;
+    }
+    if( ! (n->m_type & VAL))
+        return true;
+    if( ! m_vals[node].empty())
+        return false;
+    if(n->m_type & _VALPROPS)
+    {
+        NodeProperties const* C4_RESTRICT p = _props(node);
+        if(((n->m_type & VALTAG) && ! p->m_val_tag.empty()) || ((n->m_type & (VALANCH|VALREF)) && ! p->m_val_anchor.empty()))
+            return false;
+    }
+    return true;
+}
+
+bool Tree::has_anchor(size_t node, csubstr a) const
+{
+    NodeType ty = _p(node)->m_type;
+    if( ! (ty & (KEYANCH|VALANCH|KEYREF|VALREF)))
+        return a.empty();
+    NodeProperties const* C4_RESTRICT p = _props(node);
+    return (ty & (KEYANCH|KEYREF) ? p->m_key_anchor : csubstr{}) == a
+        || (ty & (VALANCH|VALREF) ? p->m_val_anchor : csubstr{}) == a;
+}
+
+
+//-----------------------------------------------------------------------------
+size_t Tree::_props_pos(size_t node) const
+{
+    // the entries are mostly added in increasing order of node id,
+    // so look first at the last one
+    size_t lo = 0, hi = m_props_size;
+    if(hi == 0 || m_props[hi-1].m_node < node)
+        return hi;
+    if(m_props[hi-1].m_node == node)
+        return hi-1;
+    --hi;
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(m_props[mid].m_node < node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+NodeProperties* Tree::_props_add(size_t node)
+{
+    RYML_ASSERT(node < m_cap);
+    size_t pos = _props_pos(node);
+    if(pos < m_props_size && m_props[pos].m_node == node)
+        return m_props + pos;
+    if(m_props_size == m_props_cap)
+    {
+        size_t cap = m_props_cap ? 2 * m_props_cap : 16;
+        NodeProperties *buf = (NodeProperties*) m_alloc.allocate(cap * sizeof(NodeProperties), m_props);
+        if(m_props)
+        {
+            memcpy(buf, m_props, m_props_size * sizeof(NodeProperties));
+            m_alloc.free(m_props, m_props_cap * sizeof(NodeProperties));
+        }
+        m_props = buf;
+        m_props_cap = cap;
+    }
+    if(pos < m_props_size)
+        memmove(m_props + pos + 1, m_props + pos, (m_props_size - pos) * sizeof(NodeProperties));
+    ++m_props_size;
+    NodeProperties *C4_RESTRICT p = m_props + pos;
+    *p = {};
+    p->m_node = (id_type)node;
+    return p;
+}
+
+void Tree::_props_rem(size_t node)
+{
+    size_t pos = _props_pos(node);
+    if(pos == m_props_size || m_props[pos].m_node != node)
+        return;
+    --m_props_size;
+    memmove(m_props + pos, m_props + pos + 1, (m_props_size - pos) * sizeof(NodeProperties));
+}
+
+void Tree::_rem_props(size_t node, type_bits props)
+{
+    RYML_ASSERT((props & ~_PROPS) == 0);
+    NodeType ty = _p(node)->m_type;
+    if(ty & props)
+    {
+        NodeProperties *C4_RESTRICT p = _props(node);
+        if(props & KEYTAG)
+            p->m_key_tag.clear();
+        if((props & (KEYANCH|KEYREF)) && ! (ty & (KEYANCH|KEYREF) & ~props))
+            p->m_key_anchor.clear();
+        if(props & VALTAG)
+            p->m_val_tag.clear();
+        if((props & (VALANCH|VALREF)) && ! (ty & (VALANCH|VALREF) & ~props))
+            p->m_val_anchor.clear();
+        if( ! (ty & _PROPS & ~props))
+            _props_rem(node);
+    }
+    _rem_flags(node, props);
+}
+
+void Tree::_copy_props(size_t dst_, Tree const* that_tree, size_t src_)
+{
+    that_tree->_filter_if_raw(src_); // the copies cannot share a raw val
+    auto      & C4_RESTRICT dst = *_p(dst_);
+    auto const& C4_RESTRICT src = *that_tree->_p(src_);
+    if(dst.m_type & _PROPS)
+        _props_rem(dst_);
+    dst.m_type = src.m_type;
+    _key(dst_) = that_tree->_key(src_);
+    _val(dst_) = that_tree->_val(src_);
+    _key_changed(dst_);
+    if(src.m_type & _PROPS)
+    {
+        // copy first: adding may reallocate the source table
+        NodeProperties sp = *that_tree->_props(src_);
+        sp.m_node = (id_type)dst_;
+        *_props_add(dst_) = sp;
+    }
+}
+
+void Tree::_copy_props_wo_key(size_t dst_, Tree const* that_tree, size_t src_)
+{
+    that_tree->_filter_if_raw(src_); // the copies cannot share a raw val
+    auto      & C4_RESTRICT dst = *_p(dst_);
+    auto const& C4_RESTRICT src = *that_tree->_p(src_);
+    // the key's properties stay, the val's come from the source
+    NodeProperties dp = {};
+    if(dst.m_type & _PROPS)
+    {
+        dp = *_props(dst_);
+        _props_rem(dst_);
+    }
+    if(src.m_type & _PROPS)
+    {
+        NodeProperties const* C4_RESTRICT sp = that_tree->_props(src_);
+        dp.m_val_tag = sp->m_val_tag;
+        dp.m_val_anchor = sp->m_val_anchor;
+    }
+    else
+    {
+        dp.m_val_tag.clear();
+        dp.m_val_anchor.clear();
+    }
+    dst.m_type = src.m_type;
+    _val(dst_) = that_tree->_val(src_);
+    if(dst.m_type & _PROPS)
+    {
+        dp.m_node = (id_type)dst_;
+        *_props_add(dst_) = dp;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+namespace {
+/** FNV-1a, folded to size_t */
+C4_ALWAYS_INLINE size_t _hash_key(csubstr key) noexcept
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    for(char c : key)
+    {
+        h ^= (uint8_t)c;
+        h *= UINT64_C(1099511628211);
+    }
+    return (size_t)(h ^ (h >> 32));
+}
+} // namespace
+
+size_t Tree::_map_index_pos(size_t node) const
+{
+    size_t lo = 0, hi = m_map_index_size;
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(m_map_index[mid].m_node < node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+MapIndex* Tree::_map_index_add(size_t node)
+{
+    RYML_ASSERT(is_map(node));
+    size_t pos = _map_index_pos(node);
+    RYML_ASSERT(pos == m_map_index_size || m_map_index[pos].m_node != node);
+    if(m_map_index_size == m_map_index_cap)
+    {
+        size_t cap = m_map_index_cap ? 2 * m_map_index_cap : 8;
+        MapIndex *buf = (MapIndex*) m_alloc.allocate(cap * sizeof(MapIndex), m_map_index);
+        if(m_map_index)
+        {
+            memcpy(buf, m_map_index, m_map_index_size * sizeof(MapIndex));
+            m_alloc.free(m_map_index, m_map_index_cap * sizeof(MapIndex));
+        }
+        m_map_index = buf;
+        m_map_index_cap = cap;
+    }
+    if(pos < m_map_index_size)
+        memmove(m_map_index + pos + 1, m_map_index + pos, (m_map_index_size - pos) * sizeof(MapIndex));
+    ++m_map_index_size;
+    MapIndex *C4_RESTRICT idx = m_map_index + pos;
+    *idx = {};
+    idx->m_node = (id_type)node;
+    _map_index_build(idx);
+    return idx;
+}
+
+void Tree::_map_index_rem(size_t node)
+{
+    size_t pos = _map_index_pos(node);
+    if(pos == m_map_index_size || m_map_index[pos].m_node != node)
+        return;
+    MapIndex *C4_RESTRICT idx = m_map_index + pos;
+    m_alloc.free(idx->m_slots, idx->m_cap * sizeof(id_type));
+    --m_map_index_size;
+    memmove(idx, idx + 1, (m_map_index_size - pos) * sizeof(MapIndex));
+}
+
+void Tree::_map_index_free()
+{
+    for(MapIndex *C4_RESTRICT idx = m_map_index, *e = m_map_index + m_map_index_size; idx != e; ++idx)
+        m_alloc.free(idx->m_slots, idx->m_cap * sizeof(id_type));
+    m_map_index_size = 0;
+}
+
+void Tree::_map_index_build(MapIndex *idx)
+{
+    // keep the table at most half full, with room for as many
+    // children again before it has to be rebuilt
+    size_t num = num_children(idx->m_node);
+    size_t cap = 16;
+    while(cap < 4 * num)
+        cap *= 2;
+    if(cap != idx->m_cap)
+    {
+        id_type *slots = (id_type*) m_alloc.allocate(cap * sizeof(id_type), idx->m_slots);
+        if(idx->m_slots)
+            m_alloc.free(idx->m_slots, idx->m_cap * sizeof(id_type));
+        idx->m_slots = slots;
+        idx->m_cap = cap;
+    }
+    memset(idx->m_slots, 0xff, cap * sizeof(id_type)); // NONE
+    idx->m_used = 0;
+    idx->m_last = (id_type)NONE;
+    for(size_t ch = first_child(idx->m_node); ch != NONE; ch = next_sibling(ch))
+        _map_index_insert(idx, ch);
+}
+
+void Tree::_map_index_insert(MapIndex *idx, size_t child)
+{
+    RYML_ASSERT(2 * (idx->m_used + 1) <= idx->m_cap);
+    const size_t mask = idx->m_cap - 1;
+    size_t i = _hash_key(_key(child)) & mask;
+    while(idx->m_slots[i] != (id_type)NONE)
+        i = (i + 1) & mask;
+    idx->m_slots[i] = (id_type)child;
+    ++idx->m_used;
+    idx->m_last = (id_type)child;
+}
+
+size_t Tree::_map_index_find(MapIndex *idx, csubstr name)
+{
+    // children with equal keys are in the table in their order, so
+    // the first of them is found, as with a linear search
+    const size_t mask = idx->m_cap - 1;
+    for(size_t i = _hash_key(name) & mask; idx->m_slots[i] != (id_type)NONE; i = (i + 1) & mask)
+    {
+        size_t ch = idx->m_slots[i];
+        if(ch != idx->m_node && _key(ch) == name)
+            return ch;
+    }
+    // not in the table: add the children appended since it was
+    // last updated, looking for the name among them
+    size_t found = NONE;
+    for(size_t ch = idx->m_last != NONE ? next_sibling(idx->m_last) : first_child(idx->m_node); ch != NONE; ch = next_sibling(ch))
+    {
+        if(2 * (idx->m_used + 1) > idx->m_cap)
+        {
+            _map_index_build(idx); // with every child, and more room
+            return found != NONE ? found : _map_index_find(idx, name);
+        }
+        _map_index_insert(idx, ch);
+        if(found == NONE && _key(ch) == name)
+            found = ch;
+    }
+    return found;
+}
+
+void Tree::_map_index_rem_child(size_t node)
+{
+    size_t parent = _p(node)->m_parent;
+    MapIndex *C4_RESTRICT idx = _map_index(parent);
+    if( ! idx)
+        return;
+    if(first_child(parent) == last_child(parent))
+    {
+        _map_index_rem(parent); // the map is now empty
+        return;
+    }
+    // the key did not change since the child was added, or the
+    // index would have been dropped
+    const size_t mask = idx->m_cap - 1;
+    for(size_t i = _hash_key(_key(node)) & mask; idx->m_slots[i] != (id_type)NONE; i = (i + 1) & mask)
+    {
+        if(idx->m_slots[i] == node)
+        {
+            idx->m_slots[i] = idx->m_node;
+            break;
+        }
+    }
+    if(idx->m_last == node)
+        idx->m_last = _p(node)->m_prev_sibling;
+}
+
+void Tree::_map_index_key_changed(size_t node)
+{
+    size_t parent = _p(node)->m_parent;
+    if(parent == NONE)
+        return;
+    MapIndex *C4_RESTRICT idx = _map_index(parent);
+    if( ! idx)
+        return;
+    // the children after m_last are not in the table yet, so their
+    // keys can change. Most often it is the last child.
+    if(node == last_child(parent) && node != idx->m_last)
+        return;
+    for(size_t ch = idx->m_last != NONE ? next_sibling(idx->m_last) : first_child(parent); ch != NONE; ch = next_sibling(ch))
+        if(ch == node)
+            return;
+    _map_index_rem(parent);
 }
 
 
@@ -377,15 +848,22 @@ void Tree::reserve(size_t cap)
 {
     if(cap > m_cap)
     {
-        NodeData *buf = (NodeData*) m_alloc.allocate(cap * sizeof(NodeData), m_buf);
+        RYML_CHECK(cap <= NONE); // the ids must fit in id_type
+        NodeData *buf = (NodeData*) m_alloc.allocate(_nodes_bytes(cap), m_buf);
+        csubstr *keys = (csubstr*)(buf + cap);
+        csubstr *vals = keys + cap;
         if(m_buf)
         {
             memcpy(buf, m_buf, m_cap * sizeof(NodeData));
-            m_alloc.free(m_buf, m_cap * sizeof(NodeData));
+            memcpy(keys, m_keys, m_cap * sizeof(csubstr));
+            memcpy(vals, m_vals, m_cap * sizeof(csubstr));
+            m_alloc.free(m_buf, _nodes_bytes(m_cap));
         }
         size_t first = m_cap, del = cap - m_cap;
         m_cap = cap;
         m_buf = buf;
+        m_keys = keys;
+        m_vals = vals;
         _clear_range(first, del);
 
         if(m_free_head != NONE)
@@ -414,8 +892,11 @@ void Tree::reserve(size_t cap)
 //-----------------------------------------------------------------------------
 void Tree::clear()
 {
+    m_props_size = 0;
+    _map_index_free();
     _clear_range(0, m_cap);
     m_size = 0;
+    m_peak_size = 0;
     if(m_buf)
     {
         RYML_ASSERT(m_cap >= 0);
@@ -444,6 +925,8 @@ void Tree::_clear_range(size_t first, size_t num)
     if(num == 0) return; // prevent overflow when subtracting
     RYML_ASSERT(first >= 0 && first + num <= m_cap);
     memset(m_buf + first, 0, num * sizeof(NodeData));
+    memset(m_keys + first, 0, num * sizeof(csubstr));
+    memset(m_vals + first, 0, num * sizeof(csubstr));
     for(size_t i = first, e = first + num; i < e; ++i)
     {
         _clear(i);
@@ -466,6 +949,9 @@ void Tree::_release(size_t i)
     _free_list_add(i);
     _clear(i);
 
+    // the peak is updated only here, to spare _claim()
+    if(m_size > m_peak_size)
+        m_peak_size = m_size;
     --m_size;
 }
 
@@ -500,6 +986,7 @@ size_t Tree::_claim()
     {
         size_t sz = 2 * m_cap;
         sz = sz ? sz : 16;
+        sz = sz <= NONE && sz > m_cap ? sz : (size_t)NONE;
         reserve(sz);
         RYML_ASSERT(m_free_head != NONE);
     }
@@ -537,6 +1024,10 @@ void Tree::_set_hierarchy(size_t ichild, size_t iparent, size_t iprev_sibling)
     RYML_ASSERT(iparent == NONE || (iparent >= 0 && iparent < m_cap));
     RYML_ASSERT(iprev_sibling == NONE || (iprev_sibling >= 0 && iprev_sibling < m_cap));
 
+    // an index can take children appended at the end of the map
+    if(C4_UNLIKELY(m_map_index_size) && iparent != NONE && iprev_sibling != _p(iparent)->m_last_child)
+        _map_index_rem(iparent);
+
     NodeData *C4_RESTRICT child = get(ichild);
 
     child->m_parent = iparent;
@@ -603,6 +1094,8 @@ void Tree::_rem_hierarchy(size_t i)
     // remove from the parent
     if(w.m_parent != NONE)
     {
+        if(C4_UNLIKELY(m_map_index_size))
+            _map_index_rem_child(i);
         NodeData &C4_RESTRICT p = m_buf[w.m_parent];
         if(p.m_first_child == i)
         {
@@ -630,6 +1123,7 @@ void Tree::_rem_hierarchy(size_t i)
 //-----------------------------------------------------------------------------
 void Tree::reorder()
 {
+    _map_index_free(); // the children change ids
     size_t r = root_id();
     _do_reorder(&r, 0);
 }
@@ -871,9 +1365,30 @@ void Tree::_swap_props(size_t n_, size_t m_)
 {
     NodeData &C4_RESTRICT n = *_p(n_);
     NodeData &C4_RESTRICT m = *_p(m_);
+    NodeProperties pn = {}, pm = {};
+    if(n.m_type & _PROPS)
+    {
+        pn = *_props(n_);
+        _props_rem(n_);
+    }
+    if(m.m_type & _PROPS)
+    {
+        pm = *_props(m_);
+        _props_rem(m_);
+    }
     std::swap(n.m_type, m.m_type);
-    std::swap(n.m_key, m.m_key);
-    std::swap(n.m_val, m.m_val);
+    std::swap(m_keys[n_], m_keys[m_]);
+    std::swap(m_vals[n_], m_vals[m_]);
+    if(n.m_type & _PROPS)
+    {
+        pm.m_node = (id_type)n_;
+        *_props_add(n_) = pm;
+    }
+    if(m.m_type & _PROPS)
+    {
+        pn.m_node = (id_type)m_;
+        *_props_add(m_) = pn;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -925,6 +1440,7 @@ void Tree::set_root_as_stream()
             _p(next_doc)->m_type.add(DOC);
             _p(next_doc)->m_type.rem(SEQ);
         }
+        _props_rem(root);
         _p(root)->m_type = STREAM;
         return;
     }
@@ -941,6 +1457,7 @@ void Tree::set_root_as_stream()
         ch = next;
         next = next_sibling(next);
     }
+    _props_rem(root);
     _p(root)->m_type = STREAM;
 }
 
@@ -1371,13 +1888,15 @@ void Tree::resolve()
                 {
                     RYML_CHECK(!is_container(rd.target));
                     RYML_CHECK(has_val(rd.target));
-                    _p(rd.node)->m_key.scalar = val(rd.target);
+                    _key(rd.node) = val(rd.target);
+                    _key_changed(rd.node);
                     _add_flags(rd.node, KEY);
                 }
                 else
                 {
                     RYML_CHECK(key_anchor(rd.target) == key_ref(rd.node));
-                    _p(rd.node)->m_key.scalar = key(rd.target);
+                    _key(rd.node) = key(rd.target);
+                    _key_changed(rd.node);
                     _add_flags(rd.node, VAL);
                 }
             }
@@ -1388,7 +1907,7 @@ void Tree::resolve()
                 {
                     RYML_CHECK(!is_container(rd.target));
                     RYML_CHECK(has_val(rd.target));
-                    _p(rd.node)->m_val.scalar = key(rd.target);
+                    _val(rd.node) = key(rd.target);
                     _add_flags(rd.node, VAL);
                 }
                 else
@@ -1412,6 +1931,25 @@ void Tree::resolve()
 
 //-----------------------------------------------------------------------------
 
+void Tree::_filter_raw_val(size_t node)
+{
+    NodeData *C4_RESTRICT n = _p(node);
+    RYML_ASSERT(n->m_type.is_val_raw());
+    // the raw val is in the source buffer (or in the arena), which
+    // the parser was given as mutable
+    csubstr raw = m_vals[node];
+    m_vals[node] = detail::filter_raw_scalar(substr(const_cast<char*>(raw.str), raw.len));
+    n->m_type.rem(VALRAW);
+}
+
+void Tree::filter_raw()
+{
+    for(size_t i = 0; i < m_cap; ++i)
+        _filter_if_raw(i);
+}
+
+//-----------------------------------------------------------------------------
+
 size_t Tree::num_children(size_t node) const
 {
     size_t count = 0;
@@ -1469,14 +2007,26 @@ size_t Tree::find_child(size_t node, csubstr const& name) const
     {
         RYML_ASSERT(_p(node)->m_last_child != NONE);
     }
-    for(size_t i = first_child(node); i != NONE; i = next_sibling(i))
+    if(m_map_index_size)
+    {
+        // building the index is logically const, like filtering a raw val
+        MapIndex *idx = const_cast<Tree*>(this)->_map_index(node);
+        if(idx)
+            return const_cast<Tree*>(this)->_map_index_find(idx, name);
+    }
+    size_t found = NONE;
+    size_t count = 0;
+    for(size_t i = first_child(node); i != NONE; i = next_sibling(i), ++count)
     {
-        if(_p(i)->m_key.scalar == name)
+        if(_key(i) == name)
         {
-            return i;
+            found = i;
+            break;
         }
     }
-    return NONE;
+    if(count >= RYML_MAP_INDEX_MIN_CHILDREN && m_map_index_enabled)
+        const_cast<Tree*>(this)->_map_index_add(node);
+    return found;
 }
 
 #if defined(__clang__)
@@ -1492,70 +2042,86 @@ void Tree::to_val(size_t node, csubstr const& val, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
     RYML_ASSERT(parent(node) == NONE || ! parent_is_map(node));
+    _props_rem(node);
     _set_flags(node, VAL|more_flags);
-    _p(node)->m_key.clear();
-    _p(node)->m_val = val;
+    _key(node).clear();
+    _key_changed(node);
+    _val(node) = val;
 }
 
 void Tree::to_keyval(size_t node, csubstr const& key, csubstr const& val, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
     RYML_ASSERT(parent(node) == NONE || parent_is_map(node));
+    _props_rem(node);
     _set_flags(node, KEYVAL|more_flags);
-    _p(node)->m_key = key;
-    _p(node)->m_val = val;
+    _key(node) = key;
+    _key_changed(node);
+    _val(node) = val;
 }
 
 void Tree::to_map(size_t node, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
     RYML_ASSERT(parent(node) == NONE || ! parent_is_map(node)); // parent must not have children with keys
+    _props_rem(node);
     _set_flags(node, MAP|more_flags);
-    _p(node)->m_key.clear();
-    _p(node)->m_val.clear();
+    _key(node).clear();
+    _key_changed(node);
+    _val(node).clear();
 }
 
 void Tree::to_map(size_t node, csubstr const& key, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
     RYML_ASSERT(parent(node) == NONE || parent_is_map(node));
+    _props_rem(node);
     _set_flags(node, KEY|MAP|more_flags);
-    _p(node)->m_key = key;
-    _p(node)->m_val.clear();
+    _key(node) = key;
+    _key_changed(node);
+    _val(node).clear();
 }
 
 void Tree::to_seq(size_t node, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
     RYML_ASSERT(parent(node) == NONE || parent_is_seq(node));
+    _props_rem(node);
     _set_flags(node, SEQ|more_flags);
-    _p(node)->m_key.clear();
-    _p(node)->m_val.clear();
+    _key(node).clear();
+    _key_changed(node);
+    _val(node).clear();
 }
 
 void Tree::to_seq(size_t node, csubstr const& key, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
     RYML_ASSERT(parent(node) == NONE || parent_is_map(node));
+    _props_rem(node);
     _set_flags(node, KEY|SEQ|more_flags);
-    _p(node)->m_key = key;
-    _p(node)->m_val.clear();
+    _key(node) = key;
+    _key_changed(node);
+    _val(node).clear();
 }
 
 void Tree::to_doc(size_t node, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
+    _props_rem(node);
     _set_flags(node, DOC|more_flags);
-    _p(node)->m_key.clear();
-    _p(node)->m_val.clear();
+    _key(node).clear();
+    _key_changed(node);
+    _val(node).clear();
 }
 
 void Tree::to_stream(size_t node, type_bits more_flags)
 {
     RYML_ASSERT( ! has_children(node));
+    _props_rem(node);
     _set_flags(node, STREAM|more_flags);
-    _p(node)->m_key.clear();
-    _p(node)->m_val.clear();
+    _key(node).clear();
+    _key_changed(node);
+    _val(node).clear();
 }
 
 
@@ -1745,9 +2311,9 @@ size_t Tree::_next_node_modify(lookup_result * r, _lookup_path_token *parent)
         {
             RYML_ASSERT(is_map(r->closest));
             node = append_child(r->closest);
-            NodeData *n = _p(node);
-            n->m_key.scalar = token.value;
-            n->m_type.add(KEY);
+            _key(node) = token.value;
+            _key_changed(node);
+            _p(node)->m_type.add(KEY);
         }
     }
     else if(token.type == KEYVAL)
@@ -1765,10 +2331,10 @@ size_t Tree::_next_node_modify(lookup_result * r, _lookup_path_token *parent)
             _add_flags(r->closest, MAP);
             node = append_child(r->closest);
         }
-        NodeData *n = _p(node);
-        n->m_key.scalar = token.value;
-        n->m_val.scalar = "";
-        n->m_type.add(KEYVAL);
+        _key(node) = token.value;
+        _key_changed(node);
+        _val(node) = "";
+        _p(node)->m_type.add(KEYVAL);
     }
     else if(token.type == KEY)
     {
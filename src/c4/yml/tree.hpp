@@ -29,6 +29,8 @@ namespace yml {
 struct NodeScalar;
 struct NodeInit;
 struct NodeData;
+struct NodeProperties;
+struct MapIndex;
 class NodeRef;
 class Tree;
 
@@ -142,6 +144,7 @@ typedef enum : type_bits {
     VALTAG  = c4bit(11),    ///< the val has an explicit tag/type
     VALQUO  = c4bit(12),    ///< the val is quoted by '', "", > or |
     KEYQUO  = c4bit(13),    ///< the key is quoted by '', "", > or |
+    VALRAW  = c4bit(14),    ///< the val is raw source, to be filtered when first read. @see Parser::set_lazy_filtering()
     KEYVAL  = KEY|VAL,
     KEYSEQ  = KEY|SEQ,
     KEYMAP  = KEY|MAP,
@@ -268,6 +271,7 @@ public:
     bool is_key_quoted() const { return (type & (KEY|KEYQUO)) == (KEY|KEYQUO); }
     bool is_val_quoted() const { return (type & (VAL|VALQUO)) == (VAL|VALQUO); }
     bool is_quoted() const { return (type & (KEY|KEYQUO)) == (KEY|KEYQUO) || (type & (VAL|VALQUO)) == (VAL|VALQUO); }
+    bool is_val_raw() const { return (type & VALRAW) != 0; }
 
     #if defined(__clang__)
     #   pragma clang diagnostic pop
@@ -397,23 +401,57 @@ public:
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
-/** contains the data for each YAML node. */
+/** contains the type and the hierarchy links of each YAML node. This
+ * is what traversals touch, so it is kept small: the key and val
+ * scalars are in the tree's parallel m_keys and m_vals arrays, and the
+ * tags and anchors are in its NodeProperties table. */
 struct NodeData
 {
     NodeType   m_type;
 
-    NodeScalar m_key;
-    NodeScalar m_val;
-
-    size_t     m_parent;
-    size_t     m_first_child;
-    size_t     m_last_child;
-    size_t     m_next_sibling;
-    size_t     m_prev_sibling;
+    id_type    m_parent;
+    id_type    m_first_child;
+    id_type    m_last_child;
+    id_type    m_next_sibling;
+    id_type    m_prev_sibling;
 };
 C4_MUST_BE_TRIVIAL_COPY(NodeData);
 
 
+/** the tags and anchors of a node. Few nodes have any, so instead of
+ * taking space in every NodeData they are kept in a table sorted by
+ * node id, which has entries only for the nodes flagged with any of
+ * KEYTAG, VALTAG, KEYANCH, VALANCH, KEYREF or VALREF. A member whose
+ * flag is not set is meaningless. */
+struct NodeProperties
+{
+    id_type m_node;
+
+    csubstr m_key_tag;
+    csubstr m_key_anchor; ///< the key's anchor, or the anchor it references
+    csubstr m_val_tag;
+    csubstr m_val_anchor; ///< the val's anchor, or the anchor it references
+};
+C4_MUST_BE_TRIVIAL_COPY(NodeProperties);
+
+
+/** a hash table with the children of a map, by key. It is built by
+ * find_child() for maps with many children, when the tree's map
+ * index is enabled. The slots have child ids, probed linearly from
+ * the hash of the key: NONE marks an empty slot, and the id of the map
+ * (which is never one of its children) a removed child.
+ * @see Tree::set_map_index() */
+struct MapIndex
+{
+    id_type   m_node;  ///< the map
+    id_type   m_last;  ///< the last child in the table. The children after it were appended later, and go in the table when a lookup misses
+    id_type * m_slots;
+    size_t    m_cap;   ///< the number of slots, a power of two
+    size_t    m_used;  ///< the slots which are not empty, including the removed children
+};
+C4_MUST_BE_TRIVIAL_COPY(MapIndex);
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -455,9 +493,26 @@ public:
     inline bool   empty() const { return m_size == 0; }
 
     inline size_t size () const { return m_size; }
+    /** the largest size() since the tree was last cleared: as removed
+     * nodes are recycled, this is the capacity needed to build the
+     * tree without reallocating */
+    inline size_t peak_size() const { return m_size > m_peak_size ? m_size : m_peak_size; }
     inline size_t capacity() const { return m_cap; }
     inline size_t slack() const { RYML_ASSERT(m_cap >= m_size); return m_cap - m_size; }
 
+    /** enable or disable the hash index of the children of large
+     * maps. When enabled, find_child() builds the index of a map
+     * once it has walked past RYML_MAP_INDEX_MIN_CHILDREN of its
+     * children, so that later lookups in that map are O(1). The index
+     * is kept up to date as children are appended or removed, and is
+     * dropped when they are inserted elsewhere, moved or have their
+     * key changed, to be rebuilt by the next lookup.
+     * @warning like the lazy filtering of raw vals, building the index
+     * modifies a const tree: concurrent lookups in the same tree
+     * need synchronization. Disabled by default. */
+    void set_map_index(bool yes) { if( ! yes) _map_index_free(); m_map_index_enabled = yes; }
+    bool map_index() const { return m_map_index_enabled; }
+
     inline size_t arena_size() const { return m_arena_pos; }
     inline size_t arena_capacity() const { return m_arena.len; }
     inline size_t arena_slack() const { RYML_ASSERT(m_arena.len >= m_arena_pos); return m_arena.len - m_arena_pos; }
@@ -513,6 +568,15 @@ public:
     // This function is implementation only; use at your own risk.
     inline NodeData const * _p(size_t i) const { RYML_ASSERT(i != NONE && i >= 0 && i < m_cap); return m_buf + i; }
 
+    // The key scalar of a node, regardless of whether it has a key.
+    // This function is implementation only; use at your own risk.
+    inline csubstr       & _key(size_t i)       { RYML_ASSERT(i != NONE && i >= 0 && i < m_cap); return m_keys[i]; }
+    inline csubstr const & _key(size_t i) const { RYML_ASSERT(i != NONE && i >= 0 && i < m_cap); return m_keys[i]; }
+    // The val scalar of a node, regardless of whether it has a val.
+    // This function is implementation only; use at your own risk.
+    inline csubstr       & _val(size_t i)       { RYML_ASSERT(i != NONE && i >= 0 && i < m_cap); return m_vals[i]; }
+    inline csubstr const & _val(size_t i) const { RYML_ASSERT(i != NONE && i >= 0 && i < m_cap); return m_vals[i]; }
+
     //! Get the id of the root node
     size_t root_id()       { if(m_cap == 0) { reserve(16); } RYML_ASSERT(m_cap > 0 && m_size > 0); return 0; }
     //! Get the id of the root node
@@ -552,17 +616,17 @@ public:
     NodeType_e  type(size_t node) const { return (NodeType_e)(_p(node)->m_type & _TYMASK); }
     const char* type_str(size_t node) const { return NodeType::type_str(_p(node)->m_type); }
 
-    csubstr    const& key       (size_t node) const { RYML_ASSERT(has_key(node)); return _p(node)->m_key.scalar; }
-    csubstr    const& key_tag   (size_t node) const { RYML_ASSERT(has_key_tag(node)); return _p(node)->m_key.tag; }
-    csubstr    const& key_ref   (size_t node) const { RYML_ASSERT(is_key_ref(node) && ! has_key_anchor(node)); return _p(node)->m_key.anchor; }
-    csubstr    const& key_anchor(size_t node) const { RYML_ASSERT( ! is_key_ref(node) && has_key_anchor(node)); return _p(node)->m_key.anchor; }
-    NodeScalar const& keysc     (size_t node) const { RYML_ASSERT(has_key(node)); return _p(node)->m_key; }
+    csubstr    const& key       (size_t node) const { RYML_ASSERT(has_key(node)); return m_keys[node]; }
+    csubstr           key_tag   (size_t node) const { RYML_ASSERT(has_key_tag(node)); return _props(node)->m_key_tag; }
+    csubstr           key_ref   (size_t node) const { RYML_ASSERT(is_key_ref(node) && ! has_key_anchor(node)); return _props(node)->m_key_anchor; }
+    csubstr           key_anchor(size_t node) const { RYML_ASSERT( ! is_key_ref(node) && has_key_anchor(node)); return _props(node)->m_key_anchor; }
+    NodeScalar        keysc     (size_t node) const;
 
-    csubstr    const& val       (size_t node) const { RYML_ASSERT(has_val(node)); return _p(node)->m_val.scalar; }
-    csubstr    const& val_tag   (size_t node) const { RYML_ASSERT(has_val_tag(node)); return _p(node)->m_val.tag; }
-    csubstr    const& val_ref   (size_t node) const { RYML_ASSERT(is_val_ref(node) && ! has_val_anchor(node)); return _p(node)->m_val.anchor; }
-    csubstr    const& val_anchor(size_t node) const { RYML_ASSERT( ! is_val_ref(node) && has_val_anchor(node)); return _p(node)->m_val.anchor; }
-    NodeScalar const& valsc     (size_t node) const { RYML_ASSERT(has_val(node)); return _p(node)->m_val; }
+    csubstr    const& val       (size_t node) const { RYML_ASSERT(has_val(node)); _filter_if_raw(node); return m_vals[node]; }
+    csubstr           val_tag   (size_t node) const { RYML_ASSERT(has_val_tag(node)); return _props(node)->m_val_tag; }
+    csubstr           val_ref   (size_t node) const { RYML_ASSERT(is_val_ref(node) && ! has_val_anchor(node)); return _props(node)->m_val_anchor; }
+    csubstr           val_anchor(size_t node) const { RYML_ASSERT( ! is_val_ref(node) && has_val_anchor(node)); return _props(node)->m_val_anchor; }
+    NodeScalar        valsc     (size_t node) const;
 
     /** @} */
 
@@ -595,14 +659,15 @@ public:
     C4_ALWAYS_INLINE bool is_key_quoted(size_t node) const { return _p(node)->m_type.is_key_quoted(); }
     C4_ALWAYS_INLINE bool is_val_quoted(size_t node) const { return _p(node)->m_type.is_val_quoted(); }
     C4_ALWAYS_INLINE bool is_quoted(size_t node) const { return _p(node)->m_type.is_quoted(); }
+    C4_ALWAYS_INLINE bool is_val_raw(size_t node) const { return _p(node)->m_type.is_val_raw(); }
 
     C4_ALWAYS_INLINE bool parent_is_seq(size_t node) const { RYML_ASSERT(has_parent(node)); return is_seq(_p(node)->m_parent); }
     C4_ALWAYS_INLINE bool parent_is_map(size_t node) const { RYML_ASSERT(has_parent(node)); return is_map(_p(node)->m_parent); }
 
     /** true when key and val are empty, and has no children */
-    bool empty(size_t node) const { return ! has_children(node) && _p(node)->m_key.empty() && (( ! (_p(node)->m_type & VAL)) || _p(node)->m_val.empty()); }
+    bool empty(size_t node) const;
     /** true when the node has an anchor named a */
-    bool has_anchor(size_t node, csubstr a) const { return _p(node)->m_key.anchor == a || _p(node)->m_val.anchor == a; }
+    bool has_anchor(size_t node, csubstr a) const;
 
     /** @} */
 
@@ -615,12 +680,12 @@ public:
 
     bool has_parent(size_t node) const { return _p(node)->m_parent != NONE; }
 
-    bool has_child(size_t node, csubstr key) const { return find_child(node, key) != npos; }
+    bool has_child(size_t node, csubstr key) const { return find_child(node, key) != NONE; }
     bool has_child(size_t node, size_t ch) const { return child_pos(node, ch) != npos; }
     bool has_children(size_t node) const { return _p(node)->m_first_child != NONE; }
 
     bool has_sibling(size_t node, size_t sib) const { return is_root(node) ? sib==node : child_pos(_p(node)->m_parent, sib) != npos; }
-    bool has_sibling(size_t node, csubstr key) const { return find_sibling(node, key) != npos; }
+    bool has_sibling(size_t node, csubstr key) const { return find_sibling(node, key) != NONE; }
     /** counts with *this */
     bool has_siblings(size_t /*node*/) const { return true; }
     /** does not count with *this */
@@ -673,22 +738,22 @@ public:
     void to_doc(size_t node, type_bits more_flags=0);
     void to_stream(size_t node, type_bits more_flags=0);
 
-    void set_key(size_t node, csubstr key) { RYML_ASSERT(has_key(node)); _p(node)->m_key.scalar = key; }
-    void set_val(size_t node, csubstr val) { RYML_ASSERT(has_val(node)); _p(node)->m_val.scalar = val; }
+    void set_key(size_t node, csubstr key) { RYML_ASSERT(has_key(node)); _key(node) = key; _key_changed(node); }
+    void set_val(size_t node, csubstr val) { RYML_ASSERT(has_val(node)); _val(node) = val; _p(node)->m_type.rem(VALRAW); }
 
-    void set_key_tag(size_t node, csubstr tag) { RYML_ASSERT(has_key(node)); _p(node)->m_key.tag = tag; _add_flags(node, KEYTAG); }
-    void set_val_tag(size_t node, csubstr tag) { RYML_ASSERT(has_val(node) || is_container(node)); _p(node)->m_val.tag = tag; _add_flags(node, VALTAG); }
+    void set_key_tag(size_t node, csubstr tag) { RYML_ASSERT(has_key(node)); _props_add(node)->m_key_tag = tag; _add_flags(node, KEYTAG); }
+    void set_val_tag(size_t node, csubstr tag) { RYML_ASSERT(has_val(node) || is_container(node)); _props_add(node)->m_val_tag = tag; _add_flags(node, VALTAG); }
 
-    void set_key_anchor(size_t node, csubstr anchor) { RYML_ASSERT( ! is_key_ref(node)); _p(node)->m_key.anchor = anchor.triml('&'); _add_flags(node, KEYANCH); }
-    void set_val_anchor(size_t node, csubstr anchor) { RYML_ASSERT( ! is_val_ref(node)); _p(node)->m_val.anchor = anchor.triml('&'); _add_flags(node, VALANCH); }
-    void set_key_ref   (size_t node, csubstr ref   ) { RYML_ASSERT( ! has_key_anchor(node)); NodeData* C4_RESTRICT n = _p(node); n->m_key.set_ref_maybe_replacing_scalar(ref, n->m_type.has_key()); _add_flags(node, KEY|KEYREF); }
-    void set_val_ref   (size_t node, csubstr ref   ) { RYML_ASSERT( ! has_val_anchor(node)); NodeData* C4_RESTRICT n = _p(node); n->m_val.set_ref_maybe_replacing_scalar(ref, n->m_type.has_val()); _add_flags(node, VAL|VALREF); }
+    void set_key_anchor(size_t node, csubstr anchor) { RYML_ASSERT( ! is_key_ref(node)); _props_add(node)->m_key_anchor = anchor.triml('&'); _add_flags(node, KEYANCH); }
+    void set_val_anchor(size_t node, csubstr anchor) { RYML_ASSERT( ! is_val_ref(node)); _props_add(node)->m_val_anchor = anchor.triml('&'); _add_flags(node, VALANCH); }
+    void set_key_ref   (size_t node, csubstr ref   ) { RYML_ASSERT( ! has_key_anchor(node)); NodeData* C4_RESTRICT n = _p(node); _set_ref_maybe_replacing_scalar(&_key(node), &_props_add(node)->m_key_anchor, ref, n->m_type.has_key()); _key_changed(node); _add_flags(node, KEY|KEYREF); }
+    void set_val_ref   (size_t node, csubstr ref   ) { RYML_ASSERT( ! has_val_anchor(node)); NodeData* C4_RESTRICT n = _p(node); _set_ref_maybe_replacing_scalar(&_val(node), &_props_add(node)->m_val_anchor, ref, n->m_type.has_val()); _add_flags(node, VAL|VALREF); }
 
-    void rem_key_anchor(size_t node) { _p(node)->m_key.anchor.clear(); _rem_flags(node, KEYANCH); }
-    void rem_val_anchor(size_t node) { _p(node)->m_val.anchor.clear(); _rem_flags(node, VALANCH); }
-    void rem_key_ref   (size_t node) { _p(node)->m_key.anchor.clear(); _rem_flags(node, KEYREF); }
-    void rem_val_ref   (size_t node) { _p(node)->m_val.anchor.clear(); _rem_flags(node, VALREF); }
-    void rem_anchor_ref(size_t node) { _p(node)->m_key.anchor.clear(); _p(node)->m_val.anchor.clear(); _rem_flags(node, KEYANCH|VALANCH|KEYREF|VALREF); }
+    void rem_key_anchor(size_t node) { _rem_props(node, KEYANCH); }
+    void rem_val_anchor(size_t node) { _rem_props(node, VALANCH); }
+    void rem_key_ref   (size_t node) { _rem_props(node, KEYREF); }
+    void rem_val_ref   (size_t node) { _rem_props(node, VALREF); }
+    void rem_anchor_ref(size_t node) { _rem_props(node, KEYANCH|VALANCH|KEYREF|VALREF); }
 
     /** @} */
 
@@ -723,6 +788,13 @@ public:
      */
     void resolve();
 
+    /** filter now every raw val, ie every val left unfiltered by a
+     * parser with lazy filtering. Reading a raw val filters it in
+     * place and so modifies the tree; call this before reading the
+     * tree from several threads.
+     * @see Parser::set_lazy_filtering() */
+    void filter_raw();
+
     /** @} */
 
 public:
@@ -958,15 +1030,18 @@ public:
      * existing arena, and thus change the contents of individual nodes. */
     substr alloc_arena(size_t sz)
     {
-        if(sz >= arena_slack())
-            _grow_arena(sz - arena_slack());
+        if(sz > arena_slack())
+            _grow_arena(sz);
         substr s = _request_span(sz);
         return s;
     }
 
     /** ensure the tree's internal string arena is at least the given capacity
      * @note Growing the arena may cause relocation of the entire
-     * existing arena, and thus change the contents of individual nodes. */
+     * existing arena, and thus change the contents of individual nodes:
+     * the nodes hold pointers to their strings, and not offsets. For the
+     * same reason, a tree cannot be copied byte-wise; use its copy
+     * constructor, which relocates the copied arena. */
     void reserve_arena(size_t arena_cap)
     {
         if(arena_cap > m_arena.len)
@@ -1005,17 +1080,6 @@ private:
         return s;
     }
 
-    substr _relocated(csubstr s, substr next_arena) const
-    {
-        RYML_ASSERT(m_arena.is_super(s));
-        RYML_ASSERT(m_arena.sub(0, m_arena_pos).is_super(s));
-        auto pos = (s.str - m_arena.str);
-        substr r(next_arena.str + pos, s.len);
-        RYML_ASSERT(r.str - next_arena.str == pos);
-        RYML_ASSERT(next_arena.sub(0, m_arena_pos).is_super(r));
-        return r;
-    }
-
 public:
 
     /** @name lookup */
@@ -1138,12 +1202,15 @@ public:
 
     void _set_key(size_t node, csubstr const& key, type_bits more_flags=0)
     {
-        _p(node)->m_key.scalar = key;
+        _key(node) = key;
+        _key_changed(node);
         _add_flags(node, KEY|more_flags);
     }
     void _set_key(size_t node, NodeScalar const& key, type_bits more_flags=0)
     {
-        _p(node)->m_key = key;
+        _key(node) = key.scalar;
+        _key_changed(node);
+        _set_key_props(node, key);
         _add_flags(node, KEY|more_flags);
     }
 
@@ -1151,14 +1218,17 @@ public:
     {
         RYML_ASSERT(num_children(node) == 0);
         RYML_ASSERT(!is_seq(node) && !is_map(node));
-        _p(node)->m_val.scalar = val;
+        _val(node) = val;
+        _p(node)->m_type.rem(VALRAW);
         _add_flags(node, VAL|more_flags);
     }
     void _set_val(size_t node, NodeScalar const& val, type_bits more_flags=0)
     {
         RYML_ASSERT(num_children(node) == 0);
         RYML_ASSERT( ! is_container(node));
-        _p(node)->m_val = val;
+        _val(node) = val.scalar;
+        _set_val_props(node, val);
+        _p(node)->m_type.rem(VALRAW);
         _add_flags(node, VAL|more_flags);
     }
 
@@ -1166,17 +1236,61 @@ public:
     {
         RYML_ASSERT(i._check());
         NodeData *n = _p(node);
-        RYML_ASSERT(n->m_key.scalar.empty() || i.key.scalar.empty() || i.key.scalar == n->m_key.scalar);
+        RYML_ASSERT(_key(node).empty() || i.key.scalar.empty() || i.key.scalar == _key(node));
         _add_flags(node, i.type);
-        if(n->m_key.scalar.empty())
+        if(_key(node).empty())
         {
             if( ! i.key.scalar.empty())
             {
                 _set_key(node, i.key.scalar);
             }
         }
-        n->m_key.tag = i.key.tag;
-        n->m_val = i.val;
+        if(n->m_type & (KEYTAG|_VALPROPS))
+        {
+            NodeProperties *C4_RESTRICT p = _props_add(node);
+            p->m_key_tag = i.key.tag;
+            p->m_val_tag = i.val.tag;
+            p->m_val_anchor = i.val.anchor;
+        }
+        _val(node) = i.val.scalar;
+        n->m_type.rem(VALRAW);
+    }
+
+    /** set the key's tag and anchor, keeping the other properties */
+    void _set_key_props(size_t node, NodeScalar const& key)
+    {
+        NodeData *C4_RESTRICT n = _p(node);
+        if(key.tag.empty() && key.anchor.empty() && ! (n->m_type & _PROPS))
+            return;
+        NodeProperties *C4_RESTRICT p = _props_add(node);
+        p->m_key_tag = key.tag;
+        p->m_key_anchor = key.anchor;
+        if( ! key.tag.empty())
+            n->m_type.add(KEYTAG);
+        if( ! key.anchor.empty() && ! (n->m_type & KEYREF))
+            n->m_type.add(KEYANCH);
+    }
+    /** set the val's tag and anchor, keeping the other properties */
+    void _set_val_props(size_t node, NodeScalar const& val)
+    {
+        NodeData *C4_RESTRICT n = _p(node);
+        if(val.tag.empty() && val.anchor.empty() && ! (n->m_type & _PROPS))
+            return;
+        NodeProperties *C4_RESTRICT p = _props_add(node);
+        p->m_val_tag = val.tag;
+        p->m_val_anchor = val.anchor;
+        if( ! val.tag.empty())
+            n->m_type.add(VALTAG);
+        if( ! val.anchor.empty() && ! (n->m_type & VALREF))
+            n->m_type.add(VALANCH);
+    }
+
+    static void _set_ref_maybe_replacing_scalar(csubstr *C4_RESTRICT scalar, csubstr *C4_RESTRICT anchor, csubstr ref, bool has_scalar) noexcept
+    {
+        csubstr trimmed = ref.begins_with('*') ? ref.sub(1) : ref;
+        *anchor = trimmed;
+        if((!has_scalar) || !scalar->ends_with(trimmed))
+            *scalar = ref;
     }
 
     void _set_parent_as_container_if_needed(size_t in)
@@ -1189,7 +1303,7 @@ public:
             {
                 if((in == first_child(ip)) && (in == last_child(ip)))
                 {
-                    if( ! n->m_key.empty() || has_key(in))
+                    if( ! _key(in).empty() || (n->m_type & (KEY|_KEYPROPS)))
                     {
                         _add_flags(ip, MAP);
                     }
@@ -1205,12 +1319,24 @@ public:
     void _seq2map(size_t node)
     {
         RYML_ASSERT(is_seq(node));
+        if(C4_UNLIKELY(m_map_index_size))
+            _map_index_rem(node); // the children get new keys
         for(size_t i = first_child(node); i != NONE; i = next_sibling(i))
         {
             NodeData *C4_RESTRICT ch = _p(i);
             if(ch->m_type.is_keyval()) continue;
+            _filter_if_raw(i); // keys are never raw
             ch->m_type.add(KEY);
-            ch->m_key = ch->m_val;
+            _key(i) = _val(i);
+            if(ch->m_type & _VALPROPS)
+            {
+                NodeProperties *C4_RESTRICT p = _props(i);
+                p->m_key_tag = p->m_val_tag;
+                p->m_key_anchor = p->m_val_anchor;
+                if(ch->m_type & VALTAG)  ch->m_type.add(KEYTAG);
+                if(ch->m_type & VALANCH) ch->m_type.add(KEYANCH);
+                if(ch->m_type & VALREF)  ch->m_type.add(KEYREF);
+            }
         }
         auto *C4_RESTRICT n = _p(node);
         n->m_type.rem(SEQ);
@@ -1226,37 +1352,26 @@ public:
 
     void _copy_props(size_t dst_, size_t src_)
     {
-        auto      & C4_RESTRICT dst = *_p(dst_);
-        auto const& C4_RESTRICT src = *_p(src_);
-        dst.m_type = src.m_type;
-        dst.m_key  = src.m_key;
-        dst.m_val  = src.m_val;
+        _copy_props(dst_, this, src_);
     }
 
     void _copy_props_wo_key(size_t dst_, size_t src_)
     {
-        auto      & C4_RESTRICT dst = *_p(dst_);
-        auto const& C4_RESTRICT src = *_p(src_);
-        dst.m_type = src.m_type;
-        dst.m_val  = src.m_val;
+        _copy_props_wo_key(dst_, this, src_);
     }
 
-    void _copy_props(size_t dst_, Tree const* that_tree, size_t src_)
-    {
-        auto      & C4_RESTRICT dst = *_p(dst_);
-        auto const& C4_RESTRICT src = *that_tree->_p(src_);
-        dst.m_type = src.m_type;
-        dst.m_key  = src.m_key;
-        dst.m_val  = src.m_val;
-    }
+    void _copy_props(size_t dst_, Tree const* that_tree, size_t src_);
+    void _copy_props_wo_key(size_t dst_, Tree const* that_tree, size_t src_);
 
-    void _copy_props_wo_key(size_t dst_, Tree const* that_tree, size_t src_)
+    /** filter the val of @p node if it is still raw. This is a
+     * logically const operation, as it does not change the value
+     * seen from outside. */
+    C4_ALWAYS_INLINE void _filter_if_raw(size_t node) const
     {
-        auto      & C4_RESTRICT dst = *_p(dst_);
-        auto const& C4_RESTRICT src = *that_tree->_p(src_);
-        dst.m_type = src.m_type;
-        dst.m_val  = src.m_val;
+        if(C4_UNLIKELY(_p(node)->m_type.type & VALRAW))
+            const_cast<Tree*>(this)->_filter_raw_val(node);
     }
+    void _filter_raw_val(size_t node);
 
     inline void _clear_type(size_t node)
     {
@@ -1266,9 +1381,13 @@ public:
     inline void _clear(size_t node)
     {
         auto *C4_RESTRICT n = _p(node);
+        if(n->m_type & _PROPS)
+            _props_rem(node);
+        if(C4_UNLIKELY(m_map_index_size))
+            _map_index_rem(node);
         n->m_type = NOTYPE;
-        n->m_key.clear();
-        n->m_val.clear();
+        _key(node).clear();
+        _val(node).clear();
         n->m_parent = NONE;
         n->m_first_child = NONE;
         n->m_last_child = NONE;
@@ -1276,16 +1395,67 @@ public:
 
     inline void _clear_key(size_t node)
     {
-        _p(node)->m_key.clear();
+        _key(node).clear();
+        _key_changed(node);
+        _rem_props(node, _KEYPROPS);
         _rem_flags(node, KEY);
     }
 
     inline void _clear_val(size_t node)
     {
-        _p(node)->m_key.clear();
+        _key(node).clear();
+        _key_changed(node);
+        _rem_props(node, _VALPROPS);
         _rem_flags(node, VAL);
     }
 
+    /** the flags of the properties kept in the NodeProperties table */
+    enum : type_bits {
+        _KEYPROPS = KEYTAG|KEYANCH|KEYREF,
+        _VALPROPS = VALTAG|VALANCH|VALREF,
+        _PROPS = _KEYPROPS|_VALPROPS,
+    };
+
+    /** get the properties of a node, which must have any of the _PROPS flags */
+    NodeProperties const* _props(size_t node) const { size_t pos = _props_pos(node); RYML_ASSERT(pos < m_props_size && m_props[pos].m_node == node); return m_props + pos; }
+    NodeProperties      * _props(size_t node)       { size_t pos = _props_pos(node); RYML_ASSERT(pos < m_props_size && m_props[pos].m_node == node); return m_props + pos; }
+    /** get the properties of a node, adding them if it has none */
+    NodeProperties      * _props_add(size_t node);
+    /** remove the properties of a node, if it has any */
+    void _props_rem(size_t node);
+    /** clear the given property flags, and the properties they mark */
+    void _rem_props(size_t node, type_bits props);
+    /** the position of the properties of a node in the table, or of
+     * the first entry after it */
+    size_t _props_pos(size_t node) const;
+
+    /** get the index of a map, or nullptr if it has none */
+    MapIndex const* _map_index(size_t node) const { size_t pos = _map_index_pos(node); return pos < m_map_index_size && m_map_index[pos].m_node == node ? m_map_index + pos : nullptr; }
+    MapIndex      * _map_index(size_t node)       { size_t pos = _map_index_pos(node); return pos < m_map_index_size && m_map_index[pos].m_node == node ? m_map_index + pos : nullptr; }
+    /** build the index of a map */
+    MapIndex      * _map_index_add(size_t node);
+    /** remove the index of a map, if it has one */
+    void _map_index_rem(size_t node);
+    /** remove the indices of all the maps */
+    void _map_index_free();
+    /** the position of the index of a map in the table, or of the
+     * first entry after it */
+    size_t _map_index_pos(size_t node) const;
+    /** fill the slots with all the children of the map */
+    void _map_index_build(MapIndex *idx);
+    void _map_index_insert(MapIndex *idx, size_t child);
+    size_t _map_index_find(MapIndex *idx, csubstr name);
+    /** remove a child from the index of its parent */
+    void _map_index_rem_child(size_t node);
+    /** to be called after the key of @p node has changed: its parent
+     * map cannot find it anymore by the previous key */
+    C4_ALWAYS_INLINE void _key_changed(size_t node)
+    {
+        if(C4_UNLIKELY(m_map_index_size))
+            _map_index_key_changed(node);
+    }
+    void _map_index_key_changed(size_t node);
+
 private:
 
     void _clear_range(size_t first, size_t num);
@@ -1304,9 +1474,12 @@ public:
     // members are exposed, but you should NOT access them directly
 
     NodeData * m_buf;
+    csubstr * m_keys; ///< parallel to m_buf, in the same allocation
+    csubstr * m_vals; ///< parallel to m_buf, in the same allocation
     size_t m_cap;
 
     size_t m_size;
+    size_t m_peak_size; ///< the largest m_size when a node was released
 
     size_t m_free_head;
     size_t m_free_tail;
@@ -1314,6 +1487,15 @@ public:
     substr m_arena;
     size_t m_arena_pos;
 
+    NodeProperties * m_props;
+    size_t m_props_size;
+    size_t m_props_cap;
+
+    MapIndex * m_map_index;
+    size_t m_map_index_size;
+    size_t m_map_index_cap;
+    bool m_map_index_enabled;
+
     Allocator m_alloc;
 
 };
@@ -0,0 +1,102 @@
+#include "c4/yml/validate.hpp"
+
+namespace c4 {
+namespace yml {
+
+namespace {
+
+/** counts the nodes of a json document as they are parsed */
+struct JsonCounter : public EventHandler
+{
+    size_t num_nodes = 0;
+    size_t depth = 0;
+    size_t max_depth = 0;
+
+    void _open()
+    {
+        ++num_nodes;
+        if(++depth > max_depth)
+            max_depth = depth;
+    }
+
+    void begin_map() override { _open(); }
+    void begin_seq() override { _open(); }
+    void end_map() override { --depth; }
+    void end_seq() override { --depth; }
+    void scalar(csubstr, bool) override
+    {
+        ++num_nodes;
+        if(depth + 1 > max_depth)
+            max_depth = depth + 1;
+    }
+};
+
+/** the depth of the tree, without recursion */
+size_t _depth(Tree const& t)
+{
+    size_t max_depth = 0;
+    size_t depth = 1;
+    size_t node = t.root_id();
+    while(true)
+    {
+        if(depth > max_depth)
+            max_depth = depth;
+        if(t.has_children(node))
+        {
+            node = t.first_child(node);
+            ++depth;
+            continue;
+        }
+        while(t.next_sibling(node) == NONE)
+        {
+            if(--depth == 0)
+                return max_depth;
+            node = t.parent(node);
+        }
+        node = t.next_sibling(node);
+    }
+}
+
+} // namespace
+
+
+Validator::Validator(Allocator const& a)
+    : m_parser(a)
+    , m_tree(a)
+{
+}
+
+ParseStats Validator::validate(csubstr filename, csubstr src)
+{
+    // recycle the nodes and the arena of the previous source
+    m_tree.clear();
+    m_tree.clear_arena();
+    m_parser.parse(filename, m_tree.copy_to_arena(src), &m_tree);
+    ParseStats stats;
+    // the parser may remove nodes, so the tree needs its peak size
+    stats.num_nodes = m_tree.peak_size();
+    stats.arena_size = m_tree.arena_size();
+    stats.max_depth = _depth(m_tree);
+    const size_t root = m_tree.root_id();
+    if(m_tree.is_stream(root))
+        stats.num_docs = m_tree.num_children(root);
+    else
+        stats.num_docs = m_tree.type(root) != NOTYPE || m_tree.has_children(root) ? 1 : 0;
+    return stats;
+}
+
+ParseStats Validator::validate_json(csubstr filename, csubstr src)
+{
+    m_tree.clear_arena();
+    JsonCounter counter;
+    m_parser.parse_json(filename, m_tree.copy_to_arena(src), &counter);
+    ParseStats stats;
+    stats.num_nodes = counter.num_nodes;
+    stats.arena_size = src.len;
+    stats.max_depth = counter.max_depth;
+    stats.num_docs = 1;
+    return stats;
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,92 @@
+#ifndef _C4_YML_VALIDATE_HPP_
+#define _C4_YML_VALIDATE_HPP_
+
+/** @file validate.hpp Checking a source and measuring what parsing it
+ * requires. */
+
+#ifndef _C4_YML_PARSE_HPP_
+#include "c4/yml/parse.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+/** The exact requirements for parsing a source, as found by Validator */
+struct ParseStats
+{
+    size_t num_nodes;  //!< the number of nodes needed by the tree, including the root. This is the peak number of nodes while parsing, which is not less than the final size of the tree.
+    size_t arena_size; //!< the arena bytes needed when parsing the read-only source, which is copied to the arena. Parsing in situ needs no arena, as the scalars are filtered in place.
+    size_t max_depth;  //!< the depth of the tree, where a lone root has depth 1. This can be given to Parser::reserve_stack().
+    size_t num_docs;   //!< the number of documents
+
+    /** reserve the tree's nodes and arena so that parsing the source
+     * into it will not reallocate */
+    void reserve(Tree *t) const
+    {
+        t->reserve(num_nodes);
+        t->reserve_arena(arena_size);
+    }
+};
+
+
+/** Checks sources and measures them, for linting or for sizing a tree
+ * before parsing into it:
+ *
+ * @code
+ * Validator v;
+ * ParseStats stats = v.validate(filename, src); // errors are reported as in parse()
+ * Tree t;
+ * stats.reserve(&t);
+ * parse(filename, src, &t); // no reallocation
+ * @endcode
+ *
+ * JSON is validated with the event interface of Parser::parse_json(),
+ * so no tree is built. YAML is not: the YAML parser keeps its state in
+ * the tree it builds, so validating a YAML source costs a full parse
+ * into a scratch tree kept by the validator. The nodes and arena of
+ * this tree are reused from one source to the next, so going through a
+ * corpus of sources with the same validator allocates only as much as
+ * its largest source needs.
+ *
+ * @note the source buffer is not modified: it is copied to a scratch
+ * buffer before being parsed. */
+class RYML_EXPORT Validator
+{
+public:
+
+    Validator(Allocator const& a={});
+
+    /** check a YAML source, and measure the tree it gives
+     *
+     * @note unlike validate_json(), this is as costly as parse(),
+     * and allocates: the source is fully parsed into the validator's
+     * scratch tree, which grows to the nodes and arena of the largest
+     * source seen so far. */
+    ParseStats validate(csubstr filename, csubstr src);
+    ParseStats validate(csubstr src) { return validate({}, src); }
+
+    /** check a strict JSON source, and measure the tree it gives */
+    ParseStats validate_json(csubstr filename, csubstr src);
+    ParseStats validate_json(csubstr src) { return validate_json({}, src); }
+
+    /** the parser used to validate, eg to reserve its stack */
+    Parser      & parser()       { return m_parser; }
+    Parser const& parser() const { return m_parser; }
+
+private:
+
+    Parser m_parser;
+    Tree   m_tree; //!< the scratch tree; for JSON only its arena is used
+
+};
+
+
+inline ParseStats validate(csubstr filename, csubstr src) { Validator v; return v.validate(filename, src); } //!< check a YAML source, and measure the tree it gives. This allocates a scratch tree for each call; use a Validator to reuse it.
+inline ParseStats validate(                 csubstr src) { Validator v; return v.validate({}, src); } //!< check a YAML source, and measure the tree it gives. This allocates a scratch tree for each call; use a Validator to reuse it.
+inline ParseStats validate_json(csubstr filename, csubstr src) { Validator v; return v.validate_json(filename, src); } //!< check a strict JSON source, and measure the tree it gives
+inline ParseStats validate_json(                 csubstr src) { Validator v; return v.validate_json({}, src); } //!< check a strict JSON source, and measure the tree it gives
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_VALIDATE_HPP_ */
@@ -4,7 +4,13 @@
 #include "./tree.hpp"
 #include "./node.hpp"
 #include "./emit.hpp"
+#include "./event_handler.hpp"
 #include "./parse.hpp"
 #include "./preprocess.hpp"
+#include "./push_parser.hpp"
+#include "./seq_reader.hpp"
+#include "./doc_reader.hpp"
+#include "./parallel.hpp"
+#include "./validate.hpp"
 
 #endif // _C4_YML_YML_HPP_
@@ -258,54 +258,12 @@ def qdump__c4__yml__NodeType(d, value):
 def qdump__c4__yml__NodeData(d, value):
     d.putValue("wtf")
     ty = _format_bitmask_value(value.integer(), node_types)
-    t = value["m_type"]["type"].integer()
-    k = value["m_key"]["scalar"]
-    v = value["m_val"]["scalar"]
-    sk, lk = get_str_value(d, k)
-    sv, lv = get_str_value(d, v)
-    if _node_type_has_all(t, "KEYVAL"):
-        d.putValue(f"'{sk}': '{sv}'    {ty}")
-    elif _node_type_has_any(t, "KEY"):
-        d.putValue(f"'{sk}':    {ty}")
-    elif _node_type_has_any(t, "VAL"):
-        d.putValue(f"'{sv}'    {ty}")
-    else:
-        d.putValue(f"{ty}")
+    d.putValue(f"{ty}")
     d.putExpandable()
     if d.isExpanded():
         with Children(d):
             d.putSubItem("m_type", value["m_type"])
-            # key
-            if _node_type_has_any(t, "KEY"):
-                d.putSubItem("m_key", value["m_key"])
-            if _node_type_has_any(t, "KEYREF"):
-                with SubItem(d, "m_key.ref"):
-                    s_, _ = get_str_value(d, value["m_key"]["anchor"])
-                    d.putValue(f"'{s_}'")
-            if _node_type_has_any(t, "KEYANCH"):
-                with SubItem(d, "m_key.anchor"):
-                    s_, _ = get_str_value(d, value["m_key"]["anchor"])
-                    d.putValue(f"'{s_}'")
-            if _node_type_has_any(t, "KEYTAG"):
-                with SubItem(d, "m_key.tag"):
-                    s_, _ = get_str_value(d, value["m_key"]["tag"])
-                    d.putValue(f"'{s_}'")
-            # val
-            if _node_type_has_any(t, "VAL"):
-                d.putSubItem("m_val", value["m_val"])
-            if _node_type_has_any(t, "VALREF"):
-                with SubItem(d, "m_val.ref"):
-                    s_, _ = get_str_value(d, value["m_val"]["anchor"])
-                    d.putValue(f"'{s_}'")
-            if _node_type_has_any(t, "VALANCH"):
-                with SubItem(d, "m_val.anchor"):
-                    s_, _ = get_str_value(d, value["m_val"]["anchor"])
-                    d.putValue(f"'{s_}'")
-            if _node_type_has_any(t, "VALTAG"):
-                with SubItem(d, "m_val.tag"):
-                    s_, _ = get_str_value(d, value["m_val"]["tag"])
-                    d.putValue(f"'{s_}'")
-            # hierarchy
+            # hierarchy (the key and val are in the tree's m_keys and m_vals)
             _dump_node_index(d, "m_parent", value)
             _dump_node_index(d, "m_first_child", value)
             _dump_node_index(d, "m_last_child", value)
@@ -333,6 +291,12 @@ def qdump__c4__yml__Tree(d, value):
             with SubItem(d, f"[nodes]"):
                 d.putItemCount(m_size)
                 d.putArrayData(value["m_buf"].pointer(), m_size, value["m_buf"].type.dereference())
+            with SubItem(d, f"[keys]"):
+                d.putItemCount(m_size)
+                d.putArrayData(value["m_keys"].pointer(), m_size, value["m_keys"].type.dereference())
+            with SubItem(d, f"[vals]"):
+                d.putItemCount(m_size)
+                d.putArrayData(value["m_vals"].pointer(), m_size, value["m_vals"].type.dereference())
             d.putPtrItem("m_buf", value["m_buf"].pointer())
             d.putIntItem("m_size", value["m_size"])
             d.putIntItem("m_cap (capacity)", value["m_cap"])
@@ -219,6 +219,23 @@ TEST(Tree, reserve)
     test_invariants(t);
 }
 
+TEST(Tree, id_type)
+{
+    // NONE must survive being stored in a link
+    EXPECT_EQ((size_t)NONE, (size_t)id_type(-1));
+    Tree t = parse("{a: [b, c], d: e}");
+    EXPECT_EQ(t.parent(t.root_id()), NONE);
+    EXPECT_EQ(t.prev_sibling(t.root_id()), NONE);
+    EXPECT_EQ(t.next_sibling(t["d"].id()), NONE);
+    EXPECT_EQ(t.first_child(t["d"].id()), NONE);
+    EXPECT_EQ(t.find_child(t.root_id(), "x"), NONE);
+    EXPECT_FALSE(t.has_child(t.root_id(), "x"));
+    EXPECT_TRUE(t.has_child(t.root_id(), "d"));
+    EXPECT_FALSE(t.has_sibling(t["a"].id(), "x"));
+    EXPECT_EQ(t.parent(t["a"][1].id()), t["a"].id());
+    test_invariants(t);
+}
+
 TEST(Tree, clear)
 {
     Tree t(16, 64);
@@ -284,6 +301,56 @@ TEST(Tree, clear)
     test_invariants(t);
 }
 
+TEST(Tree, peak_size)
+{
+    Tree t = parse("[a, b, c, d, e, f]");
+    EXPECT_EQ(t.size(), 7);
+    EXPECT_EQ(t.peak_size(), 7);
+    t.remove(t.first_child(t.root_id()));
+    t.remove(t.first_child(t.root_id()));
+    EXPECT_EQ(t.size(), 5);
+    EXPECT_EQ(t.peak_size(), 7);
+    t.rootref().append_child() = "g";
+    EXPECT_EQ(t.size(), 6);
+    EXPECT_EQ(t.peak_size(), 7);
+    t.rootref().append_child() = "h";
+    t.rootref().append_child() = "i";
+    EXPECT_EQ(t.size(), 8);
+    EXPECT_EQ(t.peak_size(), 8);
+    t.remove(t.last_child(t.root_id()));
+    Tree copy = t;
+    EXPECT_EQ(copy.size(), 7);
+    EXPECT_EQ(copy.peak_size(), 8);
+    Tree moved = std::move(copy);
+    EXPECT_EQ(moved.peak_size(), 8);
+    t.clear();
+    EXPECT_EQ(t.size(), 1);
+    EXPECT_EQ(t.peak_size(), 1);
+}
+
+TEST(Tree, alloc_arena)
+{
+    Tree t(16, 64);
+    const char *arena = t.arena().str;
+    // an exact fit must not grow the arena
+    substr s = t.alloc_arena(64);
+    EXPECT_EQ(s.len, 64);
+    EXPECT_EQ(s.str, arena);
+    EXPECT_EQ(t.arena_capacity(), 64);
+    EXPECT_EQ(t.arena_slack(), 0);
+    EXPECT_EQ(t.arena_size(), 64);
+    // must grow by more than the current slack
+    t.clear_arena();
+    s = t.alloc_arena(40);
+    EXPECT_EQ(s.len, 40);
+    EXPECT_EQ(t.arena_slack(), 24);
+    s = t.alloc_arena(200);
+    EXPECT_EQ(s.len, 200);
+    EXPECT_TRUE(t.arena().is_super(s));
+    EXPECT_GE(t.arena_capacity(), 240);
+    EXPECT_EQ(t.arena_size(), 240);
+}
+
 
 //-------------------------------------------
 
@@ -439,6 +506,307 @@ far: a long long way to run
 )");
 }
 
+TEST(Tree, properties_table)
+{
+    // tags and anchors are not kept in the nodes
+    EXPECT_LE(sizeof(NodeData), sizeof(NodeType) + 2 * sizeof(csubstr) + 5 * sizeof(id_type) + alignof(NodeData));
+    Tree t = parse("a: &a !!str 1\nb: 2\nc: *a\n!k d: [e, f]\n");
+    // only the nodes with tags, anchors or refs have an entry
+    EXPECT_EQ(t.m_props_size, 3u);
+    EXPECT_EQ(t["a"].val_anchor(), "a");
+    EXPECT_EQ(t["a"].val_tag(), "!!str");
+    EXPECT_EQ(t["c"].val_ref(), "a");
+    EXPECT_EQ(t["d"].key_tag(), "!k");
+    EXPECT_EQ(t["a"].valsc().tag, "!!str");
+    EXPECT_EQ(t["a"].valsc().anchor, "a");
+    EXPECT_EQ(t["b"].valsc().tag, "");
+    EXPECT_EQ(t["d"].keysc().tag, "!k");
+    // the table is reallocated as properties are added, so its
+    // strings are returned by value
+    EXPECT_TRUE((std::is_same<decltype(t.val_tag(0)), csubstr>::value));
+    EXPECT_TRUE((std::is_same<decltype(t.rootref().key_anchor()), csubstr>::value));
+    const csubstr tag = t["a"].val_tag();
+    // added out of order
+    t.set_val_tag(t["b"].id(), "!!int");
+    t.set_key_anchor(t["b"].id(), "kb");
+    t.set_val_anchor(t["d"][1].id(), "f");
+    EXPECT_EQ(t.m_props_size, 5u);
+    for(size_t i = 1; i < t.m_props_size; ++i)
+    {
+        EXPECT_LT(t.m_props[i-1].m_node, t.m_props[i].m_node);
+    }
+    EXPECT_EQ(t["b"].val_tag(), "!!int");
+    EXPECT_EQ(t["b"].key_anchor(), "kb");
+    EXPECT_EQ(t["a"].val_tag(), "!!str");
+    EXPECT_EQ(tag, "!!str");
+    EXPECT_EQ(emitrs<std::string>(t), "a: !!str &a 1\n&kb b: !!int 2\nc: *a\n!k d:\n  - e\n  - &f f\n");
+    // the entries go away with the last property
+    t.rem_key_anchor(t["b"].id());
+    EXPECT_EQ(t["b"].val_tag(), "!!int");
+    EXPECT_EQ(t.m_props_size, 5u);
+    t.rem_anchor_ref(t["a"].id());
+    EXPECT_EQ(t["a"].val_tag(), "!!str");
+    EXPECT_EQ(t.m_props_size, 5u);
+    t.rem_val_anchor(t["d"][1].id());
+    EXPECT_EQ(t.m_props_size, 4u);
+    t.remove(t["d"].id());
+    EXPECT_EQ(t.m_props_size, 3u);
+    t.to_keyval(t["a"].id(), "a", "1");
+    EXPECT_FALSE(t["a"].has_val_tag());
+    EXPECT_EQ(t.m_props_size, 2u);
+    EXPECT_EQ(emitrs<std::string>(t), "a: 1\nb: !!int 2\nc: *a\n");
+    // copies have their own
+    Tree cp = t;
+    cp.set_val_tag(cp["c"].id(), "!x");
+    EXPECT_FALSE(t["c"].has_val_tag());
+    EXPECT_EQ(cp["b"].val_tag(), "!!int");
+    Tree dup;
+    dup.rootref() |= MAP;
+    dup.duplicate_children(&t, t.root_id(), dup.root_id(), NONE);
+    EXPECT_EQ(emitrs<std::string>(dup), "a: 1\nb: !!int 2\nc: *a\n");
+    t.clear();
+    EXPECT_EQ(t.m_props_size, 0u);
+}
+
+TEST(Tree, scalar_arrays)
+{
+    // the scalars are not kept in the nodes either
+    EXPECT_LE(sizeof(NodeData), sizeof(NodeType) + 5 * sizeof(id_type) + alignof(NodeData));
+    Tree t(2, 1024); // the arena does not grow
+    t.rootref() |= MAP;
+    for(size_t i = 0; i < 40; ++i) // grow the node buffer a few times
+        t.to_keyval(t.append_child(t.root_id()), t.to_arena(i), t.to_arena(2 * i));
+    ASSERT_GE(t.capacity(), 41u);
+    EXPECT_EQ((void*)t.m_keys, (void*)(t.m_buf + t.m_cap));
+    EXPECT_EQ(t.m_vals, t.m_keys + t.m_cap);
+    EXPECT_EQ(t.key(t.child(t.root_id(), 33)), "33");
+    EXPECT_EQ(t.val(t.child(t.root_id(), 33)), "66");
+    EXPECT_EQ(t.find_child(t.root_id(), "17"), t.child(t.root_id(), 17));
+    t.remove(t.child(t.root_id(), 17));
+    EXPECT_EQ(t.find_child(t.root_id(), "17"), (size_t)NONE);
+    EXPECT_EQ(t._key(t.root_id()), "");
+    t.move(t.child(t.root_id(), 0), t.child(t.root_id(), 5));
+    EXPECT_EQ(t.key(t.child(t.root_id(), 5)), "0");
+    EXPECT_EQ(t.val(t.child(t.root_id(), 5)), "0");
+    Tree cp = t;
+    EXPECT_NE(cp.m_keys, t.m_keys);
+    EXPECT_EQ((void*)cp.m_keys, (void*)(cp.m_buf + cp.m_cap));
+    EXPECT_EQ(emitrs<std::string>(cp), emitrs<std::string>(t));
+    Tree mv = std::move(cp);
+    EXPECT_EQ(cp.m_keys, nullptr);
+    EXPECT_EQ(cp.m_vals, nullptr);
+    EXPECT_EQ(emitrs<std::string>(mv), emitrs<std::string>(t));
+    t.clear();
+    EXPECT_EQ(t.m_vals[t.m_cap-1], "");
+}
+
+size_t find_child_linear(Tree const& t, size_t node, csubstr name)
+{
+    for(size_t i = t.first_child(node); i != NONE; i = t.next_sibling(i))
+        if(t._key(i) == name)
+            return i;
+    return NONE;
+}
+
+TEST(Tree, map_index)
+{
+    const size_t num = 4 * RYML_MAP_INDEX_MIN_CHILDREN;
+    Tree t(num + 16, 16 * num); // the arena does not grow
+    size_t r = t.root_id();
+    t.to_map(r);
+    for(size_t i = 0; i < num; ++i)
+        t.to_keyval(t.append_child(r), t.to_arena(i), "v");
+    // disabled by default
+    EXPECT_FALSE(t.map_index());
+    EXPECT_EQ(t.find_child(r, "missing"), (size_t)NONE);
+    EXPECT_EQ(t.m_map_index_size, 0u);
+    t.set_map_index(true);
+    // small maps are not indexed
+    size_t small = t.append_child(r);
+    t.to_map(small, "small");
+    for(size_t i = 0; i + 1 < RYML_MAP_INDEX_MIN_CHILDREN; ++i)
+        t.to_keyval(t.append_child(small), t.to_arena(i), "v");
+    EXPECT_EQ(t.find_child(small, "missing"), (size_t)NONE);
+    EXPECT_EQ(t.m_map_index_size, 0u);
+    // large maps are, on the first long lookup
+    EXPECT_EQ(t.find_child(r, "missing"), (size_t)NONE);
+    EXPECT_EQ(t.m_map_index_size, 1u);
+    for(size_t i = 0; i < num; ++i)
+    {
+        EXPECT_EQ(t.find_child(r, t.key(t.child(r, i))), t.child(r, i));
+    }
+    EXPECT_EQ(t.find_child(r, "small"), small);
+    // appended children are found, and keep the index
+    t["new"] = "x";
+    size_t added = t.append_child(r);
+    t.to_keyval(added, "added", "y");
+    EXPECT_EQ(t.find_child(r, "added"), added);
+    EXPECT_EQ(t.find_child(r, "new"), t.prev_sibling(added));
+    EXPECT_EQ(t.m_map_index_size, 1u);
+    // removed children are not
+    size_t ch5 = t.find_child(r, "5");
+    ASSERT_NE(ch5, (size_t)NONE);
+    t.remove(ch5);
+    EXPECT_EQ(t.find_child(r, "5"), (size_t)NONE);
+    t.remove(added);
+    EXPECT_EQ(t.find_child(r, "added"), (size_t)NONE);
+    EXPECT_EQ(t.find_child(r, "new"), t.last_child(r));
+    EXPECT_EQ(t.m_map_index_size, 1u);
+    // nor by their previous key
+    size_t ch7 = t.find_child(r, "7");
+    t.set_key(ch7, "seven");
+    EXPECT_EQ(t.find_child(r, "7"), (size_t)NONE);
+    EXPECT_EQ(t.find_child(r, "seven"), ch7);
+    // equal keys find the first child, as the linear search does
+    t.to_keyval(t.insert_child(r, t.first_child(r)), "8", "dup");
+    EXPECT_EQ(t.val(t.find_child(r, "8")), "dup");
+    t.to_keyval(t.append_child(r), "9", "dup");
+    EXPECT_EQ(t.val(t.find_child(r, "9")), "v");
+    // moved children
+    size_t ch10 = t.find_child(r, "10");
+    t.move(ch10, r, NONE);
+    EXPECT_EQ(t.first_child(r), ch10);
+    EXPECT_EQ(t.find_child(r, "10"), ch10);
+    t.move(ch10, small, NONE);
+    EXPECT_EQ(t.find_child(r, "10"), (size_t)NONE);
+    EXPECT_EQ(t.find_child(small, "10"), ch10);
+    // every key agrees with the linear search
+    for(size_t i = t.first_child(r); i != NONE; i = t.next_sibling(i))
+    {
+        EXPECT_EQ(t.find_child(r, t.key(i)), find_child_linear(t, r, t.key(i)));
+    }
+    // copies build their own
+    Tree cp = t;
+    EXPECT_TRUE(cp.map_index());
+    EXPECT_EQ(cp.m_map_index_size, 0u);
+    EXPECT_EQ(cp.find_child(r, "missing"), (size_t)NONE);
+    EXPECT_EQ(cp.m_map_index_size, 1u);
+    EXPECT_EQ(cp.find_child(r, "seven"), ch7);
+    // children change ids
+    t.reorder();
+    EXPECT_EQ(t.m_map_index_size, 0u);
+    EXPECT_EQ(t.find_child(r, "missing"), (size_t)NONE);
+    EXPECT_EQ(t.m_map_index_size, 1u);
+    EXPECT_EQ(t.find_child(r, "seven"), find_child_linear(t, r, "seven"));
+    t.clear();
+    EXPECT_EQ(t.m_map_index_size, 0u);
+    EXPECT_TRUE(t.map_index());
+    t.set_map_index(false);
+    EXPECT_EQ(cp.m_map_index_size, 1u);
+    cp.set_map_index(false);
+    EXPECT_EQ(cp.m_map_index_size, 0u);
+}
+
+TEST(Tree, map_index_random_edits)
+{
+    Tree t;
+    t.set_map_index(true);
+    t.reserve_arena(1 << 16); // the arena does not grow
+    size_t r = t.root_id();
+    t.to_map(r);
+    uint32_t rng = 12345u;
+    auto rand = [&rng](uint32_t max) { rng = rng * 1664525u + 1013904223u; return (rng >> 8) % max; };
+    for(size_t step = 0; step < 4000; ++step)
+    {
+        size_t num = t.num_children(r);
+        csubstr k = t.to_arena(rand(300));
+        switch(num < 2 ? 0 : rand(6))
+        {
+        case 0:
+        case 1:
+            t.to_keyval(t.append_child(r), k, "v");
+            break;
+        case 2:
+            t.to_keyval(t.insert_child(r, t.child(r, rand((uint32_t)num))), k, "v");
+            break;
+        case 3:
+            t.remove(t.child(r, rand((uint32_t)num)));
+            break;
+        case 4:
+            t.set_key(t.child(r, rand((uint32_t)num)), k);
+            break;
+        case 5:
+        {
+            size_t node = t.child(r, rand((uint32_t)num)), after = t.child(r, rand((uint32_t)num));
+            if(node != after)
+                t.move(node, after);
+            break;
+        }
+        }
+        csubstr q = t.to_arena(rand(300));
+        ASSERT_EQ(t.find_child(r, q), find_child_linear(t, r, q)) << step;
+    }    EXPECT_EQ(t.find_child(r, "missing"), (size_t)NONE);
+    EXPECT_EQ(t.m_map_index_size, 1u);
+}
+
+TEST(Tree, relocate_only_arena_strings)
+{
+    // parse in situ, so that only the strings added later are in the arena
+    char src_[] = "a: 1\nb: 2\n";
+    substr src = src_;
+    Tree t = parse(src);
+    t["c"] << 3; // serialized to the arena
+    t["d"] = t.copy_to_arena("four");
+    t["e"] = "five"; // a literal, neither in the source nor the arena
+    t.to_keyval(t.append_child(t.root_id()), t.copy_to_arena("f"), t.alloc_arena(0)); // empty, at the end of the arena
+    csubstr prev_arena = t.arena();
+    t.reserve_arena(10 * t.arena_capacity());
+    EXPECT_NE(t.arena().str, prev_arena.str);
+    EXPECT_TRUE(src.is_super(t["a"].key()));
+    EXPECT_TRUE(src.is_super(t["b"].val()));
+    EXPECT_TRUE(t.in_arena(t["c"].val()));
+    EXPECT_TRUE(t.in_arena(t["d"].val()));
+    EXPECT_FALSE(t.in_arena(t["e"].val()));
+    EXPECT_TRUE(t.in_arena(t["f"].key()));
+    EXPECT_EQ(t["c"].val(), "3");
+    EXPECT_EQ(t["d"].val(), "four");
+    EXPECT_EQ(t["e"].val(), "five");
+    EXPECT_EQ(t["f"].val(), "");
+    EXPECT_EQ(emitrs<std::string>(t), "a: 1\nb: 2\nc: 3\nd: four\ne: five\nf: ''\n");
+}
+
+
+/** hands out consecutive blocks of a buffer, so that an allocation
+ * can be placed right after the tree's arena */
+struct ConsecutiveMemoryResource : public MemoryResource
+{
+    char buf[4096];
+    size_t pos = 0;
+    void* allocate(size_t len, void *) override
+    {
+        len = (len + 7u) & ~size_t(7u);
+        RYML_CHECK(pos + len <= sizeof(buf));
+        void *mem = buf + pos;
+        pos += len;
+        return mem;
+    }
+    void free(void *, size_t) override {}
+};
+
+TEST(Tree, relocate_str_after_full_arena)
+{
+    ConsecutiveMemoryResource mr;
+    Tree t(&mr);
+    t.reserve(16);
+    t.reserve_arena(8);
+    csubstr full = t.copy_to_arena("01234567");
+    ASSERT_EQ(t.arena_slack(), 0u);
+    // a string which is not in the arena, but starts right at its end
+    substr after = {(char*) mr.allocate(8, nullptr), 3};
+    ASSERT_EQ(after.str, t.arena().str + t.arena().len);
+    memcpy(after.str, "xyz", 3);
+    NodeRef root = t.rootref();
+    root |= MAP;
+    t.to_keyval(t.append_child(root.id()), full, after);
+    t.to_keyval(t.append_child(root.id()), after, full);
+    t.reserve_arena(64);
+    EXPECT_EQ(root[0].key(), "01234567");
+    EXPECT_EQ(root[0].val(), "xyz");
+    EXPECT_EQ(root[0].val().str, after.str);
+    EXPECT_EQ(root[1].key().str, after.str);
+    EXPECT_EQ(root[1].val(), "01234567");
+}
+
 
 //-------------------------------------------
 template<class Container, class... Args>
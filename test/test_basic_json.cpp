@@ -219,6 +219,129 @@ broken_value: '0.30.2'
 }
 
 
+//-----------------------------------------------------------------------------
+
+void test_parse_json_same_as_yaml(csubstr json)
+{
+    SCOPED_TRACE(json);
+    std::string yml_buf(json.begin(), json.end()), json_buf = yml_buf;
+    Tree from_yml = parse(to_substr(yml_buf));
+    Tree from_json = parse_json(to_substr(json_buf));
+    ASSERT_EQ(from_json.size(), from_yml.size());
+    std::string yml_out, json_out;
+    emitrs_json(from_yml, &yml_out);
+    emitrs_json(from_json, &json_out);
+    EXPECT_EQ(json_out, yml_out);
+    for(size_t i = 0; i < from_json.size(); ++i)
+    {
+        EXPECT_EQ(from_json.type(i), from_yml.type(i));
+        if(from_json.has_key(i))
+        {
+            EXPECT_EQ(from_json.key(i), from_yml.key(i));
+        }
+        if(from_json.has_val(i))
+        {
+            EXPECT_EQ(from_json.val(i), from_yml.val(i));
+        }
+    }
+}
+
+TEST(parse_json, same_as_yaml)
+{
+    test_parse_json_same_as_yaml(R"({"a":1,"b":[1,"x",null,true,false,{}],"c":{"d":"e"}})");
+    test_parse_json_same_as_yaml(R"({
+  "glossary": {
+    "title": "example glossary",
+    "GlossDiv": {
+      "title": "S",
+      "GlossList": [ {"ID": "SGML", "SortAs": "SGML", "Abbrev": "ISO 8879:1986", "GlossSeeAlso": ["GML", "XML"]} ]
+    }
+  }
+}
+)");
+    test_parse_json_same_as_yaml(R"([[], [[]], {}, [{}], -1.5e-3, 0, "s p a c e"])");
+    test_parse_json_same_as_yaml(R"("a top-level string")");
+    test_parse_json_same_as_yaml(R"(12345)");
+    test_parse_json_same_as_yaml("{\"a\":\r\n[1,\r\n2]}\r\n");
+}
+
+TEST(parse_json, quoted_flags)
+{
+    Tree t = parse_json(R"({"a": "1", "b": 1, "c": ["2", 2]})");
+    EXPECT_TRUE(t["a"].get()->m_type.is_key_quoted());
+    EXPECT_TRUE(t["a"].get()->m_type.is_val_quoted());
+    EXPECT_FALSE(t["b"].get()->m_type.is_val_quoted());
+    EXPECT_TRUE(t["c"][0].get()->m_type.is_val_quoted());
+    EXPECT_FALSE(t["c"][1].get()->m_type.is_val_quoted());
+    std::string out;
+    emitrs_json(t, &out);
+    EXPECT_EQ(out, R"({"a": "1","b": 1,"c": ["2",2]})");
+}
+
+TEST(parse_json, escapes)
+{
+    Tree t = parse_json(R"(["\"\\\/\b\f\n\r\t", "\u0041\u00e9\u20ac", "\ud83d\ude00", "no escapes"])");
+    EXPECT_EQ(t[0].val(), "\"\\/\b\f\n\r\t");
+    EXPECT_EQ(t[1].val(), "A\xc3\xa9\xe2\x82\xac");
+    EXPECT_EQ(t[2].val(), "\xf0\x9f\x98\x80");
+    EXPECT_EQ(t[3].val(), "no escapes");
+}
+
+TEST(parse_json, null_is_empty)
+{
+    Tree t = parse_json(R"({"a": null, "b": "null"})");
+    EXPECT_EQ(t["a"].val(), nullptr);
+    EXPECT_EQ(t["b"].val(), "null");
+}
+
+TEST(parse_json, into_existing_node)
+{
+    Tree t = parse("{foo: 1, bar: }");
+    parse_json(R"({"x": [1, 2]})", t["bar"]);
+    EXPECT_EQ(t["foo"].val(), "1");
+    ASSERT_TRUE(t["bar"].is_map());
+    EXPECT_EQ(t["bar"]["x"][1].val(), "2");
+    parse_json(R"("replaced")", t["foo"]);
+    EXPECT_EQ(t["foo"].val(), "replaced");
+}
+
+TEST(parse_json, errors)
+{
+    auto err = [](csubstr json, size_t line, size_t col){
+        SCOPED_TRACE(json);
+        Location loc = {};
+        loc.line = line;
+        loc.col = col;
+        ExpectError::do_check([json](){
+            Tree t = parse_json(json);
+        }, loc);
+    };
+    err("", 1, 1);
+    err("  \n ", 2, 2);
+    err("[1,]", 1, 4);
+    err("[1 2]", 1, 4);
+    err("{\"a\" 1}", 1, 6);
+    err("{a: 1}", 1, 2);
+    err("[01]", 1, 2);
+    err("[1.]", 1, 2);
+    err("[tru]", 1, 2);
+    err("[\"abc]", 1, 2);
+    err("[\"\\x\"]", 1, 3);
+    err("[\"\\u12g4\"]", 1, 3);
+    err("{\"a\": [1}", 1, 9);
+    err("[1]\n x", 2, 2);
+    err("{\"a\":\n[1,\n 2", 3, 3);
+}
+
+TEST(parse_json, numbers)
+{
+    for(csubstr n : {csubstr("0"), csubstr("-0"), csubstr("10"), csubstr("-1.25"), csubstr("1e5"), csubstr("1E+5"), csubstr("0.5e-10")})
+    {
+        Tree t = parse_json(n);
+        EXPECT_EQ(t.rootref().val(), n);
+    }
+}
+
 //-------------------------------------------
 // this is needed to use the test case library
 Case const* get_case(csubstr /*name*/)
@@ -139,7 +139,8 @@ indented_once:
     "block folded as map val, explicit indentation 2, chomp=strip",\
     "block folded as map val, explicit indentation 3",\
     "block folded as map val, explicit indentation 4",\
-    "block folded as map val, explicit indentation 9"
+    "block folded as map val, explicit indentation 9",\
+    "block folded with long and more-indented lines"
 
 
 CASE_GROUP(BLOCK_FOLDED)
@@ -423,6 +424,23 @@ another: val
     N("another", "val")
   }
 ),
+
+C("block folded with long and more-indented lines",
+R"(script: >
+  SELECT id, name, value FROM some_table WHERE x = 1 AND y = 2
+  ORDER BY id, name, value LIMIT 100 OFFSET 200
+    -- an indented comment line, kept as it is
+    -- and another one
+  UNION ALL SELECT id, name, value FROM another_table
+
+  WHERE x = 3 AND y = 4 AND z = 5 AND w = 6 AND v = 7
+other: val
+)",
+  L{
+    N(QV, "script", "SELECT id, name, value FROM some_table WHERE x = 1 AND y = 2 ORDER BY id, name, value LIMIT 100 OFFSET 200\n  -- an indented comment line, kept as it is\n  -- and another one\nUNION ALL SELECT id, name, value FROM another_table\nWHERE x = 3 AND y = 4 AND z = 5 AND w = 6 AND v = 7\n"),
+    N("other", "val")
+  }
+),
     )
 }
 
@@ -23,7 +23,9 @@ namespace yml {
     "block literal as map val, explicit indentation 9",\
     "block literal with empty unindented lines, without quotes",\
     "block literal with empty unindented lines, with double quotes",\
-    "block literal with empty unindented lines, with single quotes"
+    "block literal with empty unindented lines, with single quotes",\
+    "block literal with long and indented lines",\
+    "block literal with blank lines of less indentation"
 
 
 CASE_GROUP(BLOCK_LITERAL)
@@ -363,6 +365,41 @@ C("block literal with empty unindented lines, with single quotes",
     N("tpl", L{N(QV, "src", "#include '{{hdr.filename}}'\n\n{{src.gencode}}\n")})
   }
 ),
+
+C("block literal with long and indented lines",
+R"(script: |
+    #!/bin/sh
+    for f in one two three four five six seven eight nine ten; do
+        echo "processing $f, processing $f, processing $f"
+    done
+
+    exit 0
+other: val
+)",
+  L{
+    N(QV, "script", "#!/bin/sh\nfor f in one two three four five six seven eight nine ten; do\n    echo \"processing $f, processing $f, processing $f\"\ndone\n\nexit 0\n"),
+    N("other", "val")
+  }
+),
+
+C("block literal with blank lines of less indentation",
+R"(a: |
+    first line
+  
+    second line
+ 
+    third line
+b: |2
+    x
+  y
+c: end
+)",
+  L{
+    N(QV, "a", "first line\n\nsecond line\n\nthird line\n"),
+    N(QV, "b", "  x\ny\n"),
+    N("c", "end")
+  }
+),
     )
 }
 
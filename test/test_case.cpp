@@ -98,23 +98,29 @@ void test_compare(Tree const& a, size_t node_a,
 
 void test_arena_not_shared(Tree const& a, Tree const& b)
 {
-    for(NodeData *n = a.m_buf, *e = a.m_buf + a.m_cap; n != e; ++n)
+    for(size_t i = 0; i < a.m_cap; ++i)
     {
-        EXPECT_FALSE(b.in_arena(n->m_key.scalar)) << n - a.m_buf;
-        EXPECT_FALSE(b.in_arena(n->m_key.tag   )) << n - a.m_buf;
-        EXPECT_FALSE(b.in_arena(n->m_key.anchor)) << n - a.m_buf;
-        EXPECT_FALSE(b.in_arena(n->m_val.scalar)) << n - a.m_buf;
-        EXPECT_FALSE(b.in_arena(n->m_val.tag   )) << n - a.m_buf;
-        EXPECT_FALSE(b.in_arena(n->m_val.anchor)) << n - a.m_buf;
+        EXPECT_FALSE(b.in_arena(a.m_keys[i])) << i;
+        EXPECT_FALSE(b.in_arena(a.m_vals[i])) << i;
     }
-    for(NodeData *n = b.m_buf, *e = b.m_buf + b.m_cap; n != e; ++n)
+    for(NodeProperties *p = a.m_props, *e = a.m_props + a.m_props_size; p != e; ++p)
     {
-        EXPECT_FALSE(a.in_arena(n->m_key.scalar)) << n - b.m_buf;
-        EXPECT_FALSE(a.in_arena(n->m_key.tag   )) << n - b.m_buf;
-        EXPECT_FALSE(a.in_arena(n->m_key.anchor)) << n - b.m_buf;
-        EXPECT_FALSE(a.in_arena(n->m_val.scalar)) << n - b.m_buf;
-        EXPECT_FALSE(a.in_arena(n->m_val.tag   )) << n - b.m_buf;
-        EXPECT_FALSE(a.in_arena(n->m_val.anchor)) << n - b.m_buf;
+        EXPECT_FALSE(b.in_arena(p->m_key_tag   )) << p->m_node;
+        EXPECT_FALSE(b.in_arena(p->m_key_anchor)) << p->m_node;
+        EXPECT_FALSE(b.in_arena(p->m_val_tag   )) << p->m_node;
+        EXPECT_FALSE(b.in_arena(p->m_val_anchor)) << p->m_node;
+    }
+    for(size_t i = 0; i < b.m_cap; ++i)
+    {
+        EXPECT_FALSE(a.in_arena(b.m_keys[i])) << i;
+        EXPECT_FALSE(a.in_arena(b.m_vals[i])) << i;
+    }
+    for(NodeProperties *p = b.m_props, *e = b.m_props + b.m_props_size; p != e; ++p)
+    {
+        EXPECT_FALSE(a.in_arena(p->m_key_tag   )) << p->m_node;
+        EXPECT_FALSE(a.in_arena(p->m_key_anchor)) << p->m_node;
+        EXPECT_FALSE(a.in_arena(p->m_val_tag   )) << p->m_node;
+        EXPECT_FALSE(a.in_arena(p->m_val_anchor)) << p->m_node;
     }
 }
 
@@ -337,7 +343,7 @@ void CaseNode::compare_child(yml::NodeRef const& n, size_t pos) const
     if(type & SEQ)
     {
         EXPECT_FALSE(n[pos].has_key());
-        EXPECT_EQ(n[pos].get()->m_key.scalar, children[pos].key);
+        EXPECT_EQ(n.tree()->_key(n[pos].id()), children[pos].key);
         auto fch = n.child(pos);
         EXPECT_EQ(fch.get(), n[pos].get());
     }
@@ -448,15 +454,19 @@ void CaseNode::recreate(yml::NodeRef *n) const
 {
     C4_ASSERT( ! n->has_children());
     auto *nd = n->get();
-    nd->m_type = type|key_anchor.type|val_anchor.type;
-    nd->m_key.scalar = key;
-    nd->m_key.tag = (key_tag);
-    nd->m_key.anchor = key_anchor.str;
-    nd->m_val.scalar = val;
-    nd->m_val.tag = (val_tag);
-    nd->m_val.anchor = val_anchor.str;
     auto &tree = *n->tree();
     size_t nid = n->id(); // don't use node from now on
+    nd->m_type = type|key_anchor.type|val_anchor.type;
+    tree._key(nid) = key;
+    tree._val(nid) = val;
+    if(nd->m_type & (KEYTAG|VALTAG|KEYANCH|VALANCH|KEYREF|VALREF))
+    {
+        NodeProperties *p = tree._props_add(nid);
+        p->m_key_tag = key_tag;
+        p->m_key_anchor = key_anchor.str;
+        p->m_val_tag = val_tag;
+        p->m_val_anchor = val_anchor.str;
+    }
     for(auto const& ch : children)
     {
         size_t id = tree.append_child(nid);
@@ -0,0 +1,173 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/doc_reader.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+/** a readable dump of the contents of a document, regardless of
+ * whether it is a DOC node in a stream or the root of the tree */
+void _doc_events(Tree const& t, size_t node, std::string *events)
+{
+    auto add = [events](const char *ev, csubstr s){
+        *events += ev;
+        *events += '(';
+        events->append(s.str, s.len);
+        *events += ") ";
+    };
+    if(t.has_key(node))
+    {
+        if(t.has_key_anchor(node))
+            add("ANCH", t.key_anchor(node));
+        if(t.has_key_tag(node))
+            add("TAG", t.key_tag(node));
+        if(t.is_key_ref(node))
+            add("REF", t.key_ref(node));
+        else
+            add("KEY", t.key(node));
+    }
+    if(t.has_val_anchor(node))
+        add("ANCH", t.val_anchor(node));
+    if(t.has_val_tag(node))
+        add("TAG", t.val_tag(node));
+    if(t.is_map(node))
+        *events += "+MAP ";
+    else if(t.is_seq(node))
+        *events += "+SEQ ";
+    else if(t.is_val_ref(node))
+        add("REF", t.val_ref(node));
+    else if(t.has_val(node))
+        add("VAL", t.val(node));
+    for(size_t ch = t.first_child(node); ch != NONE; ch = t.next_sibling(ch))
+        _doc_events(t, ch, events);
+    if(t.is_map(node))
+        *events += "-MAP ";
+    else if(t.is_seq(node))
+        *events += "-SEQ ";
+}
+
+std::string doc_events(Tree const& t, size_t node)
+{
+    std::string events;
+    _doc_events(t, node, &events);
+    return events;
+}
+
+void check_same_as_tree(csubstr src, size_t num_docs)
+{
+    SCOPED_TRACE(src);
+    Tree full = parse(src);
+    std::vector<size_t> docs;
+    if(full.rootref().is_stream())
+        for(size_t ch = full.first_child(full.root_id()); ch != NONE; ch = full.next_sibling(ch))
+            docs.push_back(ch);
+    else
+        docs.push_back(full.root_id());
+    ASSERT_EQ(docs.size(), num_docs);
+    DocReader reader(src);
+    ASSERT_EQ(reader.num_docs(), num_docs);
+    // in order
+    for(size_t i = 0; i < num_docs; ++i)
+    {
+        SCOPED_TRACE(i);
+        ASSERT_TRUE(reader.next());
+        EXPECT_EQ(reader.index(), i);
+        EXPECT_EQ(doc_events(reader.tree(), reader.doc().id()), doc_events(full, docs[i]));
+    }
+    EXPECT_FALSE(reader.next());
+    // in reverse
+    for(size_t i = num_docs; i > 0; --i)
+    {
+        SCOPED_TRACE(i - 1);
+        NodeRef doc = reader.read(i - 1);
+        EXPECT_EQ(doc_events(reader.tree(), doc.id()), doc_events(full, docs[i - 1]));
+    }
+}
+
+TEST(doc_reader, docs)
+{
+    check_same_as_tree("a: 1\nb: 2\n", 1);
+    check_same_as_tree("---\na: 1\n", 1);
+    check_same_as_tree("--- a\n--- b\n---\n- c\n", 3);
+    check_same_as_tree("a: 1\n---\nb: 2\n", 2);
+    check_same_as_tree(R"(# comment
+%YAML 1.2
+--- &x !!map
+a: |
+  literal with
+  --- inside
+b: "quoted --- also"
+...
+%YAML 1.2
+---
+- *x
+--- !!str
+scalar
+...
+# trailing comment
+)", 3);
+}
+
+TEST(doc_reader, offsets)
+{
+    csubstr src = "# preamble\n---\na: 0\n--- b\n...\n---\n[c]\n";
+    DocReader reader(src);
+    ASSERT_EQ(reader.num_docs(), 3u);
+    EXPECT_EQ(reader.doc_src(0), "# preamble\n---\na: 0\n");
+    EXPECT_EQ(reader.doc_src(1), "--- b\n...\n");
+    EXPECT_EQ(reader.doc_src(2), "---\n[c]\n");
+    EXPECT_EQ(reader.doc_offset(0), 0u);
+    EXPECT_EQ(reader.doc_offset(1), 20u);
+    EXPECT_EQ(reader.doc_offset(2), 30u);
+    EXPECT_EQ(reader.read(2)[0].val(), "c");
+    EXPECT_EQ(reader.read(0)["a"].val(), "0");
+    EXPECT_EQ(reader.read(1).val(), "b");
+}
+
+TEST(doc_reader, empty)
+{
+    for(csubstr src : {csubstr(""), csubstr("# only comments\n\n"), csubstr("%YAML 1.2\n")})
+    {
+        SCOPED_TRACE(src);
+        DocReader reader(src);
+        EXPECT_EQ(reader.num_docs(), 0u);
+        EXPECT_FALSE(reader.next());
+    }
+}
+
+TEST(doc_reader, reuse)
+{
+    std::string src;
+    for(size_t i = 0; i < 500; ++i)
+        src += "---\nname: doc" + std::to_string(1000 + i) + "\nitems: [1, 2, 3]\n";
+    DocReader reader(to_csubstr(src));
+    ASSERT_EQ(reader.num_docs(), 500u);
+    size_t count = 0, cap = 0, arena_cap = 0;
+    for(NodeRef doc : reader)
+    {
+        ASSERT_EQ(doc["name"].val(), to_csubstr("doc" + std::to_string(1000 + count)));
+        if(count == 0)
+        {
+            cap = reader.tree().capacity();
+            arena_cap = reader.tree().arena_capacity();
+        }
+        ASSERT_EQ(reader.tree().capacity(), cap);
+        ASSERT_EQ(reader.tree().arena_capacity(), arena_cap);
+        ++count;
+    }
+    EXPECT_EQ(count, 500u);
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
@@ -26,7 +26,10 @@ namespace yml {
             "dquoted, 3 dquotes",                       \
             "dquoted, 4 dquotes",                       \
             "dquoted, example 2",                       \
-            "dquoted, example 2.1"
+            "dquoted, example 2.1",                     \
+            "dquoted, long with escapes",               \
+            "dquoted, long with folded lines",          \
+            "dquoted, long with backslash runs"
 
 CASE_GROUP(DOUBLE_QUOTED)
 {
@@ -192,6 +195,28 @@ that has multiple lines
 )",
   L{N(QK, "This is a key\nthat has multiple lines\n", "and this is its value")}
 ),
+
+C("dquoted, long with escapes",
+R"("0123456789abcdef0123456789abcdef \"quoted\" 0123456789abcdef0123456789\\0123456789abcdef\/0123456789abcdef0123456789\tabcdef0123456789abcdef\n")",
+  N(DOCVAL|VALQUO, "0123456789abcdef0123456789abcdef \"quoted\" 0123456789abcdef0123456789\\0123456789abcdef/0123456789abcdef0123456789\tabcdef0123456789abcdef\n")
+),
+
+C("dquoted, long with folded lines",
+R"(key: "a long line, a long line, a long line, a long line, a long line   
+  continued after a fold, continued after a fold, continued after a fold
+
+  and after an empty line, and after an empty line, and after an empty line"
+)",
+  L{N(KEYVAL|VALQUO, "key", "a long line, a long line, a long line, a long line, a long line continued after a fold, continued after a fold, continued after a fold\nand after an empty line, and after an empty line, and after an empty line")}
+),
+
+C("dquoted, long with backslash runs",
+R"(a: "0123456789abcdef0123456789abcd\\\"0123456789abcdef0123456789a\\\\"
+b: "0123456789abcdef0123456789abcdef0123456789abcdef\\\\\\\\0123456789abcdef\\\"0123456789"
+)",
+  L{N(KEYVAL|VALQUO, "a", "0123456789abcdef0123456789abcd\\\"0123456789abcdef0123456789a\\\\"),
+    N(KEYVAL|VALQUO, "b", "0123456789abcdef0123456789abcdef0123456789abcdef\\\\\\\\0123456789abcdef\\\"0123456789")}
+),
     )
 }
 
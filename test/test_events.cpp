@@ -0,0 +1,102 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/event_handler.hpp"
+#include <gtest/gtest.h>
+
+namespace c4 {
+namespace yml {
+
+/** records the events in a readable string */
+struct EventRecorder : public EventHandler
+{
+    std::string events;
+
+    void _add(const char *ev) { events += ev; events += ' '; }
+    void _add(const char *ev, csubstr s, bool quoted)
+    {
+        events += ev;
+        events += '(';
+        if(quoted)
+            events += '"';
+        if(s.str == nullptr)
+            events += "~";
+        else
+            events.append(s.str, s.len);
+        if(quoted)
+            events += '"';
+        events += ") ";
+    }
+
+    void begin_doc() override { _add("+DOC"); }
+    void end_doc() override { _add("-DOC"); }
+    void begin_map() override { _add("+MAP"); }
+    void end_map() override { _add("-MAP"); }
+    void begin_seq() override { _add("+SEQ"); }
+    void end_seq() override { _add("-SEQ"); }
+    void key(csubstr k, bool quoted) override { _add("KEY", k, quoted); }
+    void scalar(csubstr s, bool quoted) override { _add("VAL", s, quoted); }
+};
+
+std::string json_events(csubstr json)
+{
+    std::string buf(json.str, json.len);
+    EventRecorder rec;
+    parse_json(to_substr(buf), &rec);
+    return rec.events;
+}
+
+/** the events expected from the tree of a JSON document */
+void _tree_events(Tree const& t, size_t node, EventRecorder *rec)
+{
+    if(t.has_key(node))
+        rec->key(t.key(node), t.is_key_quoted(node));
+    if(t.is_map(node))
+        rec->begin_map();
+    else if(t.is_seq(node))
+        rec->begin_seq();
+    else
+        rec->scalar(t.val(node), t.is_val_quoted(node));
+    for(size_t ch = t.first_child(node); ch != NONE; ch = t.next_sibling(ch))
+        _tree_events(t, ch, rec);
+    if(t.is_map(node))
+        rec->end_map();
+    else if(t.is_seq(node))
+        rec->end_seq();
+}
+
+std::string tree_events(Tree const& t)
+{
+    EventRecorder rec;
+    rec.begin_doc();
+    _tree_events(t, t.root_id(), &rec);
+    rec.end_doc();
+    return rec.events;
+}
+
+TEST(events, json)
+{
+    EXPECT_EQ(json_events(R"({"a": 1, "b": [true, null, "x\ty"], "c": {}})"),
+              R"(+DOC +MAP KEY("a") VAL(1) KEY("b") +SEQ VAL(true) VAL(~) VAL("x	y") -SEQ KEY("c") +MAP -MAP -MAP -DOC )");
+    EXPECT_EQ(json_events(R"([[], [[1]]])"),
+              R"(+DOC +SEQ +SEQ -SEQ +SEQ +SEQ VAL(1) -SEQ -SEQ -SEQ -DOC )");
+    EXPECT_EQ(json_events(R"("scalar")"), R"(+DOC VAL("scalar") -DOC )");
+    EXPECT_EQ(json_events(R"(-1.5)"), R"(+DOC VAL(-1.5) -DOC )");
+}
+
+TEST(events, json_same_as_tree)
+{
+    csubstr cases[] = {
+        R"({"a": 1, "b": [true, null, "x"], "c": {"d": {"e": []}}})",
+        R"([{"a": "b"}, [1, 2, 3], "end"])",
+        R"("scalar")",
+    };
+    for(csubstr json : cases)
+    {
+        SCOPED_TRACE(json);
+        Tree t = parse_json(json);
+        EXPECT_EQ(tree_events(t), json_events(json));
+    }
+}
+
+} // namespace yml
+} // namespace c4
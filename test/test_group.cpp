@@ -347,6 +347,42 @@ void YmlTestCase::_test_recreate_from_ref(CaseDataLineEndings *cd)
     }
 }
 
+//-----------------------------------------------------------------------------
+void YmlTestCase::_test_parse_lazy_using_ryml(csubstr line_ending)
+{
+    if(c->flags & EXPECT_PARSE_ERROR)
+        return;
+
+    // make a fresh copy of the source, as the case data was already
+    // filtered in place by the other parse tests
+    std::string unix_src, src;
+    replace_all("\r", "", c->src, &unix_src);
+    replace_all("\n", line_ending, to_csubstr(unix_src), &src);
+    Tree t;
+    Parser p;
+    p.set_lazy_filtering(true);
+    p.parse(c->name, to_substr(src), &t);
+    #ifdef RYML_NFO
+    std::cout << "LAZY PARSED TREE:\n";
+    print_tree(t);
+    #endif
+    if(c->flags & RESOLVE_REFS)
+        t.resolve();
+    {
+        SCOPED_TRACE("checking tree invariants of lazy parsed tree");
+        test_invariants(t);
+    }
+    {
+        SCOPED_TRACE("comparing lazy parsed tree to ref tree");
+        EXPECT_EQ(t.size(), c->root.reccount());
+        c->root.compare(t.rootref());
+    }
+    for(size_t i = 0; i < t.capacity(); ++i)
+    {
+        EXPECT_FALSE(t.is_val_raw(i)) << "node " << i;
+    }
+}
+
 //-----------------------------------------------------------------------------
 TEST_P(YmlTestCase, parse_unix_using_ryml)
 {
@@ -360,6 +396,19 @@ TEST_P(YmlTestCase, parse_windows_using_ryml)
     _test_parse_using_ryml(&d->windows_style);
 }
 
+//-----------------------------------------------------------------------------
+TEST_P(YmlTestCase, parse_unix_lazy_using_ryml)
+{
+    SCOPED_TRACE("unix style");
+    _test_parse_lazy_using_ryml("\n");
+}
+
+TEST_P(YmlTestCase, parse_windows_lazy_using_ryml)
+{
+    SCOPED_TRACE("windows style");
+    _test_parse_lazy_using_ryml("\r\n");
+}
+
 //-----------------------------------------------------------------------------
 TEST_P(YmlTestCase, emit_yml_unix_stdout)
 {
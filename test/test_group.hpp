@@ -47,6 +47,7 @@ struct YmlTestCase : public ::testing::TestWithParam<const char*>
     }
 
     void _test_parse_using_ryml(CaseDataLineEndings *cd);
+    void _test_parse_lazy_using_ryml(csubstr line_ending);
     void _test_emit_yml_stdout(CaseDataLineEndings *cd);
     void _test_emit_yml_cout(CaseDataLineEndings *cd);
     void _test_emit_yml_stringstream(CaseDataLineEndings *cd);
@@ -0,0 +1,169 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+csubstr lazy_src = R"(plain: multi
+  line
+squo: 'it''s'
+dquo: "tab\tend"
+literal: |
+  line 1
+  line 2
+folded: >-
+  line 1
+  line 2
+"key\tquoted": simple
+seq:
+  - 'a''b'
+  - "c\nd"
+)";
+
+Tree parse_lazy(std::string *buf)
+{
+    buf->assign(lazy_src.begin(), lazy_src.end());
+    Tree t;
+    Parser p;
+    p.set_lazy_filtering(true);
+    p.parse({}, to_substr(*buf), &t);
+    return t;
+}
+
+size_t count_raw(Tree const& t)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < t.capacity(); ++i)
+        count += t.is_val_raw(i);
+    return count;
+}
+
+TEST(lazy_filtering, disabled_by_default)
+{
+    Parser p;
+    EXPECT_FALSE(p.lazy_filtering());
+    std::string buf(lazy_src.begin(), lazy_src.end());
+    Tree t = p.parse({}, to_substr(buf));
+    EXPECT_EQ(count_raw(t), 0u);
+}
+
+TEST(lazy_filtering, vals_are_raw_until_read)
+{
+    std::string buf;
+    Tree t = parse_lazy(&buf);
+    EXPECT_EQ(count_raw(t), 7u);
+    NodeRef r = t.rootref();
+    // keys are always filtered
+    EXPECT_FALSE(t.is_val_raw(r["key\tquoted"].id()));
+    EXPECT_EQ(r["key\tquoted"].val(), "simple");
+    size_t plain = r["plain"].id();
+    EXPECT_TRUE(t.is_val_raw(plain));
+    EXPECT_EQ(t.val(plain), "multi line");
+    EXPECT_FALSE(t.is_val_raw(plain));
+    EXPECT_EQ(count_raw(t), 6u);
+    EXPECT_EQ(r["squo"].val(), "it's");
+    EXPECT_EQ(r["dquo"].val(), "tab\tend");
+    EXPECT_EQ(r["literal"].val(), "line 1\nline 2\n");
+    EXPECT_EQ(r["folded"].val(), "line 1 line 2");
+    EXPECT_EQ(r["seq"][0].val(), "a'b");
+    EXPECT_EQ(r["seq"][1].val(), "c\nd");
+    EXPECT_EQ(count_raw(t), 0u);
+    // reading again gives the same
+    EXPECT_EQ(t.val(plain), "multi line");
+}
+
+TEST(lazy_filtering, same_tree_as_eager)
+{
+    std::string buf, eager_buf(lazy_src.begin(), lazy_src.end());
+    Tree lazy = parse_lazy(&buf);
+    Tree eager = parse(to_substr(eager_buf));
+    EXPECT_EQ(emitrs<std::string>(lazy), emitrs<std::string>(eager));
+}
+
+TEST(lazy_filtering, filter_raw)
+{
+    std::string buf;
+    Tree t = parse_lazy(&buf);
+    EXPECT_EQ(count_raw(t), 7u);
+    t.filter_raw();
+    EXPECT_EQ(count_raw(t), 0u);
+    EXPECT_EQ(t["dquo"].val(), "tab\tend");
+    EXPECT_EQ(t["seq"][1].val(), "c\nd");
+}
+
+TEST(lazy_filtering, set_val_clears_raw)
+{
+    std::string buf;
+    Tree t = parse_lazy(&buf);
+    size_t dquo = t["dquo"].id();
+    ASSERT_TRUE(t.is_val_raw(dquo));
+    t["dquo"] = "\"x\\ty";
+    EXPECT_FALSE(t.is_val_raw(dquo));
+    EXPECT_EQ(t.val(dquo), "\"x\\ty");
+}
+
+TEST(lazy_filtering, copies_do_not_share_raw_vals)
+{
+    std::string buf;
+    Tree t = parse_lazy(&buf);
+    // the source is not in the arena: the copy would share it
+    Tree copy = t;
+    EXPECT_EQ(count_raw(t), 0u);
+    EXPECT_EQ(count_raw(copy), 0u);
+    EXPECT_EQ(copy["squo"].val(), "it's");
+    EXPECT_EQ(t["squo"].val(), "it's");
+    // with the source in the arena, each tree has its own
+    Tree arena_tree;
+    Parser p;
+    p.set_lazy_filtering(true);
+    p.parse({}, lazy_src, &arena_tree);
+    Tree arena_copy = arena_tree;
+    EXPECT_EQ(count_raw(arena_tree), 7u);
+    EXPECT_EQ(count_raw(arena_copy), 7u);
+    EXPECT_EQ(arena_copy["literal"].val(), "line 1\nline 2\n");
+    EXPECT_EQ(count_raw(arena_tree), 7u);
+    EXPECT_EQ(arena_tree["literal"].val(), "line 1\nline 2\n");
+}
+
+TEST(lazy_filtering, duplicates_do_not_share_raw_vals)
+{
+    std::string buf;
+    Tree t = parse_lazy(&buf);
+    size_t seq = t["seq"].id();
+    size_t dup = t.duplicate(seq, t.root_id(), t.last_child(t.root_id()));
+    t._key(dup) = "dup";
+    EXPECT_FALSE(t.is_val_raw(t.child(seq, 0)));
+    EXPECT_FALSE(t.is_val_raw(t.child(dup, 0)));
+    EXPECT_EQ(t["seq"][0].val(), "a'b");
+    EXPECT_EQ(t["dup"][0].val(), "a'b");
+    EXPECT_EQ(t["seq"][1].val(), "c\nd");
+    EXPECT_EQ(t["dup"][1].val(), "c\nd");
+}
+
+TEST(lazy_filtering, anchors_are_resolved)
+{
+    std::string buf = "a: &anc \"x\\ty\"\nb: *anc\nc: &seq\n  - 'z''z'\nd: *seq\n";
+    Tree t;
+    Parser p;
+    p.set_lazy_filtering(true);
+    p.parse({}, to_substr(buf), &t);
+    t.resolve();
+    EXPECT_EQ(t["a"].val(), "x\ty");
+    EXPECT_EQ(t["b"].val(), "x\ty");
+    EXPECT_EQ(t["c"][0].val(), "z'z");
+    EXPECT_EQ(t["d"][0].val(), "z'z");
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
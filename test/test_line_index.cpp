@@ -0,0 +1,74 @@
+#include "c4/yml/std/string.hpp"
+#include "c4/yml/detail/line_index.hpp"
+#include <gtest/gtest.h>
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+void test_line_index(csubstr buf)
+{
+    SCOPED_TRACE(std::string(buf.str, buf.len));
+    LineIndex idx;
+    idx.build(buf);
+    size_t num = 0;
+    for(size_t i = 0; i < buf.len; ++i)
+        num += (buf[i] == '\n' || buf[i] == '\r');
+    EXPECT_EQ(idx.size(), num);
+    // forward lookups
+    for(size_t pos = 0; pos <= buf.len; ++pos)
+    {
+        size_t expected = buf.sub(pos).first_of("\r\n");
+        expected = expected == npos ? buf.len : pos + expected;
+        EXPECT_EQ(idx.next_newline(pos), expected) << "pos=" << pos;
+    }
+    // backward lookups
+    for(size_t pos = buf.len; pos != size_t(-1); --pos)
+    {
+        size_t expected = buf.sub(pos).first_of("\r\n");
+        expected = expected == npos ? buf.len : pos + expected;
+        EXPECT_EQ(idx.next_newline(pos), expected) << "pos=" << pos;
+    }
+    // indentation
+    for(size_t pos = 0; pos < buf.len; ++pos)
+    {
+        size_t e = idx.next_newline(pos);
+        if(e < buf.len) ++e;
+        EXPECT_EQ(idx.indentation(pos), buf.range(pos, e).first_not_of(' ')) << "pos=" << pos;
+    }
+}
+
+TEST(line_index, empty)
+{
+    test_line_index("");
+    test_line_index("\n");
+    test_line_index("\r\n");
+    test_line_index("   ");
+}
+
+TEST(line_index, short_lines)
+{
+    test_line_index("a: b\nc: d\n");
+    test_line_index("a: b\r\nc: d\r\n");
+    test_line_index("a:\n  b: c\n  d:\n    - e\n    - f\n");
+    test_line_index("a:\r\n  b: c\r\n\r\n  d:\r\n    - e\r\n    - f");
+}
+
+TEST(line_index, long_lines)
+{
+    // exercise the block-wise scan, including newlines at the block boundaries
+    std::string s;
+    for(size_t i = 0; i < 130; ++i)
+    {
+        s.append(i % 7, ' ');
+        s.append(i % 13, 'x');
+        s += (i % 5 == 0) ? "\r\n" : "\n";
+    }
+    test_line_index(to_csubstr(s));
+    s.append(40, ' ');
+    test_line_index(to_csubstr(s));
+}
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,130 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+csubstr loc_src = R"(a: 1
+b:
+  - x
+  - 'y z'
+c: {d: e, f: [g]}
+)";
+
+csubstr loc_src_crlf = "a: 1\r\nb:\r\n  - x\r\n  - 'y z'\r\nc: {d: e, f: [g]}\r\n";
+
+void check_loc(Location const& loc, size_t line, size_t col)
+{
+    EXPECT_EQ(loc.line, line);
+    EXPECT_EQ(loc.col, col);
+}
+
+void check_locations(Parser &p, Tree const& t)
+{
+    NodeRef r = t.rootref();
+    check_loc(p.val_location(r.id()), 1, 1);
+    check_loc(p.key_location(r["a"].id()), 1, 1);
+    check_loc(p.val_location(r["a"].id()), 1, 4);
+    check_loc(p.key_location(r["b"].id()), 2, 1);
+    check_loc(p.val_location(r["b"].id()), 3, 3);
+    check_loc(p.val_location(r["b"][0].id()), 3, 5);
+    check_loc(p.val_location(r["b"][1].id()), 4, 6); // after the quote
+    check_loc(p.key_location(r["c"].id()), 5, 1);
+    check_loc(p.val_location(r["c"].id()), 5, 4);
+    check_loc(p.key_location(r["c"]["d"].id()), 5, 5);
+    check_loc(p.val_location(r["c"]["d"].id()), 5, 8);
+    check_loc(p.key_location(r["c"]["f"].id()), 5, 11);
+    check_loc(p.val_location(r["c"]["f"][0].id()), 5, 15);
+    // seq members and the root have no key
+    check_loc(p.key_location(r["b"][0].id()), 0, 0);
+    check_loc(p.key_location(r.id()), 0, 0);
+}
+
+TEST(locations, disabled_by_default)
+{
+    Parser p;
+    EXPECT_FALSE(p.locations());
+    Tree t = p.parse("file.yml", loc_src);
+    Location loc = p.val_location(t["a"].id());
+    EXPECT_EQ(loc.line, 0u);
+    EXPECT_EQ(loc.col, 0u);
+    EXPECT_EQ(loc.name, "");
+}
+
+TEST(locations, block_and_flow)
+{
+    Parser p;
+    p.set_locations(true);
+    EXPECT_TRUE(p.locations());
+    Tree t = p.parse("file.yml", loc_src);
+    check_locations(p, t);
+    Location loc = p.val_location(t["a"].id());
+    EXPECT_EQ(loc.name, "file.yml");
+    EXPECT_EQ(loc.offset, 3u);
+    EXPECT_EQ(loc_src.sub(loc.offset).begins_with('1'), true);
+}
+
+TEST(locations, crlf)
+{
+    Parser p;
+    p.set_locations(true);
+    Tree t = p.parse("file.yml", loc_src_crlf);
+    check_locations(p, t);
+    Location loc = p.val_location(t["c"]["f"][0].id());
+    EXPECT_EQ(loc_src_crlf[loc.offset], 'g');
+}
+
+TEST(locations, offsets_point_at_the_source)
+{
+    std::string buf(loc_src.begin(), loc_src.end());
+    Parser p;
+    p.set_locations(true);
+    Tree t = p.parse("file.yml", to_substr(buf));
+    for(size_t i = 0; i < t.capacity(); ++i)
+    {
+        if(t.has_key(i))
+        {
+            EXPECT_EQ(to_csubstr(buf).sub(p.key_location(i).offset).begins_with(t.key(i)), true);
+        }
+        if(t.has_val(i))
+        {
+            EXPECT_EQ(to_csubstr(buf).sub(p.val_location(i).offset).begins_with(t.val(i)), true);
+        }
+    }
+}
+
+TEST(locations, reset_on_each_parse)
+{
+    Parser p;
+    p.set_locations(true);
+    Tree t = p.parse("file.yml", loc_src);
+    check_locations(p, t);
+    t = p.parse("other.yml", "\n\nz: 0");
+    check_loc(p.key_location(t["z"].id()), 3, 1);
+    check_loc(p.val_location(t["z"].id()), 3, 4);
+    EXPECT_EQ(p.val_location(t["z"].id()).name, "other.yml");
+    check_loc(p.val_location(t["z"].id() + 1), 0, 0);
+}
+
+TEST(locations, nodes_added_after_parsing)
+{
+    Parser p;
+    p.set_locations(true);
+    Tree t = p.parse("file.yml", loc_src);
+    size_t dup = t.duplicate(t["b"].id(), t.root_id(), t.last_child(t.root_id()));
+    check_loc(p.val_location(dup), 0, 0);
+    check_loc(p.key_location(dup), 0, 0);
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,215 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/parallel.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+/** the node ids may differ, as the serial parser moves the nodes of
+ * the first document when it finds the second */
+void check_same_node(Tree const& t, size_t n, Tree const& serial, size_t sn)
+{
+    EXPECT_EQ(t.type(n), serial.type(sn)) << "node " << sn;
+    EXPECT_EQ(t.has_key(n) ? t.key(n) : csubstr{}, serial.has_key(sn) ? serial.key(sn) : csubstr{});
+    EXPECT_EQ(t.has_val(n) ? t.val(n) : csubstr{}, serial.has_val(sn) ? serial.val(sn) : csubstr{});
+    ASSERT_EQ(t.num_children(n), serial.num_children(sn));
+    for(size_t ch = t.first_child(n), sch = serial.first_child(sn); ch != NONE; ch = t.next_sibling(ch), sch = serial.next_sibling(sch))
+        check_same_node(t, ch, serial, sch);
+}
+
+void check_same_as_serial(csubstr src, Tree (*parse_fn)(csubstr, size_t)=&parse_parallel)
+{
+    SCOPED_TRACE(src);
+    Tree serial = parse(src);
+    for(size_t num_threads : {1u, 2u, 3u, 8u})
+    {
+        SCOPED_TRACE(num_threads);
+        Tree t = parse_fn(src, num_threads);
+        EXPECT_EQ(emitrs<std::string>(t), emitrs<std::string>(serial));
+        // the source is copied to the arena only once, also when
+        // falling back to the serial parse
+        EXPECT_EQ(t.arena_size(), serial.arena_size());
+        ASSERT_EQ(t.size(), serial.size());
+        check_same_node(t, t.root_id(), serial, serial.root_id());
+    }
+}
+
+TEST(parse_parallel, docs)
+{
+    check_same_as_serial("a: 1\nb: [2, 3]\n");
+    check_same_as_serial("--- a\n--- b\n---\n- c\n");
+    check_same_as_serial("a: 1\n---\nb: 2\n");
+    check_same_as_serial(R"(# comment
+%YAML 1.2
+--- &x !!map
+a: |
+  literal with
+  --- inside
+b: "quoted --- also"
+...
+%YAML 1.2
+---
+- &y 1
+- *y
+--- !!str
+scalar
+...
+# trailing comment
+)");
+}
+
+TEST(parse_parallel, many_docs)
+{
+    std::string src;
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        std::string n = std::to_string(i);
+        src += "---\nname: doc" + n + "\nitems:\n  - " + n + "\n  - {a: &a" + n + " b, c: *a" + n + "}\n";
+    }
+    check_same_as_serial(to_csubstr(src));
+}
+
+TEST(parse_parallel, strings_are_in_the_arena)
+{
+    std::string src = "--- \"a\\tb\"\n--- c\n";
+    Tree t = parse_parallel(to_csubstr(src), 2u);
+    src.assign(src.size(), '#');
+    EXPECT_EQ(t[0].val(), "a\tb");
+    EXPECT_EQ(t[1].val(), "c");
+}
+
+TEST(parse_parallel, errors_are_located_in_the_whole_source)
+{
+    csubstr src = "--- a\n--- b\n---\na: 1\n  b: 2\n--- d\n";
+    Location loc = {};
+    loc.line = 5;
+    loc.col = 4;
+    ExpectError::do_check([&](){
+        Tree t = parse(src);
+    }, loc);
+    Tree t;
+    ExpectError::do_check([&](){
+        parse_parallel(src, &t, 2u);
+    }, loc);
+    // the serial parse reusing the copy of the source in the arena
+    EXPECT_EQ(t.arena_size(), src.len);
+}
+
+
+//-----------------------------------------------------------------------------
+
+void check_entries_same_as_serial(csubstr src)
+{
+    check_same_as_serial(src, &parse_parallel_entries);
+}
+
+TEST(parse_parallel_entries, map)
+{
+    std::string src = "# a big map\n%YAML 1.2\n---\n";
+    for(size_t i = 0; i < 200; ++i)
+    {
+        std::string n = std::to_string(i);
+        src += "key" + n + ":\n  name: &a" + n + " item" + n + "\n  ref: *a" + n + "\n  list:\n  - " + n + "\n  - [" + n + ", x]\n"
+               "  text: |\n    some text\n    \"with quotes [\n\n# comment {\n\"quoted" + n + "\": 'it''s'\nlist" + n + ":\n- a\n- b\n";
+    }
+    check_entries_same_as_serial(to_csubstr(src));
+    check_entries_same_as_serial(to_csubstr(src.substr(src.find("---\n") + 4)));
+}
+
+TEST(parse_parallel_entries, seq)
+{
+    std::string src;
+    for(size_t i = 0; i < 200; ++i)
+    {
+        std::string n = std::to_string(i);
+        src += "- name: item" + n + "\n  vals: {a: " + n + ", b: [1, 2]}\n- - " + n + "\n  - >-\n    folded\n    'text\n- \"" + n + "\"\n";
+    }
+    check_entries_same_as_serial(to_csubstr(src));
+    check_entries_same_as_serial(to_csubstr("---\n" + src));
+}
+
+TEST(parse_parallel_entries, aliases_across_entries)
+{
+    std::string src = "base: &base {a: 1, b: 2}\n";
+    for(size_t i = 0; i < 100; ++i)
+        src += "derived" + std::to_string(i) + ":\n  <<: *base\n  c: " + std::to_string(i) + "\n";
+    check_entries_same_as_serial(to_csubstr(src));
+    Tree t = parse_parallel_entries(to_csubstr(src), 4u);
+    t.resolve();
+    EXPECT_EQ(t["derived99"]["a"].val(), "1");
+    EXPECT_EQ(t["derived99"]["c"].val(), "99");
+}
+
+TEST(parse_parallel_entries, unsafe_splits_are_parsed_serially)
+{
+    std::string repeat;
+    for(size_t i = 0; i < 50; ++i)
+        repeat += "k" + std::to_string(i) + ": v\n";
+    // lines at column 0 inside flow containers and quoted scalars
+    check_entries_same_as_serial(to_csubstr(repeat + "a: [1,\nb: 2]\n" + repeat));
+    check_entries_same_as_serial(to_csubstr(repeat + "a: {x: 1,\nb: 2}\n" + repeat));
+    check_entries_same_as_serial(to_csubstr(repeat + "a: \"x\nb: 2\"\n" + repeat));
+    check_entries_same_as_serial(to_csubstr(repeat + "a: 'x\nb: 2'\n" + repeat));
+    // not a block collection at column 0
+    check_entries_same_as_serial(to_csubstr("--- !!map\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("--- &anchor\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("? complex\n: key\n" + repeat));
+    // properties of the root collection, on their own line or at the
+    // start of the first entry
+    check_entries_same_as_serial(to_csubstr("!!map\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("!mytag\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("&anchor\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("!mytag &anchor\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("&anchor k: v\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("!!str k: v\n" + repeat));
+    check_entries_same_as_serial(to_csubstr("!!seq\n- a\n- b\n- c\n"));
+    check_entries_same_as_serial(to_csubstr(repeat + "!!str\n" + repeat));
+    {
+        Tree t = parse_parallel_entries(to_csubstr("!!map\n" + repeat), 4u);
+        EXPECT_TRUE(t.rootref().has_val_tag());
+        EXPECT_EQ(t.rootref().val_tag(), "!!map");
+    }
+    check_entries_same_as_serial(to_csubstr("[a,\nb, c]\n"));
+    check_entries_same_as_serial(to_csubstr("  a: 1\n  b: 2\n"));
+    check_entries_same_as_serial(to_csubstr("plain scalar\n"));
+    check_entries_same_as_serial(to_csubstr(repeat + "...\n"));
+    check_entries_same_as_serial("");
+    // streams are split at the documents
+    check_entries_same_as_serial(to_csubstr(repeat + "---\n" + repeat));
+}
+
+TEST(parse_parallel_entries, errors_are_located_in_the_whole_source)
+{
+    std::string src;
+    for(size_t i = 0; i < 50; ++i)
+        src += "k" + std::to_string(i) + ": v\n";
+    src += "a: 1\n  b: 2\n";
+    for(size_t i = 0; i < 50; ++i)
+        src += "m" + std::to_string(i) + ": v\n";
+    Location loc = {};
+    loc.line = 52;
+    loc.col = 4;
+    ExpectError::do_check([&](){
+        Tree t = parse(to_csubstr(src));
+    }, loc);
+    Tree t;
+    ExpectError::do_check([&](){
+        parse_parallel_entries(to_csubstr(src), &t, 4u);
+    }, loc);
+    // the serial parse reusing the copy of the source in the arena
+    EXPECT_EQ(t.arena_size(), src.size());
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
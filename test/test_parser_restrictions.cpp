@@ -0,0 +1,150 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+constexpr const size_t restricted_yaml = NO_ANCHORS|NO_TAGS|NO_COMPLEX_KEYS|NO_DIRECTIVES;
+
+csubstr plain_src = R"(name: svc
+labels: {app: web, tier: "backend"}
+ports:
+  - port: 80
+    targetPort: 'http'
+  - [443, https]
+script: |
+  echo "a: b"
+  echo '*'
+notes: >-
+  a &b !c
+  ?d %e
+---
+- x
+- y
+)";
+
+std::string parse_restricted(csubstr src)
+{
+    Parser p;
+    p.set_restrictions(restricted_yaml);
+    Tree t = p.parse({}, src);
+    return emitrs<std::string>(t);
+}
+
+void expect_restricted_error(csubstr src, csubstr feature)
+{
+    SCOPED_TRACE(src);
+    ExpectError context;
+    bool got_error = false;
+    try
+    {
+        parse_restricted(src);
+    }
+    catch(std::runtime_error const& e)
+    {
+        got_error = true;
+        EXPECT_NE(to_csubstr(e.what()).find(feature), npos) << e.what();
+        EXPECT_NE(to_csubstr(e.what()).find("disabled"), npos) << e.what();
+    }
+    EXPECT_TRUE(got_error);
+}
+
+TEST(parser_restrictions, mask)
+{
+    Parser p;
+    EXPECT_EQ(p.restrictions(), 0u);
+    p.set_restrictions(NO_TAGS);
+    EXPECT_EQ(p.restrictions(), (size_t)NO_TAGS);
+    p.set_restrictions(NO_ANCHORS|NO_COMPLEX_KEYS);
+    EXPECT_EQ(p.restrictions(), (size_t)(NO_ANCHORS|NO_COMPLEX_KEYS));
+    p.set_restrictions(restricted_yaml);
+    EXPECT_EQ(p.restrictions(), restricted_yaml);
+    p.set_restrictions(0);
+    EXPECT_EQ(p.restrictions(), 0u);
+}
+
+TEST(parser_restrictions, same_tree_as_general_parser)
+{
+    Tree t = parse(plain_src);
+    EXPECT_EQ(parse_restricted(plain_src), emitrs<std::string>(t));
+}
+
+TEST(parser_restrictions, anchors_and_references_are_rejected)
+{
+    expect_restricted_error("a: &a 1\n", "anchors");
+    expect_restricted_error("&a a: 1\n", "anchors");
+    expect_restricted_error("- &a 1\n", "anchors");
+    expect_restricted_error("a: &a\n  b: 1\n", "anchors");
+    expect_restricted_error("[&a 1]\n", "anchors");
+    expect_restricted_error("a: *a\n", "references");
+    expect_restricted_error("- *a\n", "references");
+    expect_restricted_error("{a: *a}\n", "references");
+    expect_restricted_error("*a : 1\n", "references");
+    expect_restricted_error("a: {b: 1}\nc:\n  <<: {d: 1}\n", "references");
+    // quoted, they are not references
+    Parser p;
+    p.set_restrictions(NO_ANCHORS);
+    Tree t = p.parse({}, "a: '*a'\n\"<<\": \"&b\"\n");
+    EXPECT_EQ(t["a"].val(), "*a");
+    EXPECT_EQ(t["<<"].val(), "&b");
+    EXPECT_FALSE(t["a"].is_val_ref());
+}
+
+TEST(parser_restrictions, tags_are_rejected)
+{
+    expect_restricted_error("a: !!str 1\n", "tags");
+    expect_restricted_error("!!str a: 1\n", "tags");
+    expect_restricted_error("- !foo 1\n", "tags");
+    expect_restricted_error("--- !!set\n? a\n", "tags");
+    expect_restricted_error("[!!int 1]\n", "tags");
+    // but not in quoted scalars
+    Parser p;
+    p.set_restrictions(NO_TAGS);
+    Tree t = p.parse({}, "a: '!!str'\nb: \"!x\"\n");
+    EXPECT_EQ(t["a"].val(), "!!str");
+    EXPECT_EQ(t["b"].val(), "!x");
+    EXPECT_FALSE(t["a"].has_val_tag());
+}
+
+TEST(parser_restrictions, complex_keys_are_rejected)
+{
+    expect_restricted_error("? a\n: 1\n", "complex keys");
+    expect_restricted_error("a:\n  ? b\n  : 1\n", "complex keys");
+    expect_restricted_error("- ? a\n  : 1\n", "complex keys");
+    expect_restricted_error("{? a: 1}\n", "complex keys");
+}
+
+TEST(parser_restrictions, directives_are_rejected)
+{
+    expect_restricted_error("%YAML 1.2\n---\na: 1\n", "directives");
+    expect_restricted_error("%TAG ! tag:example.com,2000:\n---\na: 1\n", "directives");
+}
+
+TEST(parser_restrictions, restrictions_are_independent)
+{
+    // each restriction rejects only its own feature
+    Parser p;
+    p.set_restrictions(NO_TAGS|NO_COMPLEX_KEYS);
+    Tree t = p.parse({}, "a: &a 1\nb: *a\n");
+    EXPECT_EQ(t["a"].val_anchor(), "a");
+    EXPECT_TRUE(t["b"].is_val_ref());
+    p.set_restrictions(NO_ANCHORS);
+    t = p.parse({}, "a: !!str 1\n? b\n: 2\n");
+    EXPECT_EQ(t["a"].val_tag(), "!!str");
+    EXPECT_EQ(t["b"].val(), "2");
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
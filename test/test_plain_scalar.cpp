@@ -48,7 +48,8 @@ TEST(plain_scalar, issue153_map)
     "plain scalar, explicit, early end, map",                       \
     "plain scalar, multiple docs",                                  \
     "plain scalar, multiple docs, termination",                     \
-    "plain scalar, trailing whitespace"
+    "plain scalar, trailing whitespace",                            \
+    "plain scalar, long lines with tokens"
 
 
 CASE_GROUP(PLAIN_SCALAR)
@@ -593,7 +594,22 @@ foo
           N(DOCVAL, "foo"),
           N(DOCVAL, "foo"),
       })
-    )
+    ),
+
+C("plain scalar, long lines with tokens",
+R"(
+a key which is long enough to span several blocks: and its value, which is also quite long # with a comment
+another key: with a colon:in the middle of a long plain scalar # and a comment
+seq: [a long plain scalar in a flow sequence, another long one in the same flow sequence]
+map: {a long plain key in a flow map: a long plain value in the same flow map, k: v}
+)",
+  N(MAP, L{
+      N("a key which is long enough to span several blocks", "and its value, which is also quite long"),
+      N("another key", "with a colon:in the middle of a long plain scalar"),
+      N("seq", L{N("a long plain scalar in a flow sequence"), N("another long one in the same flow sequence")}),
+      N("map", L{N("a long plain key in a flow map", "a long plain value in the same flow map"), N("k", "v")}),
+  })
+)
     )
 
 }
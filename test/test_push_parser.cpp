@@ -0,0 +1,232 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/push_parser.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+/** records the events in a readable string */
+struct PushRecorder : public EventHandler
+{
+    std::string events;
+
+    void _add(const char *ev) { events += ev; events += ' '; }
+    void _add(const char *ev, csubstr s, bool quoted)
+    {
+        events += ev;
+        events += '(';
+        if(quoted)
+            events += '"';
+        if(s.str == nullptr)
+            events += "~";
+        else
+            events.append(s.str, s.len);
+        if(quoted)
+            events += '"';
+        events += ") ";
+    }
+
+    void begin_doc() override { _add("+DOC"); }
+    void end_doc() override { _add("-DOC"); }
+    void begin_map() override { _add("+MAP"); }
+    void end_map() override { _add("-MAP"); }
+    void begin_seq() override { _add("+SEQ"); }
+    void end_seq() override { _add("-SEQ"); }
+    void key(csubstr k, bool quoted) override { _add("KEY", k, quoted); }
+    void scalar(csubstr s, bool quoted) override { _add("VAL", s, quoted); }
+};
+
+csubstr push_cases[] = {
+    R"({"a": 1, "b": [true, null, "x\ty"], "c": {}, "d": []})",
+    R"([{"a": "b"}, [1, 2, [3, [-4.5e+10]]], "end", false])",
+    R"(  {"esc\"aped \\ key": "\u00e9\ud83d\ude00\/", "": "", "x": ""}  )",
+    "{\n  \"multi\": [\n    1,\n    2\n  ],\n  \"line\": \"s\"\n}\n",
+    R"("scalar")",
+    R"(12345.678)",
+    R"(null)",
+    R"([])",
+};
+
+std::string push_events(csubstr json, size_t chunk_size)
+{
+    PushRecorder rec;
+    JsonPushParser pp;
+    pp.begin(&rec);
+    for(size_t i = 0; i < json.len; i += chunk_size)
+        pp.feed(json.sub(i, chunk_size < json.len - i ? chunk_size : json.len - i));
+    pp.finish();
+    EXPECT_TRUE(pp.done());
+    EXPECT_EQ(pp.offset(), json.len);
+    return rec.events;
+}
+
+std::string pull_events(csubstr json)
+{
+    std::string buf(json.str, json.len);
+    PushRecorder rec;
+    parse_json(to_substr(buf), &rec);
+    return rec.events;
+}
+
+TEST(push_parser, events_in_any_chunk_size)
+{
+    for(csubstr json : push_cases)
+    {
+        SCOPED_TRACE(json);
+        std::string expected = pull_events(json);
+        for(size_t chunk_size : {1, 2, 3, 7, 64})
+        {
+            SCOPED_TRACE(chunk_size);
+            EXPECT_EQ(push_events(json, chunk_size), expected);
+        }
+    }
+}
+
+TEST(push_parser, tree_in_any_chunk_size)
+{
+    for(csubstr json : push_cases)
+    {
+        SCOPED_TRACE(json);
+        Tree expected = parse_json(json);
+        for(size_t chunk_size : {1, 2, 3, 7, 64})
+        {
+            SCOPED_TRACE(chunk_size);
+            Tree t;
+            {
+                // the chunks are transient: the tree must not point at them
+                std::string buf;
+                JsonPushParser pp;
+                pp.begin(&t);
+                for(size_t i = 0; i < json.len; i += chunk_size)
+                {
+                    buf.assign(json.str + i, chunk_size < json.len - i ? chunk_size : json.len - i);
+                    pp.feed(to_csubstr(buf));
+                    buf.assign(buf.size(), '#');
+                }
+                pp.finish();
+            }
+            EXPECT_EQ(emitrs_json<std::string>(t), emitrs_json<std::string>(expected));
+        }
+    }
+}
+
+TEST(push_parser, events_are_sent_early)
+{
+    PushRecorder rec;
+    JsonPushParser pp;
+    pp.begin(&rec);
+    pp.feed(R"({"a": [1, "b)");
+    EXPECT_EQ(rec.events, R"(+DOC +MAP KEY("a") +SEQ VAL(1) )");
+    pp.feed(R"(c"], "d)");
+    EXPECT_EQ(rec.events, R"(+DOC +MAP KEY("a") +SEQ VAL(1) VAL("bc") -SEQ )");
+    EXPECT_FALSE(pp.done());
+    pp.feed(R"(": 2})");
+    EXPECT_TRUE(pp.done());
+    pp.feed("\n");
+    pp.finish();
+    EXPECT_EQ(rec.events, R"(+DOC +MAP KEY("a") +SEQ VAL(1) VAL("bc") -SEQ KEY("d") VAL(2) -MAP -DOC )");
+}
+
+TEST(push_parser, into_existing_node)
+{
+    Tree t = parse_json(R"({"a": 0, "b": 1})");
+    JsonPushParser pp;
+    pp.begin(t["a"]);
+    pp.feed(R"([1, {"c)");
+    pp.feed(R"(": 2}])");
+    pp.finish();
+    EXPECT_EQ(emitrs_json<std::string>(t), emitrs_json<std::string>(parse_json(R"({"a": [1, {"c": 2}], "b": 1})")));
+}
+
+TEST(push_parser, reuse)
+{
+    JsonPushParser pp;
+    for(csubstr json : push_cases)
+    {
+        SCOPED_TRACE(json);
+        Tree t;
+        pp.begin(&t);
+        pp.feed(json);
+        pp.finish();
+        EXPECT_EQ(emitrs_json<std::string>(t), emitrs_json<std::string>(parse_json(json)));
+    }
+}
+
+TEST(push_parser, keys_are_copied_once)
+{
+    // the elements of a seq under a key must not copy the key again
+    std::string json = R"({"key": [)";
+    size_t arena_size = 3; // "key"
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        std::string n = std::to_string(i);
+        switch(i % 3)
+        {
+        case 0: json += n; break;
+        case 1: json += "[" + n + "]"; break;
+        case 2: json += R"({"a": )" + n + "}"; ++arena_size; break;
+        }
+        json += i + 1 < 1000 ? ", " : "]}";
+        arena_size += n.size();
+    }
+    Tree t;
+    JsonPushParser pp;
+    pp.begin(&t);
+    pp.feed(to_csubstr(json));
+    pp.finish();
+    EXPECT_EQ(t.arena_size(), arena_size);
+    EXPECT_EQ(emitrs_json<std::string>(t), emitrs_json<std::string>(parse_json(to_csubstr(json))));
+}
+
+TEST(push_parser, errors)
+{
+    auto err = [](csubstr json, size_t line, size_t col){
+        for(size_t chunk_size : {1, 3, 64})
+        {
+            SCOPED_TRACE(json);
+            SCOPED_TRACE(chunk_size);
+            Location loc = {};
+            loc.line = line;
+            loc.col = col;
+            ExpectError::do_check([json, chunk_size](){
+                PushRecorder rec;
+                JsonPushParser pp;
+                pp.begin(&rec);
+                for(size_t i = 0; i < json.len; i += chunk_size)
+                    pp.feed(json.sub(i, chunk_size < json.len - i ? chunk_size : json.len - i));
+                pp.finish();
+            }, loc);
+        }
+    };
+    // the same locations as Parser::parse_json()
+    err("", 1, 1);
+    err("  \n ", 2, 2);
+    err("[1,]", 1, 4);
+    err("[1 2]", 1, 4);
+    err("{\"a\" 1}", 1, 6);
+    err("{a: 1}", 1, 2);
+    err("[01]", 1, 2);
+    err("[1.]", 1, 2);
+    err("[tru]", 1, 2);
+    err("[\"abc]", 1, 2);
+    err("[\"\\x\"]", 1, 3);
+    err("[\"\\u12g4\"]", 1, 3);
+    err("{\"a\": [1}", 1, 9);
+    err("[1]\n x", 2, 2);
+    err("{\"a\":\n[1,\n 2", 3, 3);
+    err("[\"a\nb\"]", 1, 4);
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,557 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+/* Differential checks of the parser on random documents. Each
+ * document is generated as a model tree, rendered in block style, in
+ * flow style and (when it has no tags or anchors) as JSON, with
+ * random indentation, scalar styles, comments and whitespace. Every
+ * rendering must parse to the model; so must the emitted parsed tree,
+ * and the JSON must parse the same with parse() and parse_json().
+ * The generator is seeded, so a failure always reproduces. */
+
+//-----------------------------------------------------------------------------
+
+struct RNode
+{
+    enum Kind { VAL, MAP, SEQ } kind = VAL;
+    std::string key;
+    std::string val; //!< for a reference, the name of the anchor
+    std::string tag;
+    std::string anchor;
+    bool ref = false;
+    std::vector<RNode> children;
+};
+
+struct RScalar
+{
+    const char *str;
+    bool plain; //!< can be written plain in block and flow style (plain null and ~ are read as empty)
+};
+
+const RScalar s_scalars[] = {
+    {"a", true}, {"foo", true}, {"bar baz", true}, {"x-y", true},
+    {"3", true}, {"-7", true}, {"0.5", true}, {"1e3", true},
+    {"true", true}, {"null", false}, {"~", false}, {"a.b/c", true},
+    {"ütf8", true}, {"a:b", true}, {"a#b", true}, {"-a", true},
+    {"", false}, {" lead", false}, {"trail ", false}, {"a: b", false},
+    {"c #d", false}, {"[e]", false}, {"{f}", false}, {"g, h", false},
+    {"- i", false}, {"'j'", false}, {"\"k\"", false}, {"l\\m", false},
+    {"*n", false}, {"&o", false}, {"!p", false}, {"%q", false},
+    {"@r", false}, {"`s", false}, {"? t", false}, {"|u", false},
+    {">v", false}, {"#w", false}, {"---", false}, {"...", false},
+    {"x\ny", false}, {"x\n\ny\n", false}, {"tab\tin", false},
+};
+
+struct RandomDocs
+{
+    std::mt19937 rng;
+    bool json;
+    size_t num_anchors;
+    std::vector<std::string> anchors; //!< defined so far in the current doc
+
+    RandomDocs(unsigned seed) : rng(seed), json(), num_anchors(), anchors() {}
+
+    size_t rand(size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); }
+    bool chance(size_t percent) { return rand(100) < percent; }
+
+    RScalar const& scalar()
+    {
+        return s_scalars[rand(sizeof(s_scalars) / sizeof(s_scalars[0]))];
+    }
+
+    void props(RNode *n)
+    {
+        if(json)
+            return;
+        if(chance(10))
+        {
+            if(n->kind == RNode::VAL)
+                n->tag = chance(50) ? "!!str" : "!bar";
+            else
+                n->tag = chance(50) ? "!foo" : (n->kind == RNode::MAP ? "!!map" : "!!seq");
+        }
+        if(chance(10))
+            n->anchor = "a" + std::to_string(num_anchors++);
+    }
+
+    RNode node(size_t depth)
+    {
+        RNode n;
+        const size_t r = rand(100);
+        if(depth == 0 || r < 50)
+        {
+            n.kind = RNode::VAL;
+            if(!json && !anchors.empty() && chance(8))
+            {
+                n.ref = true;
+                n.val = anchors[rand(anchors.size())];
+                return n;
+            }
+            n.val = scalar().str;
+            props(&n);
+            if(!n.anchor.empty())
+                anchors.push_back(n.anchor);
+            return n;
+        }
+        n.kind = r < 75 ? RNode::MAP : RNode::SEQ;
+        props(&n);
+        const size_t num = rand(6);
+        for(size_t i = 0; i < num; ++i)
+        {
+            RNode ch = node(depth - 1);
+            if(n.kind == RNode::MAP)
+                ch.key = "k" + std::to_string(i) + (chance(20) ? " x" : "");
+            n.children.push_back(std::move(ch));
+        }
+        // anchors of containers are referenced only after the container
+        if(!n.anchor.empty())
+            anchors.push_back(n.anchor);
+        return n;
+    }
+
+    std::vector<RNode> docs()
+    {
+        std::vector<RNode> d;
+        const size_t num = 1 + rand(3);
+        for(size_t i = 0; i < num; ++i)
+        {
+            anchors.clear();
+            RNode n = node(1 + rand(4));
+            // the emitter writes an empty container document as an
+            // empty document
+            if(n.kind != RNode::VAL && n.children.empty())
+                n.children.push_back(node(0));
+            if(n.kind == RNode::MAP)
+                n.children[0].key = "k0";
+            // the parser drops the props of a block container written
+            // on the line of its document marker, and a tagged document
+            // scalar is read up to the end of the line (comments
+            // included) and emitted without quotes
+            n.tag.clear();
+            if(n.kind != RNode::VAL)
+                n.anchor.clear();
+            d.push_back(std::move(n));
+        }
+        return d;
+    }
+
+    std::string sq(std::string const& s)
+    {
+        std::string r = "'";
+        for(char c : s)
+            r += c == '\'' ? std::string("''") : std::string(1, c);
+        return r + "'";
+    }
+
+    std::string dq(std::string const& s)
+    {
+        std::string r = "\"";
+        for(char c : s)
+        {
+            switch(c)
+            {
+            case '"': r += "\\\""; break;
+            case '\\': r += "\\\\"; break;
+            case '\n': r += "\\n"; break;
+            case '\t': r += json || chance(50) ? "\\t" : "\t"; break;
+            default: r += c;
+            }
+        }
+        return r + "\"";
+    }
+
+    bool is_plain(std::string const& s)
+    {
+        for(RScalar const& sc : s_scalars)
+            if(s == sc.str)
+                return sc.plain;
+        return true; // keys
+    }
+
+    std::string quoted(std::string const& s)
+    {
+        if(s.find('\n') == std::string::npos && chance(50))
+            return sq(s);
+        return dq(s);
+    }
+
+    std::string scalar_str(std::string const& s)
+    {
+        if(is_plain(s) && chance(60))
+            return s;
+        return quoted(s);
+    }
+
+    std::string props_str(RNode const& n)
+    {
+        std::string r;
+        if(!n.anchor.empty() && !n.tag.empty() && chance(50))
+            r = n.tag + " &" + n.anchor + " ";
+        else
+        {
+            if(!n.anchor.empty())
+                r += "&" + n.anchor + " ";
+            if(!n.tag.empty())
+                r += n.tag + " ";
+        }
+        return r;
+    }
+
+    std::string comment()
+    {
+        return chance(5) ? std::string(" # comment") : std::string();
+    }
+
+    //! a val in block style, after "key:" or "-"; @p col is the
+    //! indentation of its container
+    void block_val(RNode const& n, size_t col, size_t step, std::string *out)
+    {
+        if(n.ref)
+        {
+            *out += " *" + n.val + comment() + "\n";
+            return;
+        }
+        if(n.kind == RNode::VAL)
+        {
+            *out += " " + props_str(n);
+            if(n.val.find('\n') != std::string::npos && chance(50))
+            {
+                // block literal
+                const bool keep = n.val.back() == '\n';
+                *out += keep ? "|" : "|-";
+                *out += comment() + "\n";
+                std::string ind(col + step, ' ');
+                size_t pos = 0;
+                std::string body = keep ? n.val.substr(0, n.val.size() - 1) : n.val;
+                while(pos <= body.size())
+                {
+                    size_t nl = body.find('\n', pos);
+                    if(nl == std::string::npos)
+                        nl = body.size();
+                    std::string line = body.substr(pos, nl - pos);
+                    *out += line.empty() ? std::string() : ind + line;
+                    *out += "\n";
+                    pos = nl + 1;
+                }
+                return;
+            }
+            *out += scalar_str(n.val) + comment() + "\n";
+            return;
+        }
+        if(n.children.empty())
+        {
+            *out += " " + props_str(n) + (n.kind == RNode::MAP ? "{}" : "[]") + comment() + "\n";
+            return;
+        }
+        std::string p = props_str(n);
+        if(!p.empty())
+        {
+            // the parser reads a comment after the props as a scalar
+            p.pop_back();
+            *out += " " + p + "\n";
+        }
+        else
+        {
+            *out += comment() + "\n";
+        }
+        block_container(n, col + step, step, out);
+    }
+
+    static bool compactable(RNode const& n)
+    {
+        return !n.ref && n.kind != RNode::VAL && !n.children.empty() && n.tag.empty() && n.anchor.empty();
+    }
+
+    //! the parser rejects a seq at the indentation of its key when one
+    //! of its containers starts on the line after its dash
+    static bool fits_key_indentation(RNode const& n)
+    {
+        if(n.ref || n.kind != RNode::SEQ || n.children.empty())
+            return false;
+        for(RNode const& ch : n.children)
+            if(!ch.ref && ch.kind != RNode::VAL && !ch.children.empty() && !compactable(ch))
+                return false;
+        return true;
+    }
+
+    void block_container(RNode const& n, size_t col, size_t step, std::string *out, bool compact=false)
+    {
+        std::string ind(col, ' ');
+        for(RNode const& ch : n.children)
+        {
+            if(&ch != &n.children[0] && chance(5))
+                *out += chance(50) ? "\n" : ind + "# line comment\n";
+            if(n.kind == RNode::MAP)
+            {
+                *out += ind + scalar_str(ch.key) + ":";
+                // a block seq may sit at the indentation of its key
+                if(fits_key_indentation(ch) && chance(30))
+                {
+                    std::string p = props_str(ch);
+                    if(!p.empty())
+                    {
+                        p.pop_back();
+                        *out += " " + p;
+                    }
+                    *out += "\n";
+                    block_container(ch, col, step, out, true);
+                }
+                else
+                {
+                    block_val(ch, col, step, out);
+                }
+            }
+            else
+            {
+                // a compact map or seq starts on the line of its dash
+                if(compactable(ch) && (compact || chance(40)))
+                {
+                    std::string sub;
+                    block_container(ch, col + 2, step, &sub);
+                    *out += ind + "- " + sub.substr(col + 2);
+                }
+                else
+                {
+                    *out += ind + "-";
+                    block_val(ch, col, step, out);
+                }
+            }
+        }
+    }
+
+    std::string block(std::vector<RNode> const& docs)
+    {
+        std::string out;
+        const size_t step = 1 + rand(4);
+        for(size_t i = 0; i < docs.size(); ++i)
+        {
+            RNode const& d = docs[i];
+            if(docs.size() == 1 && d.kind != RNode::VAL && chance(50))
+            {
+                block_container(d, 0, step, &out);
+                continue;
+            }
+            out += "---";
+            block_val(d, 0, step, &out);
+            if(chance(20))
+                out += "...\n";
+        }
+        return out;
+    }
+
+    void flow_val(RNode const& n, std::string *out)
+    {
+        if(n.ref)
+        {
+            *out += "*" + n.val;
+            return;
+        }
+        *out += props_str(n);
+        if(n.kind == RNode::VAL)
+        {
+            *out += json ? json_scalar(n.val) : scalar_str(n.val);
+            return;
+        }
+        *out += n.kind == RNode::MAP ? "{" : "[";
+        for(size_t i = 0; i < n.children.size(); ++i)
+        {
+            RNode const& ch = n.children[i];
+            if(i)
+                *out += chance(70) ? ", " : ",";
+            if(chance(10))
+                *out += " ";
+            if(n.kind == RNode::MAP)
+            {
+                *out += json ? dq(ch.key) : scalar_str(ch.key);
+                *out += chance(80) ? ": " : " : ";
+            }
+            flow_val(ch, out);
+        }
+        *out += n.kind == RNode::MAP ? "}" : "]";
+    }
+
+    std::string json_scalar(std::string const& s)
+    {
+        if(s == "3" || s == "-7" || s == "0.5" || s == "1e3" || s == "true")
+            return chance(50) ? s : dq(s);
+        return dq(s);
+    }
+
+    std::string flow(std::vector<RNode> const& docs)
+    {
+        std::string out;
+        for(RNode const& d : docs)
+        {
+            if(docs.size() > 1 || d.kind == RNode::VAL || chance(50))
+                out += "--- ";
+            flow_val(d, &out);
+            out += comment() + "\n";
+        }
+        return out;
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+
+void check_node(RNode const& n, Tree const& t, size_t id)
+{
+    if(n.ref)
+    {
+        ASSERT_TRUE(t.is_val_ref(id));
+        EXPECT_EQ(t.val(id), to_csubstr("*" + n.val));
+        return;
+    }
+    EXPECT_EQ(t.has_val_tag(id), !n.tag.empty());
+    if(t.has_val_tag(id))
+    {
+        EXPECT_EQ(t.val_tag(id), to_csubstr(n.tag));
+    }
+    EXPECT_EQ(t.has_val_anchor(id), !n.anchor.empty());
+    if(t.has_val_anchor(id))
+    {
+        EXPECT_EQ(t.val_anchor(id), to_csubstr(n.anchor));
+    }
+    switch(n.kind)
+    {
+    case RNode::VAL:
+        ASSERT_TRUE(t.has_val(id));
+        EXPECT_EQ(t.val(id), to_csubstr(n.val));
+        break;
+    case RNode::MAP:
+    case RNode::SEQ:
+    {
+        ASSERT_EQ(t.is_map(id), n.kind == RNode::MAP);
+        ASSERT_EQ(t.is_seq(id), n.kind == RNode::SEQ);
+        ASSERT_EQ(t.num_children(id), n.children.size());
+        size_t ch = t.first_child(id);
+        for(RNode const& rch : n.children)
+        {
+            if(n.kind == RNode::MAP)
+            {
+                ASSERT_TRUE(t.has_key(ch));
+                EXPECT_EQ(t.key(ch), to_csubstr(rch.key));
+            }
+            check_node(rch, t, ch);
+            if(::testing::Test::HasFatalFailure())
+                return;
+            ch = t.next_sibling(ch);
+        }
+        break;
+    }
+    }
+}
+
+void check_docs(std::vector<RNode> const& docs, Tree const& t)
+{
+    if(!t.is_stream(t.root_id()))
+    {
+        ASSERT_EQ(docs.size(), 1u);
+        check_node(docs[0], t, t.root_id());
+        return;
+    }
+    ASSERT_EQ(t.num_children(t.root_id()), docs.size());
+    size_t d = t.first_child(t.root_id());
+    for(RNode const& rd : docs)
+    {
+        ASSERT_TRUE(t.is_doc(d));
+        check_node(rd, t, d);
+        if(::testing::Test::HasFatalFailure())
+            return;
+        d = t.next_sibling(d);
+    }
+}
+
+/** parse @p src in the arena and in place, and emit and parse back
+ * the result; each must give the model */
+void check_yaml(std::vector<RNode> const& docs, std::string const& src)
+{
+    SCOPED_TRACE(src);
+    ExpectError context; // make parse errors throw, to report the source
+    try
+    {
+        Tree t = parse(to_csubstr(src));
+        check_docs(docs, t);
+        if(::testing::Test::HasFailure())
+            return;
+        std::string buf = src;
+        Tree tis = parse(to_substr(buf));
+        check_docs(docs, tis);
+        if(::testing::Test::HasFailure())
+            return;
+        std::string emitted = emitrs<std::string>(t);
+        SCOPED_TRACE(emitted);
+        Tree te = parse(to_csubstr(emitted));
+        check_docs(docs, te);
+    }
+    catch(std::runtime_error const& e)
+    {
+        ADD_FAILURE() << e.what();
+    }
+}
+
+constexpr const size_t num_random_docs = 3000;
+
+TEST(random_docs, block)
+{
+    RandomDocs g(1);
+    for(size_t i = 0; i < num_random_docs && !::testing::Test::HasFailure(); ++i)
+    {
+        SCOPED_TRACE(i);
+        std::vector<RNode> docs = g.docs();
+        check_yaml(docs, g.block(docs));
+    }
+}
+
+TEST(random_docs, flow)
+{
+    RandomDocs g(2);
+    for(size_t i = 0; i < num_random_docs && !::testing::Test::HasFailure(); ++i)
+    {
+        SCOPED_TRACE(i);
+        std::vector<RNode> docs = g.docs();
+        check_yaml(docs, g.flow(docs));
+    }
+}
+
+TEST(random_docs, json)
+{
+    RandomDocs g(3);
+    g.json = true;
+    for(size_t i = 0; i < num_random_docs && !::testing::Test::HasFailure(); ++i)
+    {
+        SCOPED_TRACE(i);
+        std::vector<RNode> docs;
+        docs.push_back(g.node(1 + g.rand(4)));
+        if(docs[0].kind == RNode::VAL)
+            continue;
+        std::string src;
+        g.flow_val(docs[0], &src);
+        SCOPED_TRACE(src);
+        check_yaml(docs, src);
+        Tree t = parse_json(to_csubstr(src));
+        check_docs(docs, t);
+    }
+}
+
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,177 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/seq_reader.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+/** check that the elements read one at a time are the same as those of
+ * the whole tree */
+void check_same_as_tree(csubstr src, size_t num_elems)
+{
+    SCOPED_TRACE(src);
+    Tree full = parse(src);
+    size_t seq = full.rootref().is_stream() ? full.first_child(full.root_id()) : full.root_id();
+    ASSERT_TRUE(full.is_seq(seq));
+    ASSERT_EQ(full.num_children(seq), num_elems);
+    SeqReader reader(src);
+    size_t i = 0;
+    for(size_t ch = full.first_child(seq); ch != NONE; ch = full.next_sibling(ch), ++i)
+    {
+        SCOPED_TRACE(i);
+        ASSERT_TRUE(reader.next());
+        EXPECT_EQ(reader.index(), i);
+        EXPECT_EQ(emitrs<std::string>(reader.tree(), reader.elem().id()), emitrs<std::string>(full, ch));
+    }
+    EXPECT_FALSE(reader.next());
+    EXPECT_FALSE(reader.next());
+}
+
+TEST(seq_reader, block)
+{
+    check_same_as_tree(R"(- a0: v0
+  &a1 a1: v1
+  &a2 a2: v2
+- a0: w0
+  *a1: w1
+  *a2: w2
+- &seq
+  a4: v4
+)", 3);
+    check_same_as_tree(R"(# a comment
+%YAML 1.2
+---
+- a
+-
+  - b
+  - c
+
+# a comment in between
+- |
+  literal
+  - not an element
+-   d: 1
+    e: [1, 2]
+-
+- last)", 6);
+    check_same_as_tree(R"(
+  - indented
+  - - nested
+    - seq
+  - {a: b}
+)", 3);
+}
+
+TEST(seq_reader, flow)
+{
+    check_same_as_tree(R"([a, [b, c], {d: e, f: [g]}, 'h, ]', "i\", ]", it's, ])", 6);
+    check_same_as_tree(R"(--- [1, 2, 3])", 3);
+    check_same_as_tree(R"(
+# json
+[
+  {"a": 1, "b": [true, null]}, # a comment
+  "x"  # another comment
+]
+# trailing comment
+)", 2);
+}
+
+TEST(seq_reader, empty)
+{
+    for(csubstr src : {csubstr(""), csubstr("# only comments\n\n"), csubstr("[]"), csubstr("--- [ ]  # empty")})
+    {
+        SCOPED_TRACE(src);
+        SeqReader reader(src);
+        EXPECT_FALSE(reader.next());
+    }
+}
+
+TEST(seq_reader, ends_at_first_doc)
+{
+    csubstr src = R"(- a
+- b
+---
+- c
+)";
+    SeqReader reader(src);
+    std::vector<std::string> elems;
+    for(NodeRef elem : reader)
+        elems.emplace_back(elem.val().str, elem.val().len);
+    EXPECT_EQ(elems, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST(seq_reader, memory_is_bounded)
+{
+    std::string yaml, json = "[";
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        std::string n = std::to_string(1000 + i);
+        yaml += "- name: item" + n + "\n  tags: [x, y, z]\n  value: " + n + "\n";
+        json += std::string(i ? "," : "") + "{\"name\": \"item" + n + "\", \"tags\": [\"x\", \"y\", \"z\"], \"value\": " + n + "}";
+    }
+    json += "]";
+    for(csubstr src : {to_csubstr(yaml), to_csubstr(json)})
+    {
+        SeqReader reader(src);
+        ASSERT_TRUE(reader.next());
+        const size_t cap = reader.tree().capacity();
+        const size_t arena_cap = reader.tree().arena_capacity();
+        size_t count = 1;
+        while(reader.next())
+        {
+            ASSERT_EQ(reader.elem()["value"].val(), to_csubstr(std::to_string(1000 + count)));
+            ASSERT_EQ(reader.tree().capacity(), cap);
+            ASSERT_EQ(reader.tree().arena_capacity(), arena_cap);
+            ++count;
+        }
+        EXPECT_EQ(count, 1000u);
+    }
+}
+
+TEST(seq_reader, source_is_not_modified)
+{
+    std::string src = R"(["a\tb", "c"])";
+    std::string orig = src;
+    SeqReader reader(to_csubstr(src));
+    ASSERT_TRUE(reader.next());
+    EXPECT_EQ(reader.elem().val(), "a\tb");
+    EXPECT_EQ(reader.elem_src(), R"("a\tb")");
+    EXPECT_EQ(src, orig);
+}
+
+TEST(seq_reader, errors)
+{
+    auto err = [](csubstr src, size_t line, size_t col){
+        SCOPED_TRACE(src);
+        Location loc = {};
+        loc.line = line;
+        loc.col = col;
+        ExpectError::do_check([src](){
+            SeqReader reader(src);
+            while(reader.next())
+                ;
+        }, loc);
+    };
+    err("a: b", 1, 1);
+    err("--- {a: b}", 1, 5);
+    err("- a\n- b\nc: d\n", 3, 1);
+    err("[a, b] c", 1, 8);
+    err("[a, b", 1, 5);
+    err("[a, , b]", 1, 5);
+    err("[a, 'b]", 1, 5);
+    err("[a}", 1, 3);
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
@@ -20,7 +20,8 @@ namespace yml {
             "squoted, 2 squotes",                       \
             "squoted, 3 squotes",                       \
             "squoted, 4 squotes",                       \
-            "squoted, 5 squotes"
+            "squoted, 5 squotes",                       \
+            "squoted, long with squote runs"
 
 CASE_GROUP(SINGLE_QUOTED)
 {
@@ -129,6 +130,14 @@ R"('''''''''''')",
   N(DOCVAL | VALQUO, "'''''")
 ),
 
+C("squoted, long with squote runs",
+R"(a: '0123456789abcdef0123456789abcde''''0123456789abcdef0123456789abcde'''
+b: '0123456789abcdef0123456789abcdef0123456789abcd'''''' "0123456789" ''x'
+)",
+  L{N(KEYVAL|VALQUO, "a", "0123456789abcdef0123456789abcde''0123456789abcdef0123456789abcde'"),
+    N(KEYVAL|VALQUO, "b", "0123456789abcdef0123456789abcdef0123456789abcd''' \"0123456789\" 'x")}
+),
+
 /*
 C("squoted, example 2",
 R"('This is a key
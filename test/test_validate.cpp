@@ -0,0 +1,138 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/validate.hpp"
+#include <gtest/gtest.h>
+
+#include "./test_case.hpp"
+
+namespace c4 {
+namespace yml {
+
+void check_stats(csubstr src, size_t num_nodes, size_t max_depth, size_t num_docs)
+{
+    SCOPED_TRACE(src);
+    ParseStats stats = validate(src);
+    EXPECT_EQ(stats.num_nodes, num_nodes);
+    EXPECT_EQ(stats.arena_size, src.len);
+    EXPECT_EQ(stats.max_depth, max_depth);
+    EXPECT_EQ(stats.num_docs, num_docs);
+    Tree t = parse(src);
+    EXPECT_EQ(t.size(), num_nodes);
+}
+
+void check_json_stats(csubstr src, size_t num_nodes, size_t max_depth)
+{
+    SCOPED_TRACE(src);
+    ParseStats stats = validate_json(src);
+    EXPECT_EQ(stats.num_nodes, num_nodes);
+    EXPECT_EQ(stats.arena_size, src.len);
+    EXPECT_EQ(stats.max_depth, max_depth);
+    EXPECT_EQ(stats.num_docs, 1u);
+    Tree t = parse_json(src);
+    EXPECT_EQ(t.size(), num_nodes);
+}
+
+TEST(validate, yaml)
+{
+    check_stats("", 1, 1, 0);
+    check_stats("a: 1\nb: 2\n", 3, 2, 1);
+    check_stats("a:\n  b:\n    - c\n    - [d, {e: f}]\n", 8, 6, 1);
+    check_stats("{a: [1, 2, 3], b: {c: [4, [5]]}}", 10, 5, 1);
+    check_stats("--- a\n--- b\n---\n- c\n", 5, 3, 3);
+    check_stats("a: 1\n---\nb: 2\n", 5, 3, 2);
+}
+
+TEST(validate, json)
+{
+    check_json_stats("1", 1, 1);
+    check_json_stats("[]", 1, 1);
+    check_json_stats(R"({"a": [1, 2, 3], "b": {"c": [4, [5]]}, "d": "e\tf"})", 11, 5);
+    check_json_stats("[[[[[[[[[[0]]]]]]]]]]", 11, 11);
+}
+
+TEST(validate, reserve_exactly)
+{
+    std::string yaml, json = "[";
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        std::string n = std::to_string(i);
+        yaml += "key" + n + ": {a: " + n + ", b: [\"x\\ty\", 'it''s']}\n";
+        json += (i ? ", " : "") + std::string("{\"a\": ") + n + ", \"b\": [\"x\\ty\", \"z\"]}";
+    }
+    json += "]";
+    Validator v;
+    {
+        ParseStats stats = v.validate(to_csubstr(yaml));
+        Tree t;
+        stats.reserve(&t);
+        const size_t cap = t.capacity(), arena_cap = t.arena_capacity();
+        parse(to_csubstr(yaml), &t);
+        EXPECT_EQ(t.size(), stats.num_nodes);
+        EXPECT_EQ(t.capacity(), cap);
+        EXPECT_EQ(t.arena_capacity(), arena_cap);
+        EXPECT_EQ(t.arena_size(), stats.arena_size);
+    }
+    {
+        ParseStats stats = v.validate_json(to_csubstr(json));
+        Tree t;
+        stats.reserve(&t);
+        const size_t cap = t.capacity(), arena_cap = t.arena_capacity();
+        parse_json(to_csubstr(json), &t);
+        EXPECT_EQ(t.size(), stats.num_nodes);
+        EXPECT_EQ(t.capacity(), cap);
+        EXPECT_EQ(t.arena_capacity(), arena_cap);
+        EXPECT_EQ(t.arena_size(), stats.arena_size);
+    }
+}
+
+TEST(validate, num_nodes_is_the_peak)
+{
+    // the parser removes the node it started for a map entry in a
+    // flow seq before claiming the entry's map
+    std::string yaml = "[";
+    for(size_t i = 0; i < 100; ++i)
+        yaml += (i ? ", " : "") + std::string("a") + std::to_string(i) + ": b";
+    yaml += "]";
+    Validator v;
+    ParseStats stats = v.validate(to_csubstr(yaml));
+    Tree t;
+    stats.reserve(&t);
+    const size_t cap = t.capacity();
+    parse(to_csubstr(yaml), &t);
+    EXPECT_GE(stats.num_nodes, t.size());
+    EXPECT_EQ(stats.num_nodes, t.peak_size());
+    EXPECT_EQ(t.capacity(), cap);
+}
+
+TEST(validate, source_is_not_modified)
+{
+    std::string json = R"(["a\tb", "c\u00e9"])";
+    const std::string orig = json;
+    validate_json(to_csubstr(json));
+    EXPECT_EQ(json, orig);
+}
+
+TEST(validate, errors)
+{
+    Location loc = {};
+    loc.line = 2;
+    loc.col = 4;
+    ExpectError::do_check([&](){
+        validate("a: 1\n  b: 2\n");
+    }, loc);
+    loc.line = 1;
+    loc.col = 7;
+    ExpectError::do_check([&](){
+        validate_json("[1, 2 3]");
+    }, loc);
+}
+
+//-------------------------------------------
+// this is needed to use the test case library
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4